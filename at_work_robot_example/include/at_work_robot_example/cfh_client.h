@@ -0,0 +1,332 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_CFH_CLIENT_H
+#define AT_WORK_ROBOT_EXAMPLE_CFH_CLIENT_H
+
+#include <at_work_robot_example/udp_sockets.h>
+
+#include <protobuf_comm/peer.h>
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+namespace rockin_msgs
+{
+    class BeaconSignal;
+}
+
+/**
+ * Client for the RoCKIn@Work Central Factory Hub.
+ *
+ * Owns the public and team peers, fills in the beacon and dispatches the
+ * received messages to callbacks which get the decoded protobuf messages.
+ * robot_example_ros and its fleet gateway run on it as well as the
+ * headless robot_example.
+ *
+ * By default the callbacks run on the socket thread of the peer which
+ * received the message, so they should return quickly. With onReceive the
+ * messages are handed over instead, e.g. to be queued for another thread
+ * which then calls dispatch().
+ *
+ * start(), stop(), send() and the socket accessors are not synchronized
+ * with each other, callers which use them from several threads hold their
+ * own lock.
+ */
+class CFHClient
+{
+    public:
+        enum Channel
+        {
+            PUBLIC,
+            TEAM
+        };
+
+        /**
+         * Connection parameters, the defaults match the ROS example.
+         */
+        struct Config
+        {
+            /**
+             * Ctor.
+             */
+            Config();
+
+            /**
+             * True if the refbox is running on another machine.
+             */
+            bool remote_refbox;
+
+            std::string host_name;
+
+            /**
+             * Ports when the refbox is running on another machine.
+             */
+            unsigned short public_port;
+
+            unsigned short team_port;
+
+            /**
+             * Ports when the refbox is running on the same machine.
+             */
+            unsigned short public_send_port;
+
+            unsigned short public_recv_port;
+
+            unsigned short team_send_port;
+
+            unsigned short team_recv_port;
+
+            std::string robot_name;
+
+            /**
+             * Team name as specified in the refbox configuration.
+             */
+            std::string team_name;
+
+            /**
+             * Key and cipher of the team channel, which is sent in plaintext
+             * if the key is empty. Must match the team's entry in the refbox
+             * configuration.
+             */
+            std::string crypto_key;
+
+            std::string cipher;
+
+            /**
+             * False leaves out a peer, e.g. when a gateway receives the
+             * public broadcasts for several robots.
+             */
+            bool public_peer;
+
+            bool team_peer;
+
+            /**
+             * Socket buffer sizes in bytes, zero keeps the kernel default.
+             */
+            int socket_receive_buffer;
+
+            int socket_send_buffer;
+        };
+
+        typedef std::function<void (const std::string &)> ErrorHandler;
+
+        typedef std::function<void (Channel channel, uint16_t component_id, uint16_t msg_type,
+                                    const std::shared_ptr<google::protobuf::Message> &msg)> ReceiveHandler;
+
+        /**
+         * Ctor.
+         *
+         * Registers all message types known to the refbox, the peers are
+         * created by start().
+         */
+        explicit CFHClient(const Config &config);
+
+        /**
+         * Dtor.
+         */
+        ~CFHClient();
+
+        /**
+         * Add MT to the message register unless it is already known.
+         *
+         * Must be called before start().
+         */
+        template <class MT>
+        void registerMessageType()
+        {
+            if (registered_types_.insert(messageKey(MT::COMP_ID, MT::MSG_TYPE)).second) {
+                message_register_.add_message_type<MT>();
+            }
+        }
+
+        /**
+         * Set the handler dispatch() calls for each message of type MT.
+         *
+         * Must be called before start().
+         */
+        template <class MT>
+        void onMessage(const std::function<void (const MT &)> &handler)
+        {
+            registerMessageType<MT>();
+
+            //the register creates an MT for this key, so the downcast is safe
+            handlers_[messageKey(MT::COMP_ID, MT::MSG_TYPE)] =
+                [handler](const google::protobuf::Message &msg) {
+                    handler(static_cast<const MT &>(msg));
+                };
+        }
+
+        /**
+         * Hand the received messages to handler on the socket threads
+         * instead of dispatching them there.
+         *
+         * Must be called before start().
+         */
+        void onReceive(const ReceiveHandler &handler);
+
+        /**
+         * Set the handlers for send and receive errors of both peers.
+         *
+         * Receive errors include datagrams which cannot be decoded, e.g.
+         * other teams' encrypted traffic on the public channel.
+         */
+        void onSendError(const ErrorHandler &handler);
+
+        void onReceiveError(const ErrorHandler &handler);
+
+        /**
+         * Create the peers, replacing those of an earlier start(), look up
+         * their sockets and start receiving.
+         *
+         * Throws if a peer cannot be created, no peer is left then.
+         */
+        void start();
+
+        /**
+         * Destroy the peers, which stops their socket threads.
+         */
+        void stop();
+
+        /**
+         * Fill in the time, names and next sequence number of a beacon.
+         */
+        void fillBeacon(rockin_msgs::BeaconSignal &signal);
+
+        /**
+         * Send the beacon signal over the team peer.
+         */
+        void sendBeacon();
+
+        /**
+         * Send a message over the team peer, dropped while there is none.
+         */
+        void send(google::protobuf::Message &msg);
+
+        /**
+         * Call the handler set for the message's type.
+         *
+         * Returns false and counts the message as unhandled if there is
+         * none.
+         */
+        bool dispatch(uint16_t component_id, uint16_t msg_type,
+                      const google::protobuf::Message &msg);
+
+        /**
+         * Number of received messages for which no handler is set.
+         */
+        unsigned long unhandledMessageCount() const;
+
+        /**
+         * Message types known to the peers, e.g. to decode captured traffic.
+         */
+        protobuf_comm::MessageRegister &messageRegister();
+
+        /**
+         * Sockets of the peers of the last start(), empty without a peer.
+         */
+        const UdpSockets &publicSockets() const;
+
+        const UdpSockets &teamSockets() const;
+
+        /**
+         * Why the sockets of the last start() could not be looked up or
+         * sized, empty if they were.
+         */
+        const std::string &socketError() const;
+
+        const Config &config() const;
+
+        /**
+         * Key of the dispatch table for a (component_id, msg_type) pair.
+         */
+        static uint32_t messageKey(uint16_t component_id, uint16_t msg_type);
+
+    private:
+        /**
+         * Copy Ctor.
+         */
+        CFHClient(const CFHClient &other);
+
+        /**
+         * Assignment operator
+         */
+        CFHClient &operator=(const CFHClient &other);
+
+        typedef std::function<void (const google::protobuf::Message &)> MessageHandler;
+
+        /**
+         * Create one peer, either for a remote refbox or for one on the
+         * same machine.
+         */
+        std::shared_ptr<protobuf_comm::ProtobufBroadcastPeer> createPeer(unsigned short port,
+                                                                         unsigned short send_port,
+                                                                         unsigned short recv_port);
+
+        /**
+         * Bind the signals of a peer to the handlers of its channel.
+         */
+        void connectPeer(protobuf_comm::ProtobufBroadcastPeer &peer, Channel channel);
+
+        /**
+         * Take the sockets of a peer just created, the new ones bound to
+         * port, and set their buffer sizes.
+         */
+        void tuneSockets(UdpSockets &sockets, const char *name, unsigned short port,
+                         const std::vector<unsigned long> &existing_sockets);
+
+        void handleMessage(Channel channel, boost::asio::ip::udp::endpoint &sender,
+                           uint16_t component_id, uint16_t msg_type,
+                           std::shared_ptr<google::protobuf::Message> msg);
+
+        void handleSendError(std::string msg);
+
+        void handleReceiveError(boost::asio::ip::udp::endpoint &endpoint,
+                                std::string msg);
+
+        Config config_;
+
+        /**
+         * Shared by both peers.
+         */
+        protobuf_comm::MessageRegister message_register_;
+
+        std::set<uint32_t> registered_types_;
+
+        /**
+         * Handlers keyed by messageKey(component_id, msg_type), read-only
+         * after start().
+         */
+        std::unordered_map<uint32_t, MessageHandler> handlers_;
+
+        ReceiveHandler receive_handler_;
+
+        ErrorHandler send_error_handler_;
+
+        ErrorHandler receive_error_handler_;
+
+        std::shared_ptr<protobuf_comm::ProtobufBroadcastPeer> peer_public_;
+
+        std::shared_ptr<protobuf_comm::ProtobufBroadcastPeer> peer_team_;
+
+        UdpSockets public_sockets_;
+
+        UdpSockets team_sockets_;
+
+        std::string socket_error_;
+
+        /**
+         * Sequence number of the last beacon.
+         */
+        unsigned long seq_;
+
+        std::mutex beacon_mutex_;
+
+        std::atomic<unsigned long> unhandled_message_count_;
+};
+
+#endif
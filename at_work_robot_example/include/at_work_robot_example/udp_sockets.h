@@ -0,0 +1,99 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_UDP_SOCKETS_H
+#define AT_WORK_ROBOT_EXAMPLE_UDP_SOCKETS_H
+
+#include <stddef.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * The UDP sockets of one peer of this process.
+ *
+ * protobuf_comm does not expose the sockets of its peers, so they are
+ * taken where the peer is constructed: the sockets of the process are
+ * listed right before, and afterwards the new UDP sockets bound to the
+ * peer's port are the peer's, even if other peers share the port. Sockets
+ * are told apart by their inode from fstat, so a descriptor reused
+ * meanwhile is not mistaken for a new socket.
+ *
+ * The kernel's counters of the sockets, among them the datagrams dropped
+ * because the receive buffer was full, are read with SO_MEMINFO. Linux
+ * only.
+ */
+class UdpSockets
+{
+    public:
+        struct Statistics
+        {
+            size_t sockets;
+
+            /**
+             * Datagrams the kernel dropped, summed over the sockets.
+             */
+            unsigned long drops;
+
+            /**
+             * Bytes waiting in the receive buffers.
+             */
+            unsigned long receive_queue;
+
+            /**
+             * Buffer sizes in bytes as reported by the kernel, which
+             * counts its bookkeeping as well, of the first socket.
+             */
+            int receive_buffer;
+
+            int send_buffer;
+        };
+
+        /**
+         * Ctor.
+         */
+        UdpSockets();
+
+        /**
+         * Take the sockets bound to port which are not in existing, returns
+         * false if there are none.
+         */
+        bool find(unsigned short port, const std::vector<unsigned long> &existing);
+
+        /**
+         * Inodes of all sockets of this process.
+         */
+        static std::vector<unsigned long> existingSockets();
+
+        /**
+         * Held from existingSockets() until the new peer was looked up, so
+         * that no other peer opens sockets meanwhile.
+         */
+        static std::mutex &creationMutex();
+
+        /**
+         * Set the buffer sizes in bytes of all sockets, zero keeps a size.
+         *
+         * Sizes above net.core.rmem_max and wmem_max need CAP_NET_ADMIN,
+         * returns false if the kernel granted less than asked for.
+         */
+        bool setBufferSizes(int receive_buffer, int send_buffer);
+
+        Statistics statistics() const;
+
+        unsigned short port() const;
+
+        const std::string &error() const;
+
+    private:
+        /**
+         * Set one buffer, forcing it beyond the system limit if allowed.
+         */
+        bool setBufferSize(int fd, int option, int force_option, int size);
+
+        unsigned short port_;
+
+        std::vector<int> fds_;
+
+        std::string error_;
+};
+
+#endif
@@ -0,0 +1,284 @@
+#include <at_work_robot_example/cfh_client.h>
+
+#include <rockin_msgs/AttentionMessage.pb.h>
+#include <rockin_msgs/BeaconSignal.pb.h>
+#include <rockin_msgs/BenchmarkState.pb.h>
+#include <rockin_msgs/BenchmarkFeedback.pb.h>
+#include <rockin_msgs/ConveyorBelt.pb.h>
+#include <rockin_msgs/DrillingMachine.pb.h>
+#include <rockin_msgs/Inventory.pb.h>
+#include <rockin_msgs/Order.pb.h>
+#include <rockin_msgs/RobotInfo.pb.h>
+#include <rockin_msgs/Time.pb.h>
+#include <rockin_msgs/VersionInfo.pb.h>
+
+#include <boost/bind.hpp>
+
+#include <time.h>
+
+using namespace protobuf_comm;
+using namespace rockin_msgs;
+
+CFHClient::Config::Config():
+    remote_refbox(false),
+    host_name("localhost"),
+    public_port(4444),
+    team_port(4452),
+    public_send_port(4445),
+    public_recv_port(4444),
+    team_send_port(4453),
+    team_recv_port(4452),
+    robot_name("spqr"),
+    team_name("SPQR"),
+    cipher("aes-128-cbc"),
+    public_peer(true),
+    team_peer(true),
+    socket_receive_buffer(0),
+    socket_send_buffer(0)
+{
+}
+
+CFHClient::CFHClient(const Config &config):
+    config_(config),
+    peer_public_(NULL),
+    peer_team_(NULL),
+    seq_(0),
+    unhandled_message_count_(0)
+{
+    //all types the refbox and the robots broadcast
+    registerMessageType<AttentionMessage>();
+    registerMessageType<BeaconSignal>();
+    registerMessageType<BenchmarkState>();
+    registerMessageType<BenchmarkFeedback>();
+    registerMessageType<Inventory>();
+    registerMessageType<OrderInfo>();
+    registerMessageType<RobotInfo>();
+    registerMessageType<VersionInfo>();
+    registerMessageType<DrillingMachineStatus>();
+    registerMessageType<TriggeredConveyorBeltStatus>();
+    registerMessageType<DrillingMachineCommand>();
+    registerMessageType<TriggeredConveyorBeltCommand>();
+}
+
+CFHClient::~CFHClient()
+{
+    //stop the socket threads before the handlers go away
+    stop();
+}
+
+void CFHClient::onReceive(const ReceiveHandler &handler)
+{
+    receive_handler_ = handler;
+}
+
+void CFHClient::onSendError(const ErrorHandler &handler)
+{
+    send_error_handler_ = handler;
+}
+
+void CFHClient::onReceiveError(const ErrorHandler &handler)
+{
+    receive_error_handler_ = handler;
+}
+
+void CFHClient::start()
+{
+    stop();
+
+    //a peer's socket is the new one on its port, other clients in this process may bind the same port
+    std::lock_guard<std::mutex> sockets_lock(UdpSockets::creationMutex());
+
+    try {
+        if (config_.public_peer) {
+            std::vector<unsigned long> existing_sockets = UdpSockets::existingSockets();
+
+            peer_public_ = createPeer(config_.public_port, config_.public_send_port,
+                                      config_.public_recv_port);
+
+            tuneSockets(public_sockets_, "public socket",
+                        config_.remote_refbox ? config_.public_port : config_.public_recv_port,
+                        existing_sockets);
+        }
+
+        if (config_.team_peer) {
+            std::vector<unsigned long> existing_sockets = UdpSockets::existingSockets();
+
+            peer_team_ = createPeer(config_.team_port, config_.team_send_port,
+                                    config_.team_recv_port);
+
+            tuneSockets(team_sockets_, "team socket",
+                        config_.remote_refbox ? config_.team_port : config_.team_recv_port,
+                        existing_sockets);
+
+            if (!config_.crypto_key.empty()) {
+                peer_team_->setup_crypto(config_.crypto_key, config_.cipher);
+            }
+        }
+    } catch (...) {
+        stop();
+        throw;
+    }
+
+    if (peer_public_) {
+        connectPeer(*peer_public_, PUBLIC);
+    }
+
+    if (peer_team_) {
+        connectPeer(*peer_team_, TEAM);
+    }
+}
+
+void CFHClient::stop()
+{
+    peer_public_.reset();
+    peer_team_.reset();
+
+    public_sockets_ = UdpSockets();
+    team_sockets_ = UdpSockets();
+    socket_error_.clear();
+}
+
+std::shared_ptr<ProtobufBroadcastPeer> CFHClient::createPeer(unsigned short port,
+                                                             unsigned short send_port,
+                                                             unsigned short recv_port)
+{
+    if (config_.remote_refbox) {
+        //ref box is running on remote machine.
+        return std::shared_ptr<ProtobufBroadcastPeer>(
+                    new ProtobufBroadcastPeer(config_.host_name, port, &message_register_));
+    }
+
+    //ref box is running on same machine as client.
+    return std::shared_ptr<ProtobufBroadcastPeer>(
+                new ProtobufBroadcastPeer(config_.host_name, send_port, recv_port, &message_register_));
+}
+
+void CFHClient::connectPeer(ProtobufBroadcastPeer &peer, Channel channel)
+{
+    peer.signal_received().connect(boost::bind(&CFHClient::handleMessage, this, channel, _1, _2, _3, _4));
+    peer.signal_send_error().connect(boost::bind(&CFHClient::handleSendError, this, _1));
+    peer.signal_recv_error().connect(boost::bind(&CFHClient::handleReceiveError, this, _1, _2));
+}
+
+void CFHClient::tuneSockets(UdpSockets &sockets, const char *name, unsigned short port,
+                            const std::vector<unsigned long> &existing_sockets)
+{
+    if (sockets.find(port, existing_sockets)
+        && sockets.setBufferSizes(config_.socket_receive_buffer, config_.socket_send_buffer)) {
+        return;
+    }
+
+    if (!socket_error_.empty()) {
+        socket_error_ += ", ";
+    }
+    socket_error_ += std::string(name) + ": " + sockets.error();
+}
+
+void CFHClient::fillBeacon(BeaconSignal &signal)
+{
+    //generate the timestamp
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    Time *time = signal.mutable_time();
+    time->set_sec(now.tv_sec);
+    time->set_nsec(now.tv_nsec);
+
+    signal.set_peer_name(config_.robot_name);
+    signal.set_team_name(config_.team_name);
+
+    std::lock_guard<std::mutex> lock(beacon_mutex_);
+    signal.set_seq(++seq_);
+}
+
+void CFHClient::sendBeacon()
+{
+    BeaconSignal signal;
+    fillBeacon(signal);
+
+    send(signal);
+}
+
+void CFHClient::send(google::protobuf::Message &msg)
+{
+    if (peer_team_) {
+        peer_team_->send(msg);
+    }
+}
+
+bool CFHClient::dispatch(uint16_t component_id, uint16_t msg_type,
+                         const google::protobuf::Message &msg)
+{
+    std::unordered_map<uint32_t, MessageHandler>::const_iterator handler =
+                                handlers_.find(messageKey(component_id, msg_type));
+
+    if (handler == handlers_.end()) {
+        ++unhandled_message_count_;
+        return false;
+    }
+
+    handler->second(msg);
+
+    return true;
+}
+
+unsigned long CFHClient::unhandledMessageCount() const
+{
+    return unhandled_message_count_;
+}
+
+MessageRegister &CFHClient::messageRegister()
+{
+    return message_register_;
+}
+
+const UdpSockets &CFHClient::publicSockets() const
+{
+    return public_sockets_;
+}
+
+const UdpSockets &CFHClient::teamSockets() const
+{
+    return team_sockets_;
+}
+
+const std::string &CFHClient::socketError() const
+{
+    return socket_error_;
+}
+
+const CFHClient::Config &CFHClient::config() const
+{
+    return config_;
+}
+
+uint32_t CFHClient::messageKey(uint16_t component_id, uint16_t msg_type)
+{
+    return (static_cast<uint32_t>(component_id) << 16) | msg_type;
+}
+
+void CFHClient::handleMessage(Channel channel, boost::asio::ip::udp::endpoint &sender,
+                              uint16_t component_id, uint16_t msg_type,
+                              std::shared_ptr<google::protobuf::Message> msg)
+{
+    if (receive_handler_) {
+        receive_handler_(channel, component_id, msg_type, msg);
+    } else {
+        dispatch(component_id, msg_type, *msg);
+    }
+}
+
+void CFHClient::handleSendError(std::string msg)
+{
+    if (send_error_handler_) {
+        send_error_handler_(msg);
+    }
+}
+
+void CFHClient::handleReceiveError(boost::asio::ip::udp::endpoint &endpoint,
+                                   std::string msg)
+{
+    if (receive_error_handler_) {
+        receive_error_handler_(msg);
+    }
+}
@@ -0,0 +1,163 @@
+#include <at_work_robot_example/cfh_client.h>
+
+#include <rockin_msgs/AttentionMessage.pb.h>
+#include <rockin_msgs/BenchmarkState.pb.h>
+#include <rockin_msgs/ConveyorBelt.pb.h>
+#include <rockin_msgs/DrillingMachine.pb.h>
+#include <rockin_msgs/Inventory.pb.h>
+#include <rockin_msgs/Order.pb.h>
+
+#include <getopt.h>
+#include <signal.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+namespace
+{
+  volatile sig_atomic_t running = 1;
+
+  void handleSignal(int)
+  {
+    running = 0;
+  }
+
+  void usage(const char *program)
+  {
+    printf("Usage: %s [options]\n"
+           "  --remote-refbox          refbox runs on another machine\n"
+           "  --host-name NAME         broadcast address (default localhost)\n"
+           "  --public-port PORT       public port of a remote refbox (default 4444)\n"
+           "  --team-port PORT         team port of a remote refbox (default 4452)\n"
+           "  --refbox-send-port PORT  port a local refbox sends on (default 4444)\n"
+           "  --refbox-recv-port PORT  port a local refbox receives on (default 4445)\n"
+           "  --team-send-port PORT    team send port for a local refbox (default 4453)\n"
+           "  --team-recv-port PORT    team receive port for a local refbox (default 4452)\n"
+           "  --robot-name NAME        (default spqr)\n"
+           "  --team-name NAME         team name in the refbox configuration (default SPQR)\n"
+           "  --crypto-key KEY         encrypt the team channel with KEY (default plaintext)\n"
+           "  --cipher NAME            cipher of the team channel (default aes-128-cbc)\n"
+           "  --beacon-period SECONDS  (default 0.1)\n",
+           program);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  static const struct option options[] = {
+    {"remote-refbox",    no_argument,       NULL, 'r'},
+    {"host-name",        required_argument, NULL, 'h'},
+    {"public-port",      required_argument, NULL, 'p'},
+    {"team-port",        required_argument, NULL, 't'},
+    {"refbox-send-port", required_argument, NULL, 'S'},
+    {"refbox-recv-port", required_argument, NULL, 'R'},
+    {"team-send-port",   required_argument, NULL, 's'},
+    {"team-recv-port",   required_argument, NULL, 'c'},
+    {"robot-name",       required_argument, NULL, 'n'},
+    {"team-name",        required_argument, NULL, 'T'},
+    {"crypto-key",       required_argument, NULL, 'k'},
+    {"cipher",           required_argument, NULL, 'C'},
+    {"beacon-period",    required_argument, NULL, 'b'},
+    {"help",             no_argument,       NULL, '?'},
+    {NULL, 0, NULL, 0}
+  };
+
+  CFHClient::Config config;
+  double beacon_period = 0.1;
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "", options, NULL)) != -1) {
+    switch (opt) {
+      case 'r': config.remote_refbox = true; break;
+      case 'h': config.host_name = optarg; break;
+      case 'p': config.public_port = atoi(optarg); break;
+      case 't': config.team_port = atoi(optarg); break;
+      case 'S': config.public_recv_port = atoi(optarg); break;
+      case 'R': config.public_send_port = atoi(optarg); break;
+      case 's': config.team_send_port = atoi(optarg); break;
+      case 'c': config.team_recv_port = atoi(optarg); break;
+      case 'n': config.robot_name = optarg; break;
+      case 'T': config.team_name = optarg; break;
+      case 'k': config.crypto_key = optarg; break;
+      case 'C': config.cipher = optarg; break;
+      case 'b': beacon_period = atof(optarg); break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+
+  {
+    CFHClient client(config);
+
+    client.onSendError([](const std::string &msg) {
+        fprintf(stderr, "Send error: %s\n", msg.c_str());
+      });
+
+    client.onReceiveError([](const std::string &msg) {
+        fprintf(stderr, "Recv error: %s\n", msg.c_str());
+      });
+
+    client.onMessage(std::function<void (const rockin_msgs::BenchmarkState &)>(
+      [](const rockin_msgs::BenchmarkState &benchmark_state) {
+        printf("BenchmarkState: state %d phase %d scenario %d/%u time %lld.%09lld\n",
+               benchmark_state.state(), benchmark_state.phase(),
+               benchmark_state.scenario().type(), benchmark_state.scenario().type_id(),
+               (long long)benchmark_state.benchmark_time().sec(),
+               (long long)benchmark_state.benchmark_time().nsec());
+      }));
+
+    client.onMessage(std::function<void (const rockin_msgs::AttentionMessage &)>(
+      [](const rockin_msgs::AttentionMessage &attention) {
+        printf("AttentionMessage: %s\n", attention.message().c_str());
+      }));
+
+    client.onMessage(std::function<void (const rockin_msgs::Inventory &)>(
+      [](const rockin_msgs::Inventory &inventory) {
+        printf("Inventory: %d items\n", inventory.items_size());
+      }));
+
+    client.onMessage(std::function<void (const rockin_msgs::OrderInfo &)>(
+      [](const rockin_msgs::OrderInfo &order_info) {
+        printf("OrderInfo: %d orders\n", order_info.orders_size());
+      }));
+
+    client.onMessage(std::function<void (const rockin_msgs::DrillingMachineStatus &)>(
+      [](const rockin_msgs::DrillingMachineStatus &status) {
+        printf("DrillingMachineStatus: state %d\n", status.state());
+      }));
+
+    client.onMessage(std::function<void (const rockin_msgs::TriggeredConveyorBeltStatus &)>(
+      [](const rockin_msgs::TriggeredConveyorBeltStatus &status) {
+        printf("TriggeredConveyorBeltStatus: state %d cycle %u\n", status.state(), status.cycle());
+      }));
+
+    signal(SIGINT, handleSignal);
+    signal(SIGTERM, handleSignal);
+
+    client.start();
+
+    if (!client.socketError().empty()) {
+      fprintf(stderr, "%s\n", client.socketError().c_str());
+    }
+
+    printf("CFH Robot example is running!\n");
+
+    std::chrono::steady_clock::time_point next_beacon = std::chrono::steady_clock::now();
+    const std::chrono::microseconds period(static_cast<long>(beacon_period * 1e6));
+
+    while (running) {
+      client.sendBeacon();
+
+      next_beacon += period;
+      std::this_thread::sleep_until(next_beacon);
+    }
+  }
+
+  // Delete all global objects allocated by libprotobuf
+  google::protobuf::ShutdownProtobufLibrary();
+
+  return 0;
+}
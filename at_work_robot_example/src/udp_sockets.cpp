@@ -0,0 +1,206 @@
+#include <at_work_robot_example/udp_sockets.h>
+
+#include <linux/sock_diag.h>
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+    /**
+     * Unused descriptors after which the scan stops. New descriptors take
+     * the lowest unused numbers, so a peer's socket is among the first.
+     */
+    const int MAX_UNUSED_DESCRIPTORS = 64;
+
+    /**
+     * Descriptors and inodes of the sockets of this process.
+     */
+    void listSockets(std::vector<int> &fds, std::vector<unsigned long> &inodes)
+    {
+        int unused = 0;
+
+        for (int fd = 0; unused < MAX_UNUSED_DESCRIPTORS; fd++) {
+            struct stat status;
+
+            if (fstat(fd, &status) != 0) {
+                ++unused;
+                continue;
+            }
+
+            if (S_ISSOCK(status.st_mode)) {
+                fds.push_back(fd);
+                inodes.push_back(status.st_ino);
+            }
+        }
+    }
+
+    /**
+     * Local port of a UDP socket, zero for other sockets.
+     */
+    unsigned short udpPort(int fd)
+    {
+        int type = 0;
+        socklen_t length = sizeof(type);
+        if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &length) != 0 || type != SOCK_DGRAM) {
+            return 0;
+        }
+
+        sockaddr_storage address;
+        length = sizeof(address);
+        if (getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length) != 0) {
+            return 0;
+        }
+
+        if (address.ss_family == AF_INET) {
+            return ntohs(reinterpret_cast<sockaddr_in *>(&address)->sin_port);
+        }
+        if (address.ss_family == AF_INET6) {
+            return ntohs(reinterpret_cast<sockaddr_in6 *>(&address)->sin6_port);
+        }
+
+        return 0;
+    }
+}
+
+UdpSockets::UdpSockets():
+    port_(0)
+{
+}
+
+bool UdpSockets::find(unsigned short port, const std::vector<unsigned long> &existing)
+{
+    port_ = port;
+    fds_.clear();
+
+    std::vector<int> fds;
+    std::vector<unsigned long> inodes;
+    listSockets(fds, inodes);
+
+    for (size_t i = 0; i < fds.size(); i++) {
+        if (std::find(existing.begin(), existing.end(), inodes[i]) == existing.end()
+            && udpPort(fds[i]) == port) {
+            fds_.push_back(fds[i]);
+        }
+    }
+
+    if (fds_.empty()) {
+        std::ostringstream error;
+        error << "no new UDP socket bound to port " << port;
+        error_ = error.str();
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<unsigned long> UdpSockets::existingSockets()
+{
+    std::vector<int> fds;
+    std::vector<unsigned long> inodes;
+
+    listSockets(fds, inodes);
+
+    return inodes;
+}
+
+std::mutex &UdpSockets::creationMutex()
+{
+    static std::mutex mutex;
+
+    return mutex;
+}
+
+bool UdpSockets::setBufferSizes(int receive_buffer, int send_buffer)
+{
+    bool granted = true;
+
+    for (size_t i = 0; i < fds_.size(); i++) {
+        if (receive_buffer > 0) {
+            granted = setBufferSize(fds_[i], SO_RCVBUF, SO_RCVBUFFORCE, receive_buffer) && granted;
+        }
+        if (send_buffer > 0) {
+            granted = setBufferSize(fds_[i], SO_SNDBUF, SO_SNDBUFFORCE, send_buffer) && granted;
+        }
+    }
+
+    return granted;
+}
+
+bool UdpSockets::setBufferSize(int fd, int option, int force_option, int size)
+{
+    //without CAP_NET_ADMIN the kernel caps the size at its limit
+    if (setsockopt(fd, SOL_SOCKET, force_option, &size, sizeof(size)) != 0
+        && setsockopt(fd, SOL_SOCKET, option, &size, sizeof(size)) != 0) {
+        error_ = std::string("cannot set the socket buffer: ") + strerror(errno);
+        return false;
+    }
+
+    //the kernel reports twice the size, half of it for its bookkeeping
+    int granted = 0;
+    socklen_t length = sizeof(granted);
+    getsockopt(fd, SOL_SOCKET, option, &granted, &length);
+
+    if (granted / 2 < size) {
+        std::ostringstream error;
+        error << "the kernel granted a " << (option == SO_RCVBUF ? "receive" : "send")
+              << " buffer of " << granted / 2
+              << " instead of " << size << " bytes, raise net.core."
+              << (option == SO_RCVBUF ? "rmem_max" : "wmem_max");
+        error_ = error.str();
+        return false;
+    }
+
+    return true;
+}
+
+UdpSockets::Statistics UdpSockets::statistics() const
+{
+    Statistics stats;
+
+    stats.sockets = fds_.size();
+    stats.drops = 0;
+    stats.receive_queue = 0;
+    stats.receive_buffer = 0;
+    stats.send_buffer = 0;
+
+    for (size_t i = 0; i < fds_.size(); i++) {
+        uint32_t meminfo[SK_MEMINFO_VARS];
+        socklen_t length = sizeof(meminfo);
+
+        //kernels before 4.6 do not have it, the counters stay zero then
+        if (getsockopt(fds_[i], SOL_SOCKET, SO_MEMINFO, meminfo, &length) != 0
+            || length < sizeof(meminfo)) {
+            continue;
+        }
+
+        stats.drops += meminfo[SK_MEMINFO_DROPS];
+        stats.receive_queue += meminfo[SK_MEMINFO_RMEM_ALLOC];
+    }
+
+    if (!fds_.empty()) {
+        socklen_t length = sizeof(int);
+        getsockopt(fds_[0], SOL_SOCKET, SO_RCVBUF, &stats.receive_buffer, &length);
+        length = sizeof(int);
+        getsockopt(fds_[0], SOL_SOCKET, SO_SNDBUF, &stats.send_buffer, &length);
+    }
+
+    return stats;
+}
+
+unsigned short UdpSockets::port() const
+{
+    return port_;
+}
+
+const std::string &UdpSockets::error() const
+{
+    return error_;
+}
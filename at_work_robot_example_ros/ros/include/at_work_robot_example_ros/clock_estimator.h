@@ -0,0 +1,97 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_CLOCK_ESTIMATOR_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_CLOCK_ESTIMATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <utility>
+
+/**
+ * Estimates the offset of a remote clock from timestamped messages.
+ *
+ * Each sample is the local receive time minus the remote send time, which
+ * is the clock offset plus the one-way delay of the message. The smallest
+ * sample of a sliding window is taken as the offset, so the estimate
+ * includes the smallest delay of the window: with one-way messages only,
+ * offset and delay cannot be told apart. The delay of a message beyond the
+ * smallest one and the interarrival jitter of RFC 3550 are estimated as
+ * well.
+ *
+ * All times are in nanoseconds. Not thread-safe.
+ */
+class ClockEstimator
+{
+    public:
+        struct Estimate
+        {
+            /**
+             * True once the window holds at least min_samples samples.
+             */
+            bool valid;
+
+            size_t samples;
+
+            /**
+             * Local minus remote time, including the smallest delay.
+             */
+            int64_t offset;
+
+            /**
+             * Delay of the last message beyond the smallest delay.
+             */
+            int64_t delay;
+
+            double jitter;
+        };
+
+        /**
+         * Ctor.
+         */
+        ClockEstimator();
+
+        /**
+         * Set the window size and the number of samples for a valid
+         * estimate, and drop all samples.
+         */
+        void configure(size_t window, size_t min_samples);
+
+        /**
+         * Add a message sent at remote_time and received at local_time.
+         *
+         * A remote time before the previous one means that the remote clock
+         * was reset, all earlier samples are dropped then.
+         */
+        void addSample(int64_t remote_time, int64_t local_time);
+
+        Estimate estimate() const;
+
+        /**
+         * Drop all samples.
+         */
+        void reset();
+
+    private:
+        size_t window_;
+
+        size_t min_samples_;
+
+        /**
+         * Number of samples added since the last reset.
+         */
+        uint64_t count_;
+
+        /**
+         * Increasing minima of the window with the number of their sample,
+         * the front is the smallest sample.
+         */
+        std::deque<std::pair<uint64_t, int64_t> > minima_;
+
+        int64_t last_remote_time_;
+
+        int64_t last_difference_;
+
+        double jitter_;
+};
+
+#endif
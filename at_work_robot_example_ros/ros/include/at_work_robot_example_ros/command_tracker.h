@@ -0,0 +1,82 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_COMMAND_TRACKER_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_COMMAND_TRACKER_H
+
+#include <chrono>
+
+/**
+ * Follows a machine command until the machine's status shows its effect.
+ *
+ * The command is resent every retry_timeout until a status shows that the
+ * machine accepted it, at most max_attempts times, and it times out when
+ * its effect does not show within timeout. Which status accepts or
+ * completes a command is up to the caller. Not thread-safe.
+ */
+class CommandTracker
+{
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        enum Event
+        {
+            NONE,
+            RESEND,
+            SUCCEEDED,
+            TIMED_OUT
+        };
+
+        /**
+         * Ctor.
+         */
+        CommandTracker();
+
+        /**
+         * Track a command which was just sent for the first time.
+         */
+        void start(Clock::time_point now, Clock::duration timeout,
+                   Clock::duration retry_timeout, unsigned max_attempts);
+
+        /**
+         * Stop tracking the command.
+         */
+        void cancel();
+
+        bool active() const;
+
+        /**
+         * Pass a machine status: accepted if it shows the command in progress,
+         * reached if it shows the command's effect. Returns SUCCEEDED once.
+         */
+        Event status(bool accepted, bool reached);
+
+        /**
+         * Check the timeouts. Returns RESEND if the command should be sent
+         * again, which counts as an attempt, and TIMED_OUT once.
+         */
+        Event poll(Clock::time_point now);
+
+        unsigned attempts() const;
+
+        /**
+         * Time since the command was first sent.
+         */
+        Clock::duration elapsed(Clock::time_point now) const;
+
+    private:
+        bool active_;
+
+        bool accepted_;
+
+        unsigned attempts_;
+
+        unsigned max_attempts_;
+
+        Clock::duration retry_timeout_;
+
+        Clock::time_point first_send_;
+
+        Clock::time_point last_send_;
+
+        Clock::time_point deadline_;
+};
+
+#endif
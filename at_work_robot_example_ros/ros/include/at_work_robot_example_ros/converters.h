@@ -0,0 +1,417 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_CONVERTERS_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_CONVERTERS_H
+
+#include <rockin_msgs/AttentionMessage.pb.h>
+#include <rockin_msgs/BenchmarkFeedback.pb.h>
+#include <rockin_msgs/BenchmarkState.pb.h>
+#include <rockin_msgs/ConveyorBelt.pb.h>
+#include <rockin_msgs/DrillingMachine.pb.h>
+#include <rockin_msgs/Inventory.pb.h>
+#include <rockin_msgs/LoggingStatus.pb.h>
+#include <rockin_msgs/Order.pb.h>
+#include <rockin_msgs/Pose3D.pb.h>
+#include <rockin_msgs/RobotStatusReport.pb.h>
+
+#include <at_work_robot_example_ros/AttentionMessage.h>
+#include <at_work_robot_example_ros/BenchmarkFeedback.h>
+#include <at_work_robot_example_ros/BenchmarkState.h>
+#include <at_work_robot_example_ros/DrillingMachineStatus.h>
+#include <at_work_robot_example_ros/Item.h>
+#include <at_work_robot_example_ros/LocationIdentifier.h>
+#include <at_work_robot_example_ros/LoggingStatus.h>
+#include <at_work_robot_example_ros/ObjectIdentifier.h>
+#include <at_work_robot_example_ros/Order.h>
+#include <at_work_robot_example_ros/RobotStatusReport.h>
+#include <at_work_robot_example_ros/Transaction.h>
+#include <at_work_robot_example_ros/TriggeredConveyorBeltStatus.h>
+#include <geometry_msgs/Pose.h>
+
+#include <google/protobuf/repeated_field.h>
+
+#include <vector>
+
+/**
+ * Conversions between the ROS messages of the bridge and the refbox's
+ * protobuf messages.
+ *
+ * Converter<RosMsg> is specialised for every message pair and names the
+ * protobuf type as Protobuf. toRos and toProtobuf pick the specialisation
+ * at compile time from the ROS argument, so a message without a converter
+ * does not compile instead of being copied field by field. Messages which
+ * only travel one way only convert in that direction. Both directions
+ * assign into the target, so a reused target keeps the capacity of its
+ * strings and vectors.
+ */
+namespace converters
+{
+    template <class RosMsg>
+    struct Converter;
+
+    template <>
+    struct Converter<at_work_robot_example_ros::ObjectIdentifier>
+    {
+        typedef rockin_msgs::ObjectIdentifier Protobuf;
+
+        static void toRos(const Protobuf &from, at_work_robot_example_ros::ObjectIdentifier &to)
+        {
+            to.type.data        = from.type();
+            to.type_id.data     = from.type_id();
+            to.instance_id.data = from.instance_id();
+            to.description.data = from.description();
+        }
+
+        static void toProtobuf(const at_work_robot_example_ros::ObjectIdentifier &from, Protobuf &to)
+        {
+            to.set_type(static_cast<rockin_msgs::ObjectIdentifier_ObjectType>(from.type.data));
+            to.set_type_id(from.type_id.data);
+            to.set_instance_id(from.instance_id.data);
+            to.set_description(from.description.data);
+        }
+
+        static bool equal(const Protobuf &pb, const at_work_robot_example_ros::ObjectIdentifier &ros)
+        {
+            return ros.type.data == static_cast<uint64_t>(pb.type())
+                && ros.type_id.data == static_cast<uint64_t>(pb.type_id())
+                && ros.instance_id.data == static_cast<uint64_t>(pb.instance_id())
+                && ros.description.data == pb.description();
+        }
+    };
+
+    template <>
+    struct Converter<at_work_robot_example_ros::LocationIdentifier>
+    {
+        typedef rockin_msgs::LocationIdentifier Protobuf;
+
+        static void toRos(const Protobuf &from, at_work_robot_example_ros::LocationIdentifier &to)
+        {
+            to.type.data        = from.type();
+            to.instance_id.data = from.instance_id();
+            to.description.data = from.description();
+        }
+
+        static void toProtobuf(const at_work_robot_example_ros::LocationIdentifier &from, Protobuf &to)
+        {
+            to.set_type(static_cast<rockin_msgs::LocationIdentifier_LocationType>(from.type.data));
+            to.set_instance_id(from.instance_id.data);
+            to.set_description(from.description.data);
+        }
+
+        static bool equal(const Protobuf &pb, const at_work_robot_example_ros::LocationIdentifier &ros)
+        {
+            return ros.type.data == static_cast<uint64_t>(pb.type())
+                && ros.instance_id.data == static_cast<uint64_t>(pb.instance_id())
+                && ros.description.data == pb.description();
+        }
+    };
+
+    template <>
+    struct Converter<geometry_msgs::Pose>
+    {
+        typedef rockin_msgs::Pose3D Protobuf;
+
+        static void toRos(const Protobuf &from, geometry_msgs::Pose &to)
+        {
+            const rockin_msgs::Position3D &position = from.position();
+            const rockin_msgs::Quaternion &orientation = from.orientation();
+
+            to.position.x = position.x();
+            to.position.y = position.y();
+            to.position.z = position.z();
+
+            to.orientation.x = orientation.x();
+            to.orientation.y = orientation.y();
+            to.orientation.z = orientation.z();
+            to.orientation.w = orientation.w();
+        }
+
+        static void toProtobuf(const geometry_msgs::Pose &from, Protobuf &to)
+        {
+            rockin_msgs::Position3D *position = to.mutable_position();
+            rockin_msgs::Quaternion *orientation = to.mutable_orientation();
+
+            position->set_x(from.position.x);
+            position->set_y(from.position.y);
+            position->set_z(from.position.z);
+
+            orientation->set_x(from.orientation.x);
+            orientation->set_y(from.orientation.y);
+            orientation->set_z(from.orientation.z);
+            orientation->set_w(from.orientation.w);
+        }
+    };
+
+    template <>
+    struct Converter<at_work_robot_example_ros::Item>
+    {
+        typedef rockin_msgs::Item Protobuf;
+
+        static void toRos(const Protobuf &from, at_work_robot_example_ros::Item &to)
+        {
+            Converter<at_work_robot_example_ros::ObjectIdentifier>::toRos(from.object(), to.object);
+            to.quantity.data = from.quantity();
+            Converter<at_work_robot_example_ros::ObjectIdentifier>::toRos(from.container(), to.container);
+            Converter<at_work_robot_example_ros::LocationIdentifier>::toRos(from.location(), to.location);
+        }
+
+        static void toProtobuf(const at_work_robot_example_ros::Item &from, Protobuf &to)
+        {
+            Converter<at_work_robot_example_ros::ObjectIdentifier>::toProtobuf(from.object, *to.mutable_object());
+            to.set_quantity(from.quantity.data);
+            Converter<at_work_robot_example_ros::ObjectIdentifier>::toProtobuf(from.container, *to.mutable_container());
+            Converter<at_work_robot_example_ros::LocationIdentifier>::toProtobuf(from.location, *to.mutable_location());
+        }
+
+        static bool equal(const Protobuf &pb, const at_work_robot_example_ros::Item &ros)
+        {
+            return ros.quantity.data == pb.quantity()
+                && Converter<at_work_robot_example_ros::ObjectIdentifier>::equal(pb.object(), ros.object)
+                && Converter<at_work_robot_example_ros::ObjectIdentifier>::equal(pb.container(), ros.container)
+                && Converter<at_work_robot_example_ros::LocationIdentifier>::equal(pb.location(), ros.location);
+        }
+    };
+
+    template <>
+    struct Converter<at_work_robot_example_ros::Order>
+    {
+        typedef rockin_msgs::Order Protobuf;
+
+        static void toRos(const Protobuf &from, at_work_robot_example_ros::Order &to)
+        {
+            to.id.data     = from.id();
+            to.status.data = from.status();
+            Converter<at_work_robot_example_ros::ObjectIdentifier>::toRos(from.object(), to.object);
+            Converter<at_work_robot_example_ros::ObjectIdentifier>::toRos(from.container(), to.container);
+            to.quantity_delivered.data = from.quantity_delivered();
+            to.quantity_requested.data = from.quantity_requested();
+            Converter<at_work_robot_example_ros::LocationIdentifier>::toRos(from.destination(), to.destination);
+            Converter<at_work_robot_example_ros::LocationIdentifier>::toRos(from.source(), to.source);
+            to.processing_team.data = from.processing_team();
+        }
+
+        static void toProtobuf(const at_work_robot_example_ros::Order &from, Protobuf &to)
+        {
+            to.set_id(from.id.data);
+            to.set_status(static_cast<rockin_msgs::Order_Status>(from.status.data));
+            Converter<at_work_robot_example_ros::ObjectIdentifier>::toProtobuf(from.object, *to.mutable_object());
+            Converter<at_work_robot_example_ros::ObjectIdentifier>::toProtobuf(from.container, *to.mutable_container());
+            to.set_quantity_delivered(from.quantity_delivered.data);
+            to.set_quantity_requested(from.quantity_requested.data);
+            Converter<at_work_robot_example_ros::LocationIdentifier>::toProtobuf(from.destination, *to.mutable_destination());
+            Converter<at_work_robot_example_ros::LocationIdentifier>::toProtobuf(from.source, *to.mutable_source());
+            to.set_processing_team(from.processing_team.data);
+        }
+
+        static bool equal(const Protobuf &pb, const at_work_robot_example_ros::Order &ros)
+        {
+            return ros.status.data == static_cast<uint64_t>(pb.status())
+                && ros.quantity_delivered.data == pb.quantity_delivered()
+                && ros.quantity_requested.data == pb.quantity_requested()
+                && ros.processing_team.data == pb.processing_team()
+                && Converter<at_work_robot_example_ros::ObjectIdentifier>::equal(pb.object(), ros.object)
+                && Converter<at_work_robot_example_ros::ObjectIdentifier>::equal(pb.container(), ros.container)
+                && Converter<at_work_robot_example_ros::LocationIdentifier>::equal(pb.destination(), ros.destination)
+                && Converter<at_work_robot_example_ros::LocationIdentifier>::equal(pb.source(), ros.source);
+        }
+    };
+
+    template <>
+    struct Converter<at_work_robot_example_ros::Transaction>
+    {
+        typedef rockin_msgs::Transaction Protobuf;
+
+        static void toRos(const Protobuf &from, at_work_robot_example_ros::Transaction &to)
+        {
+            to.transaction_id.data = from.transaction_id();
+            to.order_id.data       = from.order_id();
+            Converter<at_work_robot_example_ros::ObjectIdentifier>::toRos(from.object(), to.object);
+            to.quantity.data       = from.quantity();
+            to.action.data         = from.action();
+            Converter<at_work_robot_example_ros::LocationIdentifier>::toRos(from.source(), to.source);
+            Converter<at_work_robot_example_ros::LocationIdentifier>::toRos(from.destination(), to.destination);
+        }
+
+        static void toProtobuf(const at_work_robot_example_ros::Transaction &from, Protobuf &to)
+        {
+            to.set_transaction_id(from.transaction_id.data);
+            to.set_order_id(from.order_id.data);
+            Converter<at_work_robot_example_ros::ObjectIdentifier>::toProtobuf(from.object, *to.mutable_object());
+            to.set_quantity(from.quantity.data);
+            to.set_action(static_cast<rockin_msgs::Transaction_Action>(from.action.data));
+            Converter<at_work_robot_example_ros::LocationIdentifier>::toProtobuf(from.source, *to.mutable_source());
+            Converter<at_work_robot_example_ros::LocationIdentifier>::toProtobuf(from.destination, *to.mutable_destination());
+        }
+    };
+
+    template <>
+    struct Converter<at_work_robot_example_ros::AttentionMessage>
+    {
+        typedef rockin_msgs::AttentionMessage Protobuf;
+
+        static void toRos(const Protobuf &from, at_work_robot_example_ros::AttentionMessage &to)
+        {
+            to.message.data      = from.message();
+            to.time_to_show.data = from.time_to_show();
+            to.team.data         = from.team();
+        }
+    };
+
+    template <>
+    struct Converter<at_work_robot_example_ros::BenchmarkState>
+    {
+        typedef rockin_msgs::BenchmarkState Protobuf;
+
+        static void toRos(const Protobuf &from, at_work_robot_example_ros::BenchmarkState &to)
+        {
+            to.benchmark_time.data.sec  = from.benchmark_time().sec();
+            to.benchmark_time.data.nsec = from.benchmark_time().nsec();
+            to.state.data = from.state();
+            to.phase.data = from.phase();
+
+            to.scenario.type.data        = from.scenario().type();
+            to.scenario.type_id.data     = from.scenario().type_id();
+            to.scenario.description.data = from.scenario().description();
+
+            to.known_teams.resize(from.known_teams_size());
+            for (int i = 0; i < from.known_teams_size(); i++) {
+                to.known_teams[i].data = from.known_teams(i);
+            }
+
+            to.connected_teams.resize(from.connected_teams_size());
+            for (int i = 0; i < from.connected_teams_size(); i++) {
+                to.connected_teams[i].data = from.connected_teams(i);
+            }
+        }
+    };
+
+    template <>
+    struct Converter<at_work_robot_example_ros::DrillingMachineStatus>
+    {
+        typedef rockin_msgs::DrillingMachineStatus Protobuf;
+
+        static void toRos(const Protobuf &from, at_work_robot_example_ros::DrillingMachineStatus &to)
+        {
+            to.state.data = from.state();
+        }
+    };
+
+    template <>
+    struct Converter<at_work_robot_example_ros::TriggeredConveyorBeltStatus>
+    {
+        typedef rockin_msgs::TriggeredConveyorBeltStatus Protobuf;
+
+        static void toRos(const Protobuf &from, at_work_robot_example_ros::TriggeredConveyorBeltStatus &to)
+        {
+            to.state.data = from.state();
+            to.cycle.data = from.cycle();
+        }
+    };
+
+    template <>
+    struct Converter<at_work_robot_example_ros::RobotStatusReport>
+    {
+        typedef rockin_msgs::RobotStatus Protobuf;
+
+        static void toProtobuf(const at_work_robot_example_ros::RobotStatusReport &from, Protobuf &to)
+        {
+            to.set_capability(static_cast<rockin_msgs::RobotStatus_Capability>(from.capability.data));
+            to.set_functionality(from.functionality.data);
+            to.set_meta_data(from.meta_data.data);
+        }
+    };
+
+    template <>
+    struct Converter<at_work_robot_example_ros::LoggingStatus>
+    {
+        typedef rockin_msgs::LoggingStatus Protobuf;
+
+        static void toProtobuf(const at_work_robot_example_ros::LoggingStatus &from, Protobuf &to)
+        {
+            to.set_is_logging(from.is_logging.data);
+        }
+    };
+
+    template <>
+    struct Converter<at_work_robot_example_ros::BenchmarkFeedback>
+    {
+        typedef rockin_msgs::BenchmarkFeedback Protobuf;
+
+        static void toProtobuf(const at_work_robot_example_ros::BenchmarkFeedback &from, Protobuf &to)
+        {
+            //FBM1
+            to.set_phase_to_terminate(static_cast<rockin_msgs::BenchmarkState_Phase>(from.phase_to_terminate.data));
+            to.set_object_class_name(from.object_class_name.data);
+            Converter<geometry_msgs::Pose>::toProtobuf(from.object_pose, *to.mutable_object_pose());
+
+            //FBM1+FMB2
+            to.set_object_instance_name(from.object_instance_name.data);
+
+            //FBM2
+            to.set_grasp_notification(from.grasp_notification.data);
+            Converter<geometry_msgs::Pose>::toProtobuf(from.end_effector_pose, *to.mutable_end_effector_pose());
+
+            //TBM1
+            to.set_assembly_aid_tray_id(from.assembly_aid_tray_id.data);
+            to.set_container_id(from.container_id.data);
+
+            //TBM2, plate states which were not set get a valid default
+            uint64_t after_receiving = from.plate_state_after_receiving.data;
+            uint64_t after_drilling = from.plate_state_after_drilling.data;
+
+            if (after_receiving == 0) {
+                after_receiving = rockin_msgs::BenchmarkFeedback::UNUSABLE;
+            }
+            if (after_drilling == 0) {
+                after_drilling = rockin_msgs::BenchmarkFeedback::PERFECT;
+            }
+
+            to.set_after_receiving(static_cast<rockin_msgs::BenchmarkFeedback_PlateState>(after_receiving));
+            to.set_after_drilling(static_cast<rockin_msgs::BenchmarkFeedback_PlateState>(after_drilling));
+        }
+    };
+
+    template <class RosMsg>
+    inline void toRos(const typename Converter<RosMsg>::Protobuf &from, RosMsg &to)
+    {
+        Converter<RosMsg>::toRos(from, to);
+    }
+
+    template <class RosMsg>
+    inline void toProtobuf(const RosMsg &from, typename Converter<RosMsg>::Protobuf &to)
+    {
+        Converter<RosMsg>::toProtobuf(from, to);
+    }
+
+    template <class RosMsg>
+    inline bool equal(const typename Converter<RosMsg>::Protobuf &pb, const RosMsg &ros)
+    {
+        return Converter<RosMsg>::equal(pb, ros);
+    }
+
+    /**
+     * Convert a repeated field, reusing the elements already in to.
+     */
+    template <class RosMsg>
+    inline void toRos(const google::protobuf::RepeatedPtrField<typename Converter<RosMsg>::Protobuf> &from,
+                      std::vector<RosMsg> &to)
+    {
+        to.resize(from.size());
+
+        for (int i = 0; i < from.size(); i++) {
+            Converter<RosMsg>::toRos(from.Get(i), to[i]);
+        }
+    }
+
+    template <class RosMsg>
+    inline void toProtobuf(const std::vector<RosMsg> &from,
+                           google::protobuf::RepeatedPtrField<typename Converter<RosMsg>::Protobuf> &to)
+    {
+        to.Clear();
+        to.Reserve(from.size());
+
+        for (size_t i = 0; i < from.size(); i++) {
+            Converter<RosMsg>::toProtobuf(from[i], *to.Add());
+        }
+    }
+}
+
+#endif
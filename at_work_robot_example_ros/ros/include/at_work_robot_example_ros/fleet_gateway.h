@@ -0,0 +1,154 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_FLEET_GATEWAY_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_FLEET_GATEWAY_H
+
+#include <at_work_robot_example_ros/robot_example_ros.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Hosts several robots in one process.
+ *
+ * The gateway owns the only public peer and decodes each refbox broadcast
+ * once, then hands the same message to every robot. Each robot still has
+ * its own team peer, beacon sequence and transaction ids, and reads its
+ * parameters from and creates its topics in <gateway namespace>/<robot>.
+ *
+ * The gateway checks the public peer like a single robot checks its peers
+ * and recreates it after send errors or when the refbox went silent. The
+ * robots only recreate their team peers.
+ */
+class FleetGateway
+{
+    public:
+        /**
+         * Ctor.
+         *
+         * Reads the robot names from the "robots" parameter and the refbox
+         * address from the same parameters as a single robot.
+         */
+        FleetGateway(const ros::NodeHandle &nh);
+
+        /**
+         * Dtor.
+         */
+        ~FleetGateway();
+
+        /**
+         * Number of hosted robots.
+         */
+        size_t size() const;
+
+    private:
+        /**
+         * Copy Ctor.
+         */
+        FleetGateway(const FleetGateway &other);
+
+        /**
+         * Assignment operator
+         */
+        FleetGateway &operator=(const FleetGateway &other);
+
+        /**
+         * Pass a public broadcast to all robots, called on the public
+         * peer's socket thread.
+         */
+        void receiveMessage(uint16_t component_id, uint16_t msg_type,
+                            const std::shared_ptr<google::protobuf::Message> &msg);
+
+        /**
+         * Start the public peer of the client.
+         */
+        void createPublicPeer();
+
+        /**
+         * Checks the public peer every health_check_period_ seconds and
+         * recreates it if it is broken.
+         */
+        void healthTimerCB(const ros::SteadyTimerEvent &event);
+
+        /**
+         * Destroy and recreate the public peer.
+         */
+        void reconnectPublicPeer(const char *reason);
+
+        void handleSendError(std::string msg);
+
+        void handleReceiveError(std::string msg);
+
+        ros::NodeHandle nh_;
+
+        /**
+         * Client with only the public peer, started after the robots were
+         * created and stopped before they are destroyed, so that
+         * receiveMessage never sees a partial list.
+         */
+        std::shared_ptr<CFHClient> client_;
+
+        std::vector<std::shared_ptr<RobotExampleROS> > robots_;
+
+        ros::SteadyTimer health_timer_;
+
+        /**
+         * Period in seconds of the health checks, zero disables them.
+         */
+        double health_check_period_;
+
+        /**
+         * Seconds without a public message after which the public peer is
+         * broken.
+         */
+        double refbox_timeout_;
+
+        /**
+         * Seconds between two reconnects, doubled up to the maximum until
+         * a refbox message arrives.
+         */
+        double reconnect_backoff_min_;
+
+        double reconnect_backoff_max_;
+
+        double reconnect_backoff_;
+
+        /**
+         * Send errors per second above which the public peer is broken,
+         * zero breaks it with any send error.
+         */
+        double reconnect_send_error_rate_;
+
+        /**
+         * Steady times in ns, only accessed from the health timer.
+         */
+        int64_t last_reconnect_;
+
+        int64_t next_reconnect_;
+
+        /**
+         * Send errors at the last health check.
+         */
+        unsigned long health_send_errors_;
+
+        unsigned long reconnects_;
+
+        /**
+         * Kernel drops of the sockets of earlier public peers.
+         */
+        unsigned long public_socket_drops_;
+
+        /**
+         * Send and receive errors of the public peer.
+         */
+        std::atomic<unsigned long> send_errors_;
+
+        std::atomic<unsigned long> receive_errors_;
+
+        /**
+         * Steady time in ns of the last public message, zero before the first.
+         */
+        std::atomic<int64_t> last_receive_;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_LATENCY_HISTOGRAM_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Lock-free histogram of latencies in nanoseconds.
+ *
+ * Buckets are log-linear as in HdrHistogram: every power of two is split
+ * into 16 equal sub-buckets, so a recorded value is known to within 1/16
+ * of itself. Values of 2^41 ns (about 37 minutes) and more share the last
+ * bucket.
+ *
+ * record() may be called from any number of threads concurrently with
+ * summary().
+ */
+class LatencyHistogram
+{
+    public:
+        struct Summary
+        {
+            unsigned long count;
+
+            /**
+             * Mean, percentiles and maximum in nanoseconds.
+             */
+            double mean;
+
+            int64_t p50;
+
+            int64_t p90;
+
+            int64_t p99;
+
+            int64_t max;
+        };
+
+        /**
+         * Ctor.
+         */
+        LatencyHistogram();
+
+        /**
+         * Add a latency, negative values count as zero.
+         */
+        void record(int64_t latency);
+
+        /**
+         * Percentiles of everything recorded so far.
+         *
+         * Reported percentiles are the highest value of their bucket.
+         */
+        Summary summary() const;
+
+    private:
+        /**
+         * Copy Ctor.
+         */
+        LatencyHistogram(const LatencyHistogram &other);
+
+        /**
+         * Assignment operator
+         */
+        LatencyHistogram &operator=(const LatencyHistogram &other);
+
+        static const int SUB_BUCKET_BITS = 4;
+
+        static const int MAX_EXPONENT = 40;
+
+        static const size_t BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) << SUB_BUCKET_BITS;
+
+        static size_t bucketIndex(uint64_t value);
+
+        /**
+         * Highest value falling into a bucket.
+         */
+        static uint64_t bucketValue(size_t index);
+
+        std::atomic<uint64_t> buckets_[BUCKETS];
+
+        std::atomic<uint64_t> sum_;
+
+        std::atomic<uint64_t> max_;
+};
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_MESSAGE_STATISTICS_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_MESSAGE_STATISTICS_H
+
+#include <at_work_robot_example_ros/latency_histogram.h>
+
+#include <stdint.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+
+/**
+ * Per message type counters and latency histograms of the bridge.
+ *
+ * The message types are added before the peers and the dispatch thread
+ * start and are read-only afterwards, so recording only touches atomics
+ * and never takes a lock. Times are steady-clock nanoseconds.
+ */
+class MessageStatistics
+{
+    public:
+        struct TypeStatistics
+        {
+            /**
+             * Protobuf message name.
+             */
+            std::string name;
+
+            /**
+             * Messages received by the peers, including dropped ones.
+             */
+            std::atomic<unsigned long> received;
+
+            /**
+             * Messages sent from the subscriber callbacks.
+             */
+            std::atomic<unsigned long> sent;
+
+            /**
+             * Messages dropped by the rate limit of their topic.
+             */
+            std::atomic<unsigned long> rate_limited;
+
+            /**
+             * From receiving the decoded message on the socket thread to
+             * the dispatch thread picking it up.
+             */
+            LatencyHistogram queue_latency;
+
+            /**
+             * From receiving the decoded message to the handler having
+             * converted and published it.
+             */
+            LatencyHistogram publish_latency;
+
+            /**
+             * From entering a subscriber callback to the message being
+             * sent, or queued for inventory transactions.
+             */
+            LatencyHistogram send_latency;
+        };
+
+        typedef std::map<uint32_t, std::shared_ptr<TypeStatistics> > TypeMap;
+
+        /**
+         * Ctor.
+         */
+        MessageStatistics();
+
+        void add(uint16_t component_id, uint16_t msg_type, const std::string &name);
+
+        template <class MT>
+        void add()
+        {
+            add(MT::COMP_ID, MT::MSG_TYPE, MT::descriptor()->name());
+        }
+
+        /**
+         * Count a received message, called on the socket thread.
+         */
+        void received(uint16_t component_id, uint16_t msg_type);
+
+        /**
+         * Record a message handled by the dispatch thread.
+         */
+        void published(uint16_t component_id, uint16_t msg_type,
+                       int64_t receive_time, int64_t dispatch_time, int64_t publish_time);
+
+        /**
+         * Record a message sent from a subscriber callback.
+         */
+        void sent(uint16_t component_id, uint16_t msg_type, int64_t callback_time, int64_t send_time);
+
+        template <class MT>
+        void sent(int64_t callback_time, int64_t send_time)
+        {
+            sent(MT::COMP_ID, MT::MSG_TYPE, callback_time, send_time);
+        }
+
+        /**
+         * Count a message dropped by a rate limit.
+         */
+        void rateLimited(uint16_t component_id, uint16_t msg_type);
+
+        template <class MT>
+        void rateLimited()
+        {
+            rateLimited(MT::COMP_ID, MT::MSG_TYPE);
+        }
+
+        void sendError();
+
+        void receiveError();
+
+        unsigned long sendErrors() const;
+
+        unsigned long receiveErrors() const;
+
+        /**
+         * All message types, ordered by component id and message type.
+         */
+        const TypeMap &types() const;
+
+    private:
+        /**
+         * Copy Ctor.
+         */
+        MessageStatistics(const MessageStatistics &other);
+
+        /**
+         * Assignment operator
+         */
+        MessageStatistics &operator=(const MessageStatistics &other);
+
+        /**
+         * NULL for message types which were not added.
+         */
+        TypeStatistics *find(uint16_t component_id, uint16_t msg_type) const;
+
+        TypeMap types_;
+
+        std::atomic<unsigned long> send_errors_;
+
+        std::atomic<unsigned long> receive_errors_;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_ORDER_INDEX_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_ORDER_INDEX_H
+
+#include <at_work_robot_example_ros/GetItemOrders.h>
+#include <at_work_robot_example_ros/GetOrderItems.h>
+#include <at_work_robot_example_ros/InventoryDelta.h>
+#include <at_work_robot_example_ros/OrderInfoDelta.h>
+#include <at_work_robot_example_ros/snapshot_cache.h>
+
+#include <stdint.h>
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <utility>
+
+/**
+ * Join of the orders and the inventory items which can satisfy them.
+ *
+ * The index is fed with the deltas of InventoryCache and OrderInfoCache,
+ * so a broadcast only touches the entries which changed. Items are sorted
+ * by object class and then by location, and orders by id and by object
+ * class, so that a query is a lookup of O(log n) followed by a scan over
+ * the matching entries only.
+ *
+ * Updated from the dispatch thread and queried from the service callbacks.
+ */
+class OrderIndex
+{
+    public:
+        /**
+         * Ctor.
+         */
+        OrderIndex();
+
+        /**
+         * Add, replace and remove the items of an inventory delta.
+         */
+        void update(const at_work_robot_example_ros::InventoryDelta &delta);
+
+        /**
+         * Add, replace and remove the orders of an order info delta.
+         */
+        void update(const at_work_robot_example_ros::OrderInfoDelta &delta);
+
+        /**
+         * Fill response with the order and its items, containers and
+         * delivered items. Returns false if the order is unknown.
+         */
+        bool query(uint64_t order_id, at_work_robot_example_ros::GetOrderItems::Response &response) const;
+
+        /**
+         * Fill response with the open orders for an object.
+         */
+        void query(const at_work_robot_example_ros::ObjectIdentifier &object,
+                   at_work_robot_example_ros::GetItemOrders::Response &response) const;
+
+        size_t itemCount() const;
+
+        size_t orderCount() const;
+
+    private:
+        /**
+         * Copy Ctor.
+         */
+        OrderIndex(const OrderIndex &other);
+
+        /**
+         * Assignment operator
+         */
+        OrderIndex &operator=(const OrderIndex &other);
+
+        /**
+         * Object type and type id.
+         */
+        typedef std::pair<uint64_t, uint64_t> ObjectClass;
+
+        static ObjectClass classOf(const at_work_robot_example_ros::ObjectIdentifier &object);
+
+        /**
+         * Append the items of object's class at location to items. A location
+         * of type 0 matches any location, an instance id of 0 any instance
+         * and a container of type 0 any container.
+         */
+        void findItems(const at_work_robot_example_ros::ObjectIdentifier &object,
+                       const at_work_robot_example_ros::LocationIdentifier &location,
+                       const at_work_robot_example_ros::ObjectIdentifier &container,
+                       std::vector<at_work_robot_example_ros::Item> &items) const;
+
+        void removeOrder(uint64_t id);
+
+        /**
+         * Keyed like the inventory cache, so the object class and location
+         * are a prefix of the key.
+         */
+        typedef std::map<snapshot_cache::ItemKey, at_work_robot_example_ros::Item> ItemMap;
+
+        typedef std::map<uint64_t, at_work_robot_example_ros::Order> OrderMap;
+
+        ItemMap items_;
+
+        OrderMap orders_;
+
+        /**
+         * Ids of the orders, sorted by the class of the requested object.
+         */
+        std::set<std::pair<ObjectClass, uint64_t> > orders_by_class_;
+
+        mutable std::mutex mutex_;
+};
+
+#endif
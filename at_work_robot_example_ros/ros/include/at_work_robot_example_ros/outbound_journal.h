@@ -0,0 +1,203 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_OUTBOUND_JOURNAL_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_OUTBOUND_JOURNAL_H
+
+#include <google/protobuf/message.h>
+#include <rockin_msgs/Inventory.pb.h>
+
+#include <stdint.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Append-only, memory-mapped journal of the messages sent to the refbox.
+ *
+ * Transactions are journaled when they are queued and marked done when
+ * they are confirmed or given up. Commands are journaled before and marked
+ * sent after they are put on the wire. Appending serializes the message
+ * straight into the mapping, so a crash of the process loses nothing;
+ * sync() flushes the mapping to disk and is meant to be called on a timer,
+ * off the send path.
+ *
+ * When the journal is opened, the transactions which were not done and
+ * the commands which were not sent are recovered, and the journal is
+ * rewritten with only the open transactions. When it runs full, it is
+ * compacted the same way; the rewritten file is flushed by the next sync()
+ * as well.
+ *
+ * All methods are thread-safe.
+ */
+class OutboundJournal
+{
+    public:
+        /**
+         * A command which was journaled but not sent.
+         */
+        struct Command
+        {
+            uint16_t component_id;
+
+            uint16_t msg_type;
+
+            /**
+             * Serialized message.
+             */
+            std::string payload;
+        };
+
+        /**
+         * State found when opening the journal.
+         */
+        struct Recovery
+        {
+            /**
+             * Id the next new transaction gets.
+             */
+            uint64_t next_transaction_id;
+
+            /**
+             * Transactions not confirmed or given up, in id order.
+             */
+            std::vector<rockin_msgs::Transaction> transactions;
+
+            /**
+             * Commands not sent, in journal order.
+             */
+            std::vector<Command> commands;
+
+            /**
+             * True if the journal ended with a damaged record.
+             */
+            bool damaged;
+        };
+
+        /**
+         * Ctor.
+         */
+        OutboundJournal();
+
+        /**
+         * Dtor, syncs and unmaps the journal.
+         */
+        ~OutboundJournal();
+
+        /**
+         * Open or create the journal file with at least size bytes.
+         *
+         * Returns false and sets error() if the file cannot be created,
+         * mapped or locked, e.g. because another bridge uses it.
+         */
+        bool open(const std::string &path, size_t size, Recovery &recovery);
+
+        /**
+         * Journal a queued transaction, including its transaction id.
+         *
+         * Returns false if the journal is full even after compacting.
+         */
+        bool appendTransaction(const rockin_msgs::Transaction &transaction);
+
+        /**
+         * Mark a transaction as confirmed or given up.
+         */
+        bool appendTransactionDone(uint64_t transaction_id);
+
+        /**
+         * Journal a command before sending it.
+         *
+         * Returns the sequence number to mark it sent with, zero if the
+         * journal is full.
+         */
+        uint64_t appendCommand(const google::protobuf::Message &command);
+
+        bool appendCommandSent(uint64_t seq);
+
+        /**
+         * Flush the appended records to disk.
+         */
+        void sync();
+
+        /**
+         * Number of records which did not fit into the journal.
+         */
+        unsigned long dropped() const;
+
+        const std::string &error() const;
+
+    private:
+        /**
+         * Copy Ctor.
+         */
+        OutboundJournal(const OutboundJournal &other);
+
+        /**
+         * Assignment operator
+         */
+        OutboundJournal &operator=(const OutboundJournal &other);
+
+        /**
+         * Record types.
+         */
+        enum RecordType
+        {
+            TRANSACTION = 1,
+            TRANSACTION_DONE = 2,
+            COMMAND = 3,
+            COMMAND_SENT = 4
+        };
+
+        struct FileHeader;
+
+        struct RecordHeader;
+
+        bool append(uint16_t type, uint16_t component_id, uint16_t msg_type,
+                    uint64_t id, const google::protobuf::Message *msg);
+
+        /**
+         * Offsets of the records which are still open, in journal order.
+         * Returns the end of the last valid record.
+         */
+        size_t scan(std::vector<size_t> &open_transactions,
+                    std::vector<size_t> &open_commands, bool &damaged) const;
+
+        /**
+         * Rewrite the journal with only the given records.
+         */
+        void rewrite(const std::vector<size_t> &records);
+
+        /**
+         * Rewrite the journal with only the open records.
+         */
+        bool compact();
+
+        void close();
+
+        mutable std::mutex mutex_;
+
+        int fd_;
+
+        char *base_;
+
+        size_t size_;
+
+        /**
+         * End of the last record.
+         */
+        size_t offset_;
+
+        FileHeader *header_;
+
+        bool dirty_;
+
+        /**
+         * True after a rewrite, when sync() has to write the whole file
+         * instead of the records only.
+         */
+        bool sync_all_;
+
+        unsigned long dropped_;
+
+        std::string error_;
+};
+
+#endif
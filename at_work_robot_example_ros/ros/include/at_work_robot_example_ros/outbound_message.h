@@ -0,0 +1,82 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_OUTBOUND_MESSAGE_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_OUTBOUND_MESSAGE_H
+
+#include <mutex>
+
+/**
+ * A protobuf message which is reused for every send of its type.
+ *
+ * Clear() keeps the memory of strings, repeated fields and sub-messages,
+ * so once a message of each shape has been sent, filling and serializing
+ * the next one does not touch the heap. Callers which fill the message
+ * from several threads are serialized by the lease.
+ */
+template <class MT>
+class OutboundMessage
+{
+    public:
+        /**
+         * Exclusive access to the message for filling and sending it.
+         *
+         * The message is cleared when the lease ends.
+         */
+        class Lease
+        {
+            public:
+                explicit Lease(OutboundMessage &outbound):
+                    lock_(outbound.mutex_), msg_(outbound.msg_)
+                {
+                }
+
+                ~Lease()
+                {
+                    msg_.Clear();
+                }
+
+                MT *operator->()
+                {
+                    return &msg_;
+                }
+
+                MT &operator*()
+                {
+                    return msg_;
+                }
+
+            private:
+                /**
+                 * Copy Ctor.
+                 */
+                Lease(const Lease &other);
+
+                /**
+                 * Assignment operator
+                 */
+                Lease &operator=(const Lease &other);
+
+                std::unique_lock<std::mutex> lock_;
+
+                MT &msg_;
+        };
+
+        OutboundMessage()
+        {
+        }
+
+    private:
+        /**
+         * Copy Ctor.
+         */
+        OutboundMessage(const OutboundMessage &other);
+
+        /**
+         * Assignment operator
+         */
+        OutboundMessage &operator=(const OutboundMessage &other);
+
+        std::mutex mutex_;
+
+        MT msg_;
+};
+
+#endif
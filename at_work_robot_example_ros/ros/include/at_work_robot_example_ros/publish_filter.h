@@ -0,0 +1,121 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_PUBLISH_FILTER_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_PUBLISH_FILTER_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+/**
+ * FNV-1a hash over the fields of a message which matter to subscribers.
+ */
+class Fingerprint
+{
+    public:
+        /**
+         * Ctor.
+         */
+        Fingerprint():
+            hash_(14695981039346656037ull)
+        {
+        }
+
+        Fingerprint &add(uint64_t value)
+        {
+            for (int i = 0; i < 8; i++) {
+                hash_ ^= (value >> (8 * i)) & 0xff;
+                hash_ *= 1099511628211ull;
+            }
+
+            return *this;
+        }
+
+        /**
+         * Add a string, prefixed with its length so that neighbouring
+         * strings cannot shift into each other.
+         */
+        Fingerprint &add(const std::string &value)
+        {
+            add(value.size());
+
+            for (size_t i = 0; i < value.size(); i++) {
+                hash_ ^= static_cast<unsigned char>(value[i]);
+                hash_ *= 1099511628211ull;
+            }
+
+            return *this;
+        }
+
+        uint64_t value() const
+        {
+            return hash_;
+        }
+
+    private:
+        uint64_t hash_;
+};
+
+/**
+ * Decides whether a state the refbox rebroadcasts continuously has to be
+ * republished.
+ *
+ * A state is published when its fingerprint changes and, if a heartbeat
+ * period is set, again when it was not published for that long.
+ * shouldPublish() is only called from the dispatch thread.
+ */
+class PublishFilter
+{
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        /**
+         * Ctor, publishes everything until it is configured.
+         */
+        PublishFilter();
+
+        /**
+         * Set whether unchanged states are suppressed and the heartbeat
+         * period in seconds, zero disables the heartbeat.
+         */
+        void configure(bool suppress_unchanged, double heartbeat_period);
+
+        /**
+         * Returns true if the state has to be published and remembers it as
+         * the last published one.
+         */
+        bool shouldPublish(uint64_t fingerprint, Clock::time_point now);
+
+        /**
+         * Number of states which were not published.
+         */
+        unsigned long suppressed() const;
+
+    private:
+        /**
+         * Copy Ctor.
+         */
+        PublishFilter(const PublishFilter &other);
+
+        /**
+         * Assignment operator
+         */
+        PublishFilter &operator=(const PublishFilter &other);
+
+        bool suppress_unchanged_;
+
+        Clock::duration heartbeat_period_;
+
+        /**
+         * False until the first state was published.
+         */
+        bool published_;
+
+        uint64_t last_fingerprint_;
+
+        Clock::time_point last_publish_;
+
+        std::atomic<unsigned long> suppressed_;
+};
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_REFBOX_SIMULATOR_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_REFBOX_SIMULATOR_H
+
+#include <protobuf_comm/peer.h>
+
+#include <rockin_msgs/BenchmarkState.pb.h>
+#include <rockin_msgs/ConveyorBelt.pb.h>
+#include <rockin_msgs/DrillingMachine.pb.h>
+#include <rockin_msgs/Inventory.pb.h>
+#include <rockin_msgs/Order.pb.h>
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Local stand-in for the Central Factory Hub.
+ *
+ * Broadcasts BenchmarkState, Inventory, OrderInfo, DrillingMachineStatus
+ * and TriggeredConveyorBeltStatus at configurable rates and sizes and
+ * answers drilling machine and conveyor belt commands with a status
+ * update, like the real devices do.
+ *
+ * Every broadcast carries a sequence number or send time which survives
+ * the conversion to ROS, so that a benchmark can match what the bridge
+ * publishes with what was sent:
+ * - BenchmarkState: benchmark_time is the wall-clock send time
+ * - Inventory: quantity of the first item
+ * - OrderInfo: quantity_delivered of the first order
+ * - TriggeredConveyorBeltStatus: cycle
+ */
+class RefboxSimulator
+{
+    public:
+        struct Config
+        {
+            /**
+             * Ctor.
+             */
+            Config();
+
+            std::string host_name;
+
+            /**
+             * Ports of the bridge, named as in the bridge's parameters.
+             */
+            unsigned short refbox_send_port;
+
+            unsigned short refbox_recv_port;
+
+            unsigned short team_send_port;
+
+            unsigned short team_recv_port;
+
+            /**
+             * Key and cipher of the team channel, plaintext if the key is empty.
+             */
+            std::string crypto_key;
+
+            std::string cipher;
+
+            /**
+             * Broadcast rates in Hz, zero disables the message type.
+             */
+            double benchmark_state_rate;
+
+            double inventory_rate;
+
+            double order_info_rate;
+
+            double drilling_machine_rate;
+
+            double conveyor_belt_rate;
+
+            /**
+             * Payload sizes.
+             */
+            int inventory_items;
+
+            int orders;
+
+            int description_length;
+
+            int known_teams;
+        };
+
+        /**
+         * Called for each message received from the team channel, on the
+         * socket thread of the team peer.
+         */
+        typedef std::function<void (uint16_t component_id, uint16_t msg_type,
+                                    const google::protobuf::Message &msg)> CommandHandler;
+
+        /**
+         * Called after each broadcast with its sequence number and wall-clock
+         * send time, on the broadcast thread.
+         */
+        typedef std::function<void (uint16_t component_id, uint16_t msg_type,
+                                    unsigned long seq, double send_time)> BroadcastHandler;
+
+        /**
+         * Ctor.
+         */
+        RefboxSimulator(const Config &config);
+
+        /**
+         * Dtor.
+         */
+        ~RefboxSimulator();
+
+        /**
+         * Set the handlers, must be called before start().
+         */
+        void onCommand(const CommandHandler &handler);
+
+        void onBroadcast(const BroadcastHandler &handler);
+
+        /**
+         * Create the peers and start broadcasting.
+         */
+        void start();
+
+        void stop();
+
+        /**
+         * Number of broadcasts sent so far.
+         */
+        unsigned long sentCount() const;
+
+        /**
+         * Wall-clock time in seconds, as used for the send times.
+         */
+        static double now();
+
+    private:
+        /**
+         * Copy Ctor.
+         */
+        RefboxSimulator(const RefboxSimulator &other);
+
+        /**
+         * Assignment operator
+         */
+        RefboxSimulator &operator=(const RefboxSimulator &other);
+
+        void broadcastLoop();
+
+        void fillMessages();
+
+        void sendBenchmarkState();
+
+        void sendInventory(unsigned long seq);
+
+        void sendOrderInfo(unsigned long seq);
+
+        void sendDrillingMachineStatus();
+
+        void sendConveyorBeltStatus(unsigned long seq);
+
+        void notifyBroadcast(uint16_t component_id, uint16_t msg_type,
+                             unsigned long seq, double send_time);
+
+        void handleMessage(boost::asio::ip::udp::endpoint &sender,
+                           uint16_t component_id, uint16_t msg_type,
+                           std::shared_ptr<google::protobuf::Message> msg);
+
+        Config config_;
+
+        protobuf_comm::MessageRegister message_register_;
+
+        std::shared_ptr<protobuf_comm::ProtobufBroadcastPeer> peer_public_;
+
+        std::shared_ptr<protobuf_comm::ProtobufBroadcastPeer> peer_team_;
+
+        CommandHandler command_handler_;
+
+        BroadcastHandler broadcast_handler_;
+
+        /**
+         * Prebuilt broadcasts, only the sequence fields change.
+         */
+        rockin_msgs::BenchmarkState benchmark_state_;
+
+        rockin_msgs::Inventory inventory_;
+
+        rockin_msgs::OrderInfo order_info_;
+
+        /**
+         * Device states, changed by commands from the team channel.
+         */
+        std::mutex device_mutex_;
+
+        rockin_msgs::DrillingMachineStatus drilling_machine_status_;
+
+        rockin_msgs::TriggeredConveyorBeltStatus conveyor_belt_status_;
+
+        std::thread broadcast_thread_;
+
+        std::atomic<bool> running_;
+
+        std::atomic<unsigned long> sent_count_;
+};
+
+#endif
@@ -22,10 +22,13 @@
 //publisher
 #include <at_work_robot_example_ros/AttentionMessage.h>
 #include <at_work_robot_example_ros/BenchmarkState.h>
+#include <at_work_robot_example_ros/ClockOffset.h>
 #include <at_work_robot_example_ros/TriggeredConveyorBeltStatus.h>
 #include <at_work_robot_example_ros/DrillingMachineStatus.h>
 #include <at_work_robot_example_ros/Inventory.h>
+#include <at_work_robot_example_ros/InventoryDelta.h>
 #include <at_work_robot_example_ros/OrderInfo.h>
+#include <at_work_robot_example_ros/OrderInfoDelta.h>
 
 // subscribers
 #include <at_work_robot_example_ros/BenchmarkFeedback.h>
@@ -34,12 +37,46 @@
 #include <at_work_robot_example_ros/LoggingStatus.h>
 #include <at_work_robot_example_ros/Transaction.h>
 #include <at_work_robot_example_ros/RobotStatusReport.h>
+#include <at_work_robot_example_ros/SubmitTransaction.h>
+
+// actions
+#include <at_work_robot_example_ros/ConveyorBeltAction.h>
+#include <at_work_robot_example_ros/DrillingMachineAction.h>
+
+#include <actionlib/server/action_server.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
+
+#include <at_work_robot_example/cfh_client.h>
+
+#include <at_work_robot_example_ros/clock_estimator.h>
+#include <at_work_robot_example_ros/command_tracker.h>
+#include <at_work_robot_example_ros/converters.h>
+#include <at_work_robot_example_ros/message_statistics.h>
+#include <at_work_robot_example_ros/order_index.h>
+#include <at_work_robot_example_ros/outbound_journal.h>
+#include <at_work_robot_example_ros/outbound_message.h>
+#include <at_work_robot_example_ros/publish_filter.h>
+#include <at_work_robot_example_ros/shared_snapshot.h>
+#include <at_work_robot_example_ros/snapshot_cache.h>
+#include <at_work_robot_example_ros/spsc_queue.h>
+#include <at_work_robot_example_ros/string_pool.h>
+#include <at_work_robot_example_ros/topic_qos.h>
+#include <at_work_robot_example_ros/traffic_capture.h>
+#include <at_work_robot_example_ros/transaction_sequencer.h>
 
 #include <boost/asio.hpp>
 #include <boost/date_time.hpp>
 #include <unistd.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <unordered_map>
 
 using namespace protobuf_comm;
 using namespace rockin_msgs;
@@ -47,10 +84,35 @@ using namespace rockin_msgs;
 class RobotExampleROS
 {
     public:
+        /**
+         * Fill level statistics of a receive queue.
+         */
+        struct ReceiveQueueStatistics
+        {
+            size_t capacity;
+
+            /**
+             * Messages dropped because the queue was full.
+             */
+            unsigned long drops;
+
+            /**
+             * Largest number of messages queued at the same time.
+             */
+            size_t high_water_mark;
+        };
+
         /**
          * Ctor.
+         *
+         * Parameters are read from and topics are created in the namespace
+         * of nh, which is the private node handle of the node or nodelet.
+         *
+         * With external_public_peer, no public peer is created and the
+         * public broadcasts are passed in with receivePublicMessage, so
+         * that the fleet gateway decodes them once for all its robots.
          */
-        RobotExampleROS(const ros::NodeHandle &nh);
+        RobotExampleROS(const ros::NodeHandle &nh, bool external_public_peer = false);
 
         /**
          * Dtor.
@@ -59,17 +121,101 @@ class RobotExampleROS
 
         void readParameters();
 
+        /**
+         * Read the qos/<topic>/ parameters: queue_size, keep_latest,
+         * max_rate and burst.
+         */
+        TopicQos topicQos(const std::string &topic, int default_queue_size);
+
         void initializeRobot();
 
+        /**
+         * Start the peers of the client, the team peer and unless the
+         * gateway receives the public broadcasts also the public peer.
+         */
+        void createPeers();
+
         /**
          * Beacon Signal
          *
          * This function sends the beacon signal
-         * The function is called from the main loop
+         * The function is called from the beacon timer
          */
         void sendBeacon();
 
+        /**
+         * Number of received messages for which no handler is registered.
+         */
+        unsigned long unhandledMessageCount() const;
+
+        /**
+         * Queue a message received by an external public peer, called from
+         * that peer's socket thread only. Ignored while replaying.
+         */
+        void receivePublicMessage(uint16_t component_id, uint16_t msg_type,
+                                  const std::shared_ptr<google::protobuf::Message> &msg);
+
+        /**
+         * Statistics of the queue between the public peer and the dispatch thread.
+         */
+        ReceiveQueueStatistics publicQueueStatistics() const;
+
+        /**
+         * Statistics of the queue between the team peer and the dispatch thread.
+         */
+        ReceiveQueueStatistics teamQueueStatistics() const;
+
     private:
+        /**
+         * Decoded message waiting for the dispatch thread.
+         */
+        struct ReceivedMessage
+        {
+            uint16_t component_id;
+
+            uint16_t msg_type;
+
+            std::shared_ptr<google::protobuf::Message> msg;
+
+            /**
+             * Steady-clock time in nanoseconds when the message was queued.
+             */
+            int64_t receive_time;
+        };
+
+        typedef SpscQueue<ReceivedMessage> ReceiveQueue;
+
+        typedef actionlib::ActionServer<at_work_robot_example_ros::DrillingMachineAction> DrillingMachineActionServer;
+
+        typedef actionlib::ActionServer<at_work_robot_example_ros::ConveyorBeltAction> ConveyorBeltActionServer;
+
+        /**
+         * Outcomes and command-to-effect latency of the goals of an action,
+         * guarded by action_mutex_ except for the histogram.
+         */
+        struct ActionStatistics
+        {
+            ActionStatistics();
+
+            unsigned long succeeded;
+
+            unsigned long timed_out;
+
+            /**
+             * Goals aborted because a new goal arrived.
+             */
+            unsigned long preempted;
+
+            unsigned long canceled;
+
+            /**
+             * Commands sent again because the machine did not react.
+             */
+            unsigned long resent;
+
+            LatencyHistogram latency;
+        };
+
         /**
          * Copy Ctor.
          */
@@ -96,65 +242,379 @@ class RobotExampleROS
          * Print the message that should be received as a ROS Warning
          *
          */
-        void handleReceiveError(boost::asio::ip::udp::endpoint &endpoint,
-                                std::string msg);
+        void handleReceiveError(std::string msg);
 
         /**
          * Handler for receive messages .
          *
-         * This handler is called for receiving messages.
-         * Main function in this node.
+         * This handler is called by the peers for receiving messages on their
+         * socket thread. It only appends the message to the channel's queue,
+         * so that slow conversions or publishers never stall the socket reads.
          *
          */
-        void handleMessage(boost::asio::ip::udp::endpoint &sender,
+        void receiveMessage(CFHClient::Channel channel,
                             uint16_t component_id, uint16_t msg_type,
-                            std::shared_ptr<google::protobuf::Message> msg);
+                            const std::shared_ptr<google::protobuf::Message> &msg);
+
+        /**
+         * Append a message to a queue and wake up the dispatch thread.
+         *
+         * Returns false if the queue is full and the message was dropped.
+         */
+        bool queueMessage(ReceiveQueue *queue, uint16_t component_id, uint16_t msg_type,
+                          const std::shared_ptr<google::protobuf::Message> &msg);
+
+        /**
+         * Body of the replay thread.
+         *
+         * Feeds the records of the capture file into the receive queues
+         * instead of the peers, at replay_speed_ times the captured pace.
+         */
+        void replayTraffic();
+
+        /**
+         * Main function in this node, called on the dispatch thread.
+         *
+         * Calls the client's handler for (component_id, msg_type) and
+         * falls back to handleUnknownMessage.
+         */
+        void handleMessage(uint16_t component_id, uint16_t msg_type,
+                           const std::shared_ptr<google::protobuf::Message> &msg);
+
+        /**
+         * Body of the dispatch thread.
+         *
+         * Drains both receive queues into handleMessage and sleeps while
+         * they are empty.
+         */
+        void dispatchMessages();
+
+        /**
+         * Pop all queued messages of one queue into handleMessage.
+         *
+         * Returns true if at least one message was handled.
+         */
+        bool drainQueue(ReceiveQueue &queue);
+
+        void stopDispatching();
+
+        /**
+         * Register a message type with the client and the statistics.
+         */
+        template <class MT>
+        void addMessageType();
+
+        /**
+         * Register a message type with the client and install the handler
+         * handleMessage calls for it.
+         */
+        template <class MT>
+        void registerMessageType(void (RobotExampleROS::*handler)(const MT &));
+
+        /**
+         * Fallback for messages without a registered handler.
+         *
+         * Only counts the message, unknown types are not published.
+         */
+        void handleUnknownMessage(uint16_t component_id, uint16_t msg_type);
+
+        void handleAttentionMessage(const AttentionMessage &attention);
+
+        /**
+         * Feeds the refbox clock estimate, ignores beacons of other peers.
+         */
+        void handleBeaconSignal(const BeaconSignal &beacon_signal);
+
+        void handleBenchmarkState(const BenchmarkState &benchmark_state);
+
+        void handleDrillingMachineStatus(const DrillingMachineStatus &drill_machine_status);
+
+        void handleTriggeredConveyorBeltStatus(const TriggeredConveyorBeltStatus &conveyor_belt_status);
+
+        /**
+         * Pass a machine status to the running goal of its action, called
+         * on the dispatch thread.
+         */
+        void trackDrillingMachine(uint32_t state);
+
+        void trackConveyorBelt(uint32_t state, uint32_t cycle);
+
+        void handleInventory(const Inventory &inventory);
+
+        void handleOrderInfo(const OrderInfo &order_info);
+
+        /**
+         * Write msg to the shared-memory export if it changed the state of
+         * kind or there is no snapshot of kind yet.
+         */
+        void exportSnapshot(shared_snapshot::Kind kind, const google::protobuf::Message &msg, bool changed);
+
+        /**
+         * Check if the next full snapshot is due and if so, reset last_snapshot.
+         */
+        bool snapshotDue(ros::WallTime &last_snapshot);
+
+
+        void DrillingMachineCommandCB(const at_work_robot_example_ros::DrillingMachineCommand::ConstPtr &msg);
+
+
+        void TriggeredConveyorBeltCommandCB(const at_work_robot_example_ros::TriggeredConveyorBeltCommand::ConstPtr &msg);
+
+
+        void BenchmarkFeedbackCB(const at_work_robot_example_ros::BenchmarkFeedback::ConstPtr &msg);
+
+        void LoggingStatusCB(const at_work_robot_example_ros::LoggingStatus::ConstPtr &msg);
+
+        void InventoryTransactionCB(const at_work_robot_example_ros::Transaction::ConstPtr &msg);
+
+        /**
+         * Queue a transaction in the sequencer, returns the transaction id
+         * it is sent with.
+         */
+        uint64_t submitTransaction(const at_work_robot_example_ros::Transaction &msg);
+
+        void RobotStatusReportCB(const at_work_robot_example_ros::RobotStatusReport::ConstPtr &msg);
+
+        /**
+         * Journal and send a machine command, not rate limited.
+         */
+        void sendDrillingMachineCommand(DrillingMachineCommand_Command command);
+
+        void sendConveyorBeltCommand(ConveyorBeltRunMode command, uint32_t next_cycle);
+
+        /**
+         * Actions
+         *
+         * A new goal preempts the running goal of the same machine, as the
+         * machine only follows the last command.
+         */
+        void drillingMachineGoalCB(DrillingMachineActionServer::GoalHandle goal);
+
+        void drillingMachineCancelCB(DrillingMachineActionServer::GoalHandle goal);
+
+        void conveyorBeltGoalCB(ConveyorBeltActionServer::GoalHandle goal);
+
+        void conveyorBeltCancelCB(ConveyorBeltActionServer::GoalHandle goal);
+
+        /**
+         * Resends the commands of the running goals and aborts them when
+         * they time out, every action_check_period_ seconds.
+         */
+        void actionTimerCB(const ros::SteadyTimerEvent &event);
+
+        /**
+         * Results and feedback of the running goals, called with
+         * action_mutex_ held.
+         */
+        at_work_robot_example_ros::DrillingMachineResult drillingMachineResult(CommandTracker::Clock::time_point now);
+
+        at_work_robot_example_ros::ConveyorBeltResult conveyorBeltResult(CommandTracker::Clock::time_point now);
+
+        /**
+         * Goal timeout in seconds, the default for zero.
+         */
+        CommandTracker::Clock::duration actionTimeout(double timeout) const;
+
+        /**
+         * Services
+         */
+        bool getOrderItemsCB(at_work_robot_example_ros::GetOrderItems::Request &request,
+                             at_work_robot_example_ros::GetOrderItems::Response &response);
+
+        bool getItemOrdersCB(at_work_robot_example_ros::GetItemOrders::Request &request,
+                             at_work_robot_example_ros::GetItemOrders::Response &response);
+
+        /**
+         * Submit a transaction like the inventory_transaction topic, and
+         * return the transaction id it is sent with.
+         */
+        bool submitTransactionCB(at_work_robot_example_ros::SubmitTransaction::Request &request,
+                                 at_work_robot_example_ros::SubmitTransaction::Response &response);
+
+        /**
+         * Sends the beacon every beacon_period_ seconds, independent of
+         * how the node handle's callback queue is spun.
+         */
+        void beaconTimerCB(const ros::SteadyTimerEvent &event);
+
+        /**
+         * Sends queued and retransmits unconfirmed inventory transactions
+         * every transaction_send_period_ seconds.
+         */
+        void transactionTimerCB(const ros::SteadyTimerEvent &event);
 
+        /**
+         * Flushes the journal every journal_sync_period_ seconds.
+         */
+        void journalTimerCB(const ros::SteadyTimerEvent &event);
 
-        void DrillingMachineCommandCB(at_work_robot_example_ros::DrillingMachineCommand msg);
+        /**
+         * Checks the connection to the refbox every health_check_period_
+         * seconds and recreates the peers if it is broken.
+         *
+         * Receive errors do not count, as undecodable datagrams of other
+         * teams raise them too. With an external public peer the refbox
+         * timeout is left to the gateway, only send errors of the team peer
+         * and our team missing from the connected teams while the refbox is
+         * heard count.
+         */
+        void healthTimerCB(const ros::SteadyTimerEvent &event);
 
+        /**
+         * Destroy and recreate the owned peers, then send the team messages
+         * buffered meanwhile. Called with peer_mutex_ held.
+         */
+        void reconnectPeers(const char *reason);
 
-        void TriggeredConveyorBeltCommandCB(at_work_robot_example_ros::TriggeredConveyorBeltCommand msg);
+        /**
+         * Publishes the message statistics every diagnostics_period_ seconds.
+         */
+        void diagnosticsTimerCB(const ros::SteadyTimerEvent &event);
 
+        /**
+         * Log the message statistics, called on shutdown.
+         */
+        void logStatistics();
 
-        void BenchmarkFeedbackCB(at_work_robot_example_ros::BenchmarkFeedback msg);
+        /**
+         * Diagnostics and log of an action's statistics, the status is
+         * built with action_mutex_ held.
+         */
+        diagnostic_msgs::DiagnosticStatus actionStatus(const std::string &name,
+                                                       const ActionStatistics &statistics);
+
+        void logAction(const std::string &name, const ActionStatistics &statistics);
+
+        /**
+         * Publish the clock estimates, called with clock_mutex_ held.
+         */
+        void publishClockOffset();
 
-        void LoggingStatusCB(at_work_robot_example_ros::LoggingStatus msg);
+        /**
+         * Open the journal, restore the transaction ids and resend what was
+         * not confirmed or sent before the last shutdown.
+         */
+        void openJournal();
+
+        /**
+         * Resend a journaled command if it is an MT.
+         */
+        template <class MT>
+        bool replayCommand(const OutboundJournal::Command &command, OutboundMessage<MT> &outbound);
 
-        void InventoryTransactionCB(at_work_robot_example_ros::Transaction msg);
+        /**
+         * Journal a command and send it over the team peer.
+         */
+        void sendCommand(google::protobuf::Message &command);
 
-        void RobotStatusReportCB(at_work_robot_example_ros::RobotStatusReport msg);
+        /**
+         * Send a message over the team peer, dropped while replaying and
+         * buffered while the peers are broken.
+         */
+        void sendToTeam(google::protobuf::Message &msg);
 
     private:
         /**
-         * ROS node handle.
+         * ROS node handle, private to the node or nodelet.
          */
         ros::NodeHandle nh_;
 
         /**
-         * Stores sequence of the bacon messages.
+         * Refbox address, names, encryption and socket buffers of the
+         * client. Without a public peer the public broadcasts come from
+         * receivePublicMessage.
+         */
+        CFHClient::Config client_config_;
+
+        /**
+         * The peers to the refbox and the team, their beacon and the
+         * message handlers, created in initializeRobot.
+         */
+        std::shared_ptr<CFHClient> client_;
+
+        /**
+         * Messages received by the public and team peer.
+         *
+         * Each queue has exactly one producer (the peer's socket thread)
+         * and one consumer (the dispatch thread).
+         */
+        std::shared_ptr<ReceiveQueue> public_queue_;
+
+        std::shared_ptr<ReceiveQueue> team_queue_;
+
+        /**
+         * Capacity of each receive queue.
+         */
+        int receive_queue_size_;
+
+        /**
+         * Thread converting and publishing the received messages.
+         */
+        std::thread dispatch_thread_;
+
+        std::atomic<bool> dispatch_running_;
+
+        /**
+         * Set while the dispatch thread waits for dispatch_cond_.
+         */
+        std::atomic<bool> dispatch_waiting_;
+
+        std::mutex dispatch_mutex_;
+
+        std::condition_variable dispatch_cond_;
+
+        /**
+         * Capture of the received messages, written by the dispatch thread,
+         * NULL if disabled.
+         */
+        std::shared_ptr<TrafficCapture> capture_;
+
+        /**
+         * Set by the diagnostics timer, the dispatch thread then flushes the
+         * capture so that a crash loses at most one period of it.
+         */
+        std::atomic<bool> capture_flush_;
+
+        /**
+         * Capture file fed into the receive queues instead of the peers,
+         * NULL if not replaying.
          */
-        unsigned long seq_;
+        std::shared_ptr<TrafficReplay> replay_;
+
+        std::thread replay_thread_;
+
+        std::atomic<bool> replay_running_;
 
         /**
-         * The interface to the Protobuf Broadcast peer to communicate with Refbox.
+         * File to capture the received messages to, empty to disable.
          */
-        std::shared_ptr<ProtobufBroadcastPeer> peer_public_;
+        std::string capture_path_;
 
         /**
-         * The interface to the Protobuf Broadcast peer to communicate with Team.
+         * Capture file to replay instead of connecting to the refbox.
          */
-        std::shared_ptr<ProtobufBroadcastPeer> peer_team_;
+        std::string replay_path_;
 
         /**
-         * Stores robot name.
+         * Replay pace relative to the capture, zero replays at full speed.
          */
-        std::string robot_name_;
+        double replay_speed_;
 
         /**
-         * Stores team name.
+         * Shared-memory export of the latest inventory, orders and benchmark
+         * state, written by the dispatch thread, NULL if disabled.
          */
-        std::string team_name_;
+        std::shared_ptr<SnapshotExport> shared_snapshot_;
+
+        /**
+         * Name of the shared-memory segment, empty to disable the export.
+         */
+        std::string shared_snapshot_name_;
+
+        /**
+         * Capacity in bytes of each snapshot buffer.
+         */
+        int shared_snapshot_size_;
 
         /**
          * Publishers
@@ -169,6 +629,10 @@ class RobotExampleROS
 
         ros::Publisher order_info_pub_;
 
+        ros::Publisher inventory_delta_pub_;
+
+        ros::Publisher order_info_delta_pub_;
+
         ros::Publisher conveyor_belt_status_pub_;
 
         /**
@@ -187,48 +651,348 @@ class RobotExampleROS
         ros::Subscriber robot_status_sub_;
 
         /**
-         * Parameter to check if refbox is running on local or another machine.
+         * Services
+         */
+        ros::ServiceServer get_order_items_srv_;
+
+        ros::ServiceServer get_item_orders_srv_;
+
+        ros::ServiceServer submit_transaction_srv_;
+
+        /**
+         * Actions on the machine commands, completed by the machine status.
+         */
+        std::shared_ptr<DrillingMachineActionServer> drilling_machine_action_;
+
+        std::shared_ptr<ConveyorBeltActionServer> conveyor_belt_action_;
+
+        /**
+         * Held while the goals, trackers and last statuses below are
+         * accessed. The goal and cancel callbacks take it with the action
+         * server's lock held, so elsewhere the goal handles are completed
+         * only after it was released.
+         */
+        std::mutex action_mutex_;
+
+        /**
+         * Running goal, or the last one if its tracker is inactive.
+         */
+        DrillingMachineActionServer::GoalHandle drilling_machine_goal_;
+
+        ConveyorBeltActionServer::GoalHandle conveyor_belt_goal_;
+
+        CommandTracker drilling_machine_tracker_;
+
+        CommandTracker conveyor_belt_tracker_;
+
+        /**
+         * Command of the running goal, and for the conveyor belt the cycle
+         * it was sent for.
+         */
+        DrillingMachineCommand_Command drilling_machine_command_;
+
+        ConveyorBeltRunMode conveyor_belt_command_;
+
+        uint32_t conveyor_belt_next_cycle_;
+
+        /**
+         * Last status received from each machine.
+         */
+        uint32_t drilling_machine_state_;
+
+        bool conveyor_belt_status_known_;
+
+        uint32_t conveyor_belt_state_;
+
+        uint32_t conveyor_belt_cycle_;
+
+        ActionStatistics drilling_machine_statistics_;
+
+        ActionStatistics conveyor_belt_statistics_;
+
+        ros::SteadyTimer action_timer_;
+
+        /**
+         * Seconds until a goal is aborted unless it sets its own timeout.
+         */
+        double action_timeout_;
+
+        /**
+         * Seconds after which a command is sent again while the machine's
+         * status does not show it in progress, at most action_max_attempts_
+         * sends in total.
+         */
+        double action_retry_timeout_;
+
+        int action_max_attempts_;
+
+        double action_check_period_;
+
+        /**
+         * Rate limits of the messages sent from the subscriber callbacks.
+         */
+        RateLimiter drilling_machine_command_limiter_;
+
+        RateLimiter conveyor_belt_command_limiter_;
+
+        RateLimiter benchmark_feedback_limiter_;
+
+        RateLimiter logging_status_limiter_;
+
+        RateLimiter robot_status_limiter_;
+
+        /**
+         * Messages sent over the team peer, reused for every send.
+         */
+        OutboundMessage<RobotStatus> robot_status_out_;
+
+        OutboundMessage<Transaction> transaction_out_;
+
+        OutboundMessage<LoggingStatus> logging_status_out_;
+
+        OutboundMessage<DrillingMachineCommand> drilling_machine_command_out_;
+
+        OutboundMessage<TriggeredConveyorBeltCommand> conveyor_belt_command_out_;
+
+        OutboundMessage<BenchmarkFeedback> benchmark_feedback_out_;
+
+        OutboundMessage<BeaconSignal> beacon_signal_out_;
+
+        /**
+         * Timer for the beacon signal, on the steady clock.
+         */
+        ros::SteadyTimer beacon_timer_;
+
+        /**
+         * Period in seconds between two beacon signals.
+         */
+        double beacon_period_;
+
+        /**
+         * Orders, batches and retransmits the inventory transactions.
+         */
+        std::shared_ptr<TransactionSequencer> transaction_sequencer_;
+
+        TransactionSequencer::Config transaction_config_;
+
+        ros::SteadyTimer transaction_timer_;
+
+        /**
+         * Period in seconds between two transaction send cycles.
+         */
+        double transaction_send_period_;
+
+        /**
+         * Transactions given up so far, to warn about new ones.
+         */
+        unsigned long transactions_given_up_;
+
+        /**
+         * Journal of the outbound transactions and commands, NULL if disabled.
+         */
+        std::shared_ptr<OutboundJournal> journal_;
+
+        ros::SteadyTimer journal_timer_;
+
+        /**
+         * Journal file, an empty path disables the journal.
+         */
+        std::string journal_path_;
+
+        /**
+         * Size of the journal file in bytes.
+         */
+        int journal_size_;
+
+        /**
+         * Period in seconds between two flushes of the journal to disk.
+         */
+        double journal_sync_period_;
+
+        /**
+         * Counters and latency histograms per message type.
+         */
+        MessageStatistics message_statistics_;
+
+        ros::Publisher diagnostics_pub_;
+
+        ros::SteadyTimer diagnostics_timer_;
+
+        /**
+         * Period in seconds for publishing the diagnostics, zero disables them.
+         */
+        double diagnostics_period_;
+
+        ros::WallTime last_diagnostics_;
+
+        /**
+         * Received counts at the last publish, for the receive rates.
+         */
+        std::map<uint32_t, unsigned long> diagnostics_received_;
+
+        /**
+         * Errors and drops at the last publish.
+         */
+        unsigned long diagnostics_errors_;
+
+        /**
+         * Steady receive time of the message being handled, only accessed
+         * from the dispatch thread.
+         */
+        int64_t dispatch_receive_time_;
+
+        /**
+         * Refbox clock from its beacon signals and benchmark clock from the
+         * benchmark time of the running benchmark. Updated on the dispatch
+         * thread and read by the diagnostics.
+         */
+        ClockEstimator refbox_clock_;
+
+        ClockEstimator benchmark_clock_;
+
+        std::mutex clock_mutex_;
+
+        ros::Publisher clock_offset_pub_;
+
+        /**
+         * Peer name of the refbox's beacon signals.
+         */
+        std::string refbox_peer_name_;
+
+        /**
+         * Delay and jitter in seconds above which the network is reported
+         * as degraded.
+         */
+        double clock_delay_warning_;
+
+        double clock_jitter_warning_;
+
+        /**
+         * Held while sending over the client and while recreating its peers.
+         */
+        std::mutex peer_mutex_;
+
+        /**
+         * Set when the health monitor finds the connection broken and
+         * cleared when the peers were recreated, guarded by peer_mutex_.
+         */
+        bool peers_broken_;
+
+        /**
+         * Team messages sent while the peers are broken, oldest first,
+         * guarded by peer_mutex_. Beacons are not buffered.
+         */
+        std::deque<std::shared_ptr<google::protobuf::Message> > reconnect_buffer_;
+
+        int reconnect_buffer_size_;
+
+        /**
+         * Messages dropped because the reconnect buffer was full.
+         */
+        unsigned long reconnect_buffer_drops_;
+
+        unsigned long reconnects_;
+
+        /**
+         * Kernel drops of the sockets closed by reconnects, guarded by
+         * peer_mutex_.
+         */
+        unsigned long public_socket_drops_;
+
+        unsigned long team_socket_drops_;
+
+        ros::SteadyTimer health_timer_;
+
+        /**
+         * Period in seconds of the health checks, zero disables them.
+         */
+        double health_check_period_;
+
+        /**
+         * Seconds without a public message, and without our team in the
+         * connected teams, after which the connection is broken.
+         */
+        double refbox_timeout_;
+
+        double team_timeout_;
+
+        /**
+         * Seconds between two reconnects, doubled up to the maximum until
+         * a refbox message arrives.
+         */
+        double reconnect_backoff_min_;
+
+        double reconnect_backoff_max_;
+
+        double reconnect_backoff_;
+
+        /**
+         * Send errors per second above which the connection is broken,
+         * zero breaks it with any send error.
          */
-        bool remote_refbox_;
+        double reconnect_send_error_rate_;
 
         /**
-         * Parameter to store host name(IP address).
+         * Steady times in ns, only accessed from the health timer.
          */
-        std::string host_name_;
+        int64_t last_reconnect_;
+
+        int64_t next_reconnect_;
 
         /**
-         * Stores port number on which refbox is receiving or sending messages
-         * when the refbox is running on another machine. 
+         * Send errors at the last health check.
          */
-        int public_port_;
+        unsigned long health_send_errors_;
 
         /**
-         * Stores port number on which robot/team is receiving or sending messages. 
-         * when the refbox is running on another machine.
+         * Steady time in ns of the last public message, zero before the first.
          */
-        int team_port_;
+        std::atomic<int64_t> last_public_receive_;
 
         /**
-         * Stores port number on which refbox is sending messages. 
-         * when the refbox is running on local machine.
+         * Steady time in ns of the last benchmark state listing our team as
+         * connected, zero before the first.
          */
-        int public_send_port_;
+        std::atomic<int64_t> last_team_listed_;
 
         /**
-         * Stores port number on which refbox is receiving messages. 
-         * when the refbox is running on local machine.
+         * Descriptions and team names of the cached inventory and orders,
+         * each stored once. Only accessed from the dispatch thread.
          */
-        int public_recv_port_;
- 
+        std::shared_ptr<StringPool> string_pool_;
+
         /**
-         * Stores port number on which the team is sending messages. 
-         * when the refbox is running on local machine.
+         * Last inventory and order info, used to publish only the changes.
+         * Only accessed from the dispatch thread.
          */
-        int team_send_port_;
- 
+        InventoryCache inventory_cache_;
+
+        OrderInfoCache order_info_cache_;
+
+        /**
+         * Orders joined to the inventory, updated with the cache deltas.
+         */
+        OrderIndex order_index_;
+
+        /**
+         * Publish only changed states, only accessed from the dispatch thread.
+         */
+        PublishFilter benchmark_state_filter_;
+
+        PublishFilter drill_machine_status_filter_;
+
+        PublishFilter conveyor_belt_status_filter_;
+
+        /**
+         * Time when the last full inventory and order info were published.
+         */
+        ros::WallTime last_inventory_snapshot_;
+
+        ros::WallTime last_order_info_snapshot_;
+
         /**
-         * Stores port number on which team is receiving messages. 
-         * when the refbox is running on local machine.
+         * Period in seconds for publishing the full inventory and order info.
+         * A period of zero publishes them for every refbox broadcast.
          */
-        int team_recv_port_;
+        double full_snapshot_period_;
 };
\ No newline at end of file
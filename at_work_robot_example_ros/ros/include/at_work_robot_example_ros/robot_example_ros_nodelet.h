@@ -0,0 +1,36 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_ROBOT_EXAMPLE_ROS_NODELET_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_ROBOT_EXAMPLE_ROS_NODELET_H
+
+#include <nodelet/nodelet.h>
+#include <at_work_robot_example_ros/robot_example_ros.h>
+
+#include <memory>
+
+namespace at_work_robot_example_ros
+{
+
+/**
+ * The bridge as a nodelet.
+ *
+ * Nodelets in the same manager receive the published inventory, order info
+ * and device states and send commands such as BenchmarkFeedback without
+ * serialization. Subscriber callbacks and the beacon timer run on the
+ * manager's worker threads.
+ */
+class RobotExampleNodelet : public nodelet::Nodelet
+{
+    public:
+        /**
+         * Dtor.
+         */
+        ~RobotExampleNodelet();
+
+    private:
+        virtual void onInit();
+
+        std::shared_ptr<RobotExampleROS> robot_example_ros_;
+};
+
+}
+
+#endif
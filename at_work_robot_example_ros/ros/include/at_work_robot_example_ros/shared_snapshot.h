@@ -0,0 +1,199 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_SHARED_SNAPSHOT_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_SHARED_SNAPSHOT_H
+
+#include <google/protobuf/message.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+/**
+ * Snapshots of the latest refbox state in a POSIX shared-memory segment,
+ * for processes on the robot which are not ROS nodes.
+ *
+ * The segment holds one slot per kind of message, each with two buffers
+ * of a fixed capacity. A snapshot is the serialized refbox message as
+ * received (rockin_msgs::Inventory, OrderInfo or BenchmarkState), written
+ * into the buffer the latest snapshot is not in, guarded by a sequence
+ * counter. A reader parses the latest buffer in place and checks that its
+ * counter did not change meanwhile; it only has to retry when two further
+ * snapshots were written while it parsed. Readers never block the writer.
+ * The layout is in host byte order and meant for processes on the same
+ * machine only. Linux only.
+ */
+namespace shared_snapshot
+{
+    enum Kind
+    {
+        INVENTORY = 0,
+        ORDER_INFO = 1,
+        BENCHMARK_STATE = 2,
+        KIND_COUNT = 3
+    };
+
+    struct Info
+    {
+        /**
+         * Number of snapshots of the kind written so far, 0 if there is none
+         * yet.
+         */
+        uint64_t version;
+
+        /**
+         * Wall-clock time in nanoseconds when the refbox message was
+         * received.
+         */
+        int64_t stamp;
+
+        /**
+         * Size of the serialized message in bytes.
+         */
+        uint32_t size;
+    };
+
+    struct Segment;
+}
+
+/**
+ * Creates the segment and writes the snapshots.
+ *
+ * The segment is removed when the export is destroyed. Not thread-safe,
+ * meant to be called from the dispatch thread only.
+ */
+class SnapshotExport
+{
+    public:
+        /**
+         * Ctor.
+         */
+        SnapshotExport();
+
+        /**
+         * Dtor, unmaps and removes the segment.
+         */
+        ~SnapshotExport();
+
+        /**
+         * Create the segment name (e.g. "/at_work_robot1") with buffers of
+         * capacity bytes, replacing a stale one of a previous run.
+         */
+        bool open(const std::string &name, size_t capacity);
+
+        /**
+         * Write msg as the latest snapshot of kind, received at the
+         * wall-clock time stamp in nanoseconds. Returns false if it does not
+         * fit into a buffer, the previous snapshot stays in place then.
+         */
+        bool write(shared_snapshot::Kind kind, int64_t stamp, const google::protobuf::Message &msg);
+
+        /**
+         * Version of the latest snapshot of kind, 0 if there is none yet.
+         */
+        uint64_t version(shared_snapshot::Kind kind) const;
+
+        /**
+         * Number of snapshots written, of all kinds.
+         */
+        unsigned long written() const;
+
+        /**
+         * Number of messages which did not fit into a buffer.
+         */
+        unsigned long oversized() const;
+
+        const std::string &name() const;
+
+        const std::string &error() const;
+
+    private:
+        /**
+         * Copy Ctor.
+         */
+        SnapshotExport(const SnapshotExport &other);
+
+        /**
+         * Assignment operator
+         */
+        SnapshotExport &operator=(const SnapshotExport &other);
+
+        std::string name_;
+
+        shared_snapshot::Segment *segment_;
+
+        size_t segment_size_;
+
+        unsigned long written_;
+
+        unsigned long oversized_;
+
+        std::string error_;
+};
+
+/**
+ * Maps the segment of a running bridge and reads its snapshots.
+ *
+ * Only needs protobuf and the rockin_msgs messages, not ROS. Not
+ * thread-safe, threads which read concurrently each need their own reader.
+ */
+class SnapshotReader
+{
+    public:
+        /**
+         * Ctor.
+         */
+        SnapshotReader();
+
+        /**
+         * Dtor, unmaps the segment.
+         */
+        ~SnapshotReader();
+
+        /**
+         * Map the segment name read-only, returns false if there is no
+         * bridge exporting it or its layout differs from this reader's.
+         */
+        bool open(const std::string &name);
+
+        /**
+         * Version of the latest snapshot of kind, a cheap check for a new
+         * one. 0 if there is none yet.
+         */
+        uint64_t version(shared_snapshot::Kind kind) const;
+
+        /**
+         * Parse the latest snapshot of kind into msg, which must be the
+         * message type of the kind. Returns false if there is no snapshot
+         * yet or it was overwritten while reading too often.
+         */
+        bool read(shared_snapshot::Kind kind, google::protobuf::Message &msg,
+                  shared_snapshot::Info &info);
+
+        /**
+         * Copy the latest snapshot of kind as serialized message, e.g. to
+         * log it.
+         */
+        bool read(shared_snapshot::Kind kind, std::string &payload,
+                  shared_snapshot::Info &info);
+
+        const std::string &error() const;
+
+    private:
+        /**
+         * Copy Ctor.
+         */
+        SnapshotReader(const SnapshotReader &other);
+
+        /**
+         * Assignment operator
+         */
+        SnapshotReader &operator=(const SnapshotReader &other);
+
+        const shared_snapshot::Segment *segment_;
+
+        size_t segment_size_;
+
+        std::string error_;
+};
+
+#endif
@@ -0,0 +1,260 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_SNAPSHOT_CACHE_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_SNAPSHOT_CACHE_H
+
+#include <rockin_msgs/Inventory.pb.h>
+#include <rockin_msgs/Order.pb.h>
+
+#include <at_work_robot_example_ros/Inventory.h>
+#include <at_work_robot_example_ros/InventoryDelta.h>
+#include <at_work_robot_example_ros/OrderInfo.h>
+#include <at_work_robot_example_ros/OrderInfoDelta.h>
+#include <at_work_robot_example_ros/string_pool.h>
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ * Identifiers as the caches keep them, with the description interned.
+ */
+namespace snapshot_cache
+{
+    struct Object
+    {
+        int64_t type;
+
+        int64_t type_id;
+
+        int64_t instance_id;
+
+        StringPool::Handle description;
+    };
+
+    struct Location
+    {
+        int64_t type;
+
+        int64_t instance_id;
+
+        StringPool::Handle description;
+    };
+
+    /**
+     * Identity of an item, shared by the caches and OrderIndex: object type
+     * and type id, presence, type and instance id of the location,
+     * presence, type, type id and instance id of the container and finally
+     * object instance id.
+     *
+     * ROS items do not tell whether the container or location is set, it
+     * is taken as set if its type is, which the refbox requires.
+     */
+    struct ItemKey
+    {
+        uint64_t fields[10];
+
+        bool operator<(const ItemKey &other) const;
+
+        static ItemKey of(const rockin_msgs::Item &item);
+
+        static ItemKey of(const at_work_robot_example_ros::Item &item);
+    };
+}
+
+/**
+ * Cache of the last inventory broadcast by the refbox.
+ *
+ * Items are keyed by their object, container and location identifiers.
+ * A new snapshot is diffed against the cache and only items which were
+ * added or changed are converted to ROS messages. Descriptions are kept
+ * in a string pool, which may be shared with other caches. Full snapshots
+ * list the items in the order of the last broadcast.
+ */
+class InventoryCache
+{
+    public:
+        /**
+         * Ctor, with a pool of its own.
+         */
+        InventoryCache();
+
+        /**
+         * Ctor, interning the descriptions in pool.
+         */
+        explicit InventoryCache(const std::shared_ptr<StringPool> &pool);
+
+        /**
+         * Dtor, releases the cached strings.
+         */
+        ~InventoryCache();
+
+        /**
+         * Diff the inventory against the cache and update the cache.
+         *
+         * Fills delta with the added, changed and removed items and returns
+         * true if it is not empty.
+         */
+        bool update(const rockin_msgs::Inventory &inventory,
+                    at_work_robot_example_ros::InventoryDelta &delta);
+
+        /**
+         * Fill inventory with all cached items.
+         */
+        void snapshot(at_work_robot_example_ros::Inventory &inventory) const;
+
+    private:
+        /**
+         * Copy Ctor.
+         */
+        InventoryCache(const InventoryCache &other);
+
+        /**
+         * Assignment operator
+         */
+        InventoryCache &operator=(const InventoryCache &other);
+
+        struct CachedItem
+        {
+            snapshot_cache::Object object;
+
+            uint64_t quantity;
+
+            snapshot_cache::Object container;
+
+            snapshot_cache::Location location;
+
+            /**
+             * Value of generation_ when the item was last broadcast.
+             */
+            unsigned long generation;
+        };
+
+        /**
+         * Update cached from item, returns true if it differed.
+         */
+        bool assign(CachedItem &cached, const rockin_msgs::Item &item);
+
+        static void toRos(const CachedItem &cached, at_work_robot_example_ros::Item &item);
+
+        void release(CachedItem &cached);
+
+        typedef std::map<snapshot_cache::ItemKey, CachedItem> ItemMap;
+
+        std::shared_ptr<StringPool> pool_;
+
+        ItemMap items_;
+
+        /**
+         * Items in the order of the last broadcast.
+         */
+        std::vector<ItemMap::const_iterator> broadcast_order_;
+
+        /**
+         * Incremented for every update.
+         */
+        unsigned long generation_;
+};
+
+/**
+ * Cache of the last order info broadcast by the refbox.
+ *
+ * Orders are keyed by their id, see InventoryCache. The processing team
+ * is interned like the descriptions.
+ */
+class OrderInfoCache
+{
+    public:
+        /**
+         * Ctor, with a pool of its own.
+         */
+        OrderInfoCache();
+
+        /**
+         * Ctor, interning the descriptions and team names in pool.
+         */
+        explicit OrderInfoCache(const std::shared_ptr<StringPool> &pool);
+
+        /**
+         * Dtor, releases the cached strings.
+         */
+        ~OrderInfoCache();
+
+        /**
+         * Diff the order info against the cache and update the cache.
+         *
+         * Fills delta with the added, changed and removed orders and returns
+         * true if it is not empty.
+         */
+        bool update(const rockin_msgs::OrderInfo &order_info,
+                    at_work_robot_example_ros::OrderInfoDelta &delta);
+
+        /**
+         * Fill order_info with all cached orders.
+         */
+        void snapshot(at_work_robot_example_ros::OrderInfo &order_info) const;
+
+    private:
+        /**
+         * Copy Ctor.
+         */
+        OrderInfoCache(const OrderInfoCache &other);
+
+        /**
+         * Assignment operator
+         */
+        OrderInfoCache &operator=(const OrderInfoCache &other);
+
+        struct CachedOrder
+        {
+            uint64_t id;
+
+            uint64_t status;
+
+            snapshot_cache::Object object;
+
+            snapshot_cache::Object container;
+
+            uint64_t quantity_delivered;
+
+            uint64_t quantity_requested;
+
+            snapshot_cache::Location destination;
+
+            snapshot_cache::Location source;
+
+            StringPool::Handle processing_team;
+
+            /**
+             * Value of generation_ when the order was last broadcast.
+             */
+            unsigned long generation;
+        };
+
+        /**
+         * Update cached from order, returns true if it differed.
+         */
+        bool assign(CachedOrder &cached, const rockin_msgs::Order &order);
+
+        static void toRos(const CachedOrder &cached, at_work_robot_example_ros::Order &order);
+
+        void release(CachedOrder &cached);
+
+        typedef std::map<uint64_t, CachedOrder> OrderMap;
+
+        std::shared_ptr<StringPool> pool_;
+
+        OrderMap orders_;
+
+        /**
+         * Orders in the order of the last broadcast.
+         */
+        std::vector<OrderMap::const_iterator> broadcast_order_;
+
+        /**
+         * Incremented for every update.
+         */
+        unsigned long generation_;
+};
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_SPSC_QUEUE_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * Bounded lock-free single-producer/single-consumer ring buffer.
+ *
+ * push() may only be called from one thread and pop() from one other
+ * thread. When the ring is full push() drops the item and counts the drop
+ * instead of blocking the producer.
+ */
+template <class T>
+class SpscQueue
+{
+    public:
+        /**
+         * Ctor.
+         *
+         * The capacity is rounded up to the next power of two.
+         */
+        explicit SpscQueue(size_t capacity):
+            head_(0), tail_(0), drops_(0), high_water_mark_(0)
+        {
+            size_t size = 2;
+            while (size < capacity) {
+                size <<= 1;
+            }
+            buffer_.resize(size);
+            mask_ = size - 1;
+        }
+
+        /**
+         * Append an item, called by the producer.
+         *
+         * Returns false if the queue is full and the item was dropped.
+         */
+        bool push(T item)
+        {
+            size_t tail = tail_.load(std::memory_order_relaxed);
+            size_t head = head_.load(std::memory_order_acquire);
+
+            if (tail - head > mask_) {
+                drops_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            buffer_[tail & mask_] = std::move(item);
+            tail_.store(tail + 1, std::memory_order_release);
+
+            //only the producer writes the high-water mark
+            size_t size = tail + 1 - head;
+            if (size > high_water_mark_.load(std::memory_order_relaxed)) {
+                high_water_mark_.store(size, std::memory_order_relaxed);
+            }
+
+            return true;
+        }
+
+        /**
+         * Take the oldest item, called by the consumer.
+         *
+         * Returns false if the queue is empty.
+         */
+        bool pop(T &item)
+        {
+            size_t head = head_.load(std::memory_order_relaxed);
+
+            if (head == tail_.load(std::memory_order_acquire)) {
+                return false;
+            }
+
+            item = std::move(buffer_[head & mask_]);
+            buffer_[head & mask_] = T();
+            head_.store(head + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        /**
+         * True if the next push() would drop, called by the producer.
+         */
+        bool full() const
+        {
+            return tail_.load(std::memory_order_relaxed)
+                 - head_.load(std::memory_order_acquire) > mask_;
+        }
+
+        bool empty() const
+        {
+            return head_.load(std::memory_order_acquire)
+                == tail_.load(std::memory_order_acquire);
+        }
+
+        size_t capacity() const
+        {
+            return mask_ + 1;
+        }
+
+        /**
+         * Number of items dropped because the queue was full.
+         */
+        unsigned long drops() const
+        {
+            return drops_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Largest number of items which were queued at the same time.
+         */
+        size_t highWaterMark() const
+        {
+            return high_water_mark_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        /**
+         * Copy Ctor.
+         */
+        SpscQueue(const SpscQueue &other);
+
+        /**
+         * Assignment operator
+         */
+        SpscQueue &operator=(const SpscQueue &other);
+
+        std::vector<T> buffer_;
+
+        size_t mask_;
+
+        /**
+         * Index of the next item to pop, written by the consumer.
+         *
+         * The padding keeps the consumer and producer indices on different
+         * cache lines.
+         */
+        std::atomic<size_t> head_;
+
+        char head_padding_[64];
+
+        /**
+         * Index of the next free slot, written by the producer.
+         */
+        std::atomic<size_t> tail_;
+
+        std::atomic<unsigned long> drops_;
+
+        std::atomic<size_t> high_water_mark_;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_STRING_POOL_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_STRING_POOL_H
+
+#include <stddef.h>
+
+#include <string>
+#include <unordered_map>
+
+/**
+ * Interned strings, each distinct value stored once.
+ *
+ * The descriptions of objects and locations and the team names repeat
+ * across the items and orders of a broadcast and across broadcasts. The
+ * caches keep a handle per string instead of a copy; two handles of the
+ * same pool are equal if and only if their strings are. Strings are
+ * reference counted and freed when their last handle is released.
+ * Not thread-safe.
+ */
+class StringPool
+{
+    public:
+        /**
+         * Points to the pooled string, stable until its last release.
+         */
+        typedef const std::string *Handle;
+
+        /**
+         * Ctor.
+         */
+        StringPool();
+
+        /**
+         * Handle of value, adding a reference to it.
+         */
+        Handle intern(const std::string &value);
+
+        /**
+         * Drop a reference taken by intern.
+         */
+        void release(Handle handle);
+
+        /**
+         * Replace the string of handle by value if they differ, returns
+         * true if they did.
+         */
+        bool assign(Handle &handle, const std::string &value);
+
+        /**
+         * Number of distinct strings.
+         */
+        size_t size() const;
+
+        /**
+         * Number of references to all strings.
+         */
+        unsigned long references() const;
+
+    private:
+        /**
+         * Copy Ctor.
+         */
+        StringPool(const StringPool &other);
+
+        /**
+         * Assignment operator
+         */
+        StringPool &operator=(const StringPool &other);
+
+        /**
+         * Reference counts by value, elements keep their address when the
+         * map rehashes.
+         */
+        typedef std::unordered_map<std::string, unsigned long> StringMap;
+
+        StringMap strings_;
+
+        unsigned long references_;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_TOPIC_QOS_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_TOPIC_QOS_H
+
+#include <chrono>
+
+/**
+ * Queueing and rate limit of one of the bridge's topics.
+ */
+struct TopicQos
+{
+    /**
+     * Queue size passed to advertise or subscribe, already 1 for
+     * keep-latest topics.
+     */
+    int queue_size;
+
+    /**
+     * Keep only the newest message instead of queueing all of them.
+     */
+    bool keep_latest;
+
+    /**
+     * Maximum sustained rate in Hz of the messages sent to the refbox,
+     * zero for no limit. Only used for the subscribed topics.
+     */
+    double max_rate;
+
+    /**
+     * Number of messages which may be sent at once above max_rate.
+     */
+    double burst;
+};
+
+/**
+ * Token bucket limiting the rate of messages sent from one subscriber.
+ *
+ * Not thread-safe; ROS does not run the callbacks of a subscription
+ * concurrently, so each subscription has its own limiter.
+ */
+class RateLimiter
+{
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        /**
+         * Ctor, lets everything pass until it is configured.
+         */
+        RateLimiter();
+
+        /**
+         * Allow rate messages per second on average and burst messages at
+         * once, a rate of zero disables the limit.
+         */
+        void configure(double rate, double burst);
+
+        /**
+         * Take a token, returns false if the message has to be dropped.
+         */
+        bool tryAcquire(Clock::time_point now);
+
+    private:
+        double rate_;
+
+        double burst_;
+
+        double tokens_;
+
+        Clock::time_point last_;
+};
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_TRAFFIC_CAPTURE_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_TRAFFIC_CAPTURE_H
+
+#include <google/protobuf/message.h>
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+
+/**
+ * Capture files of received refbox traffic.
+ *
+ * A capture starts with an 8 byte magic and the wall-clock start time in
+ * nanoseconds, followed by one record per message: a fixed-size header
+ * with the receive time in nanoseconds since the start, the payload
+ * length, component id, message type and peer, then the serialized
+ * message. All fields are in host byte order.
+ */
+namespace traffic_capture
+{
+    /**
+     * Peer a message was received by.
+     */
+    enum Peer
+    {
+        PUBLIC = 0,
+        TEAM = 1
+    };
+
+    struct Record
+    {
+        /**
+         * Receive time in nanoseconds since the capture started.
+         */
+        int64_t time;
+
+        uint16_t component_id;
+
+        uint16_t msg_type;
+
+        Peer peer;
+
+        /**
+         * Serialized message.
+         */
+        std::string payload;
+    };
+}
+
+/**
+ * Writes received messages to a capture file.
+ *
+ * Not thread-safe, meant to be called from the dispatch thread only.
+ */
+class TrafficCapture
+{
+    public:
+        /**
+         * Ctor.
+         */
+        TrafficCapture();
+
+        /**
+         * Dtor, flushes and closes the file.
+         */
+        ~TrafficCapture();
+
+        /**
+         * Create the capture file, start_time is the steady-clock time in
+         * nanoseconds the record times are relative to.
+         */
+        bool open(const std::string &path, int64_t start_time);
+
+        /**
+         * Append a message received at the steady-clock time receive_time.
+         */
+        bool write(traffic_capture::Peer peer, uint16_t component_id, uint16_t msg_type,
+                   int64_t receive_time, const google::protobuf::Message &msg);
+
+        /**
+         * Write the buffered messages to the file.
+         */
+        bool flush();
+
+        /**
+         * Number of messages written.
+         */
+        unsigned long count() const;
+
+        const std::string &error() const;
+
+    private:
+        /**
+         * Copy Ctor.
+         */
+        TrafficCapture(const TrafficCapture &other);
+
+        /**
+         * Assignment operator
+         */
+        TrafficCapture &operator=(const TrafficCapture &other);
+
+        FILE *file_;
+
+        int64_t start_time_;
+
+        /**
+         * Serialization buffer, reused for every message.
+         */
+        std::string buffer_;
+
+        unsigned long count_;
+
+        std::string error_;
+};
+
+/**
+ * Reads the records of a capture file in order.
+ */
+class TrafficReplay
+{
+    public:
+        /**
+         * Ctor.
+         */
+        TrafficReplay();
+
+        /**
+         * Dtor.
+         */
+        ~TrafficReplay();
+
+        bool open(const std::string &path);
+
+        /**
+         * Read the next record, returns false at the end of the capture or
+         * at a truncated record.
+         */
+        bool next(traffic_capture::Record &record);
+
+        /**
+         * Wall-clock time in nanoseconds when the capture started.
+         */
+        int64_t startTime() const;
+
+        const std::string &error() const;
+
+    private:
+        /**
+         * Copy Ctor.
+         */
+        TrafficReplay(const TrafficReplay &other);
+
+        /**
+         * Assignment operator
+         */
+        TrafficReplay &operator=(const TrafficReplay &other);
+
+        FILE *file_;
+
+        int64_t start_time_;
+
+        std::string error_;
+};
+
+#endif
@@ -0,0 +1,258 @@
+#ifndef AT_WORK_ROBOT_EXAMPLE_ROS_TRANSACTION_SEQUENCER_H
+#define AT_WORK_ROBOT_EXAMPLE_ROS_TRANSACTION_SEQUENCER_H
+
+#include <rockin_msgs/Inventory.pb.h>
+
+#include <stdint.h>
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * Sends inventory transactions in order and makes sure each one arrives.
+ *
+ * The refbox expects transaction ids to start at 1 and to increase by 1.
+ * Transactions without an id get the next one, transactions with an
+ * unexpected id are counted as a gap and renumbered so that the refbox log
+ * stays contiguous.
+ *
+ * The refbox does not acknowledge transactions, so a transaction counts as
+ * confirmed once an inventory broadcast shows its effect: the quantity of
+ * the object at the destination for INSERT and MOVE, at the source for
+ * REMOVE, reaches the one expected after it and the earlier transactions in
+ * flight on the same object and location were applied to the last inventory
+ * before it was first sent. No quantity is expected below zero, so a REMOVE
+ * from an empty location is confirmed by it staying empty. A transaction
+ * which would change a quantity in the other direction than one in flight
+ * waits until that one is confirmed, as the quantity could not tell them
+ * apart. As the refbox applies
+ * transactions in order, a confirmation also confirms all earlier
+ * transactions. Nothing is sent before the first inventory arrived, which
+ * is also the baseline of restored transactions.
+ *
+ * At most window transactions are in flight. Queued transactions are sent
+ * in one batch per call of sendCycle(), unconfirmed ones are retransmitted
+ * with exponential backoff and given up after max_attempts sends.
+ *
+ * All methods are thread-safe.
+ */
+class TransactionSequencer
+{
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        /**
+         * Called to put a transaction on the wire, with the sequencer locked.
+         */
+        typedef std::function<void (rockin_msgs::Transaction &transaction)> Sender;
+
+        /**
+         * Called with the sequencer locked when a transaction got its id and
+         * before it can be sent, and when it was confirmed or given up.
+         */
+        typedef std::function<void (const rockin_msgs::Transaction &transaction)> SubmitHandler;
+
+        typedef std::function<void (uint64_t transaction_id, bool confirmed)> CompletionHandler;
+
+        struct Config
+        {
+            /**
+             * Ctor.
+             */
+            Config();
+
+            /**
+             * Maximum number of unconfirmed transactions on the wire.
+             */
+            size_t window;
+
+            /**
+             * Time until the first retransmission, doubled for each further one.
+             */
+            Clock::duration retransmit_timeout;
+
+            Clock::duration max_retransmit_timeout;
+
+            /**
+             * Number of sends after which an unconfirmed transaction is given
+             * up, zero retransmits forever.
+             */
+            unsigned int max_attempts;
+        };
+
+        struct Statistics
+        {
+            unsigned long submitted;
+
+            unsigned long sent;
+
+            unsigned long retransmitted;
+
+            unsigned long confirmed;
+
+            unsigned long given_up;
+
+            /**
+             * Transactions which arrived with an unexpected id.
+             */
+            unsigned long gaps;
+
+            /**
+             * Transactions queued or in flight.
+             */
+            size_t queued;
+
+            size_t in_flight;
+        };
+
+        /**
+         * Ctor.
+         */
+        TransactionSequencer(const Config &config, const Sender &sender);
+
+        /**
+         * Set the handlers, must be called before the first transaction.
+         */
+        void onSubmit(const SubmitHandler &handler);
+
+        void onCompletion(const CompletionHandler &handler);
+
+        /**
+         * Queue a transaction for the next send cycle.
+         *
+         * Returns the transaction id it is sent with.
+         */
+        uint64_t submit(const rockin_msgs::Transaction &transaction);
+
+        /**
+         * Queue a transaction which already got its id before a restart.
+         *
+         * The submit handler is not called and the transaction does not
+         * count as a gap.
+         */
+        void restore(const rockin_msgs::Transaction &transaction);
+
+        /**
+         * Confirm the transactions whose effect the inventory shows.
+         */
+        void handleInventory(const rockin_msgs::Inventory &inventory);
+
+        /**
+         * Send queued transactions while the window allows and retransmit
+         * the ones whose timeout expired.
+         */
+        void sendCycle(Clock::time_point now);
+
+        /**
+         * Id the next transaction without an id will get.
+         */
+        uint64_t nextTransactionId() const;
+
+        /**
+         * Continue numbering at id, e.g. after a restart.
+         */
+        void setNextTransactionId(uint64_t id);
+
+        Statistics statistics() const;
+
+    private:
+        struct Entry
+        {
+            rockin_msgs::Transaction transaction;
+
+            /**
+             * Quantity of the object at the checked location once this and
+             * all earlier transactions in flight were applied.
+             */
+            int64_t expected;
+
+            unsigned int attempts;
+
+            Clock::duration timeout;
+
+            Clock::time_point next_send;
+        };
+
+        /**
+         * Quantity of an object at a location in the last inventory.
+         */
+        struct Quantity
+        {
+            int object_type;
+
+            int64_t type_id;
+
+            int64_t instance_id;
+
+            int location_type;
+
+            int64_t location_instance_id;
+
+            uint64_t quantity;
+        };
+
+        /**
+         * Quantity of the object at the location in the last inventory.
+         */
+        int64_t quantityAt(const rockin_msgs::ObjectIdentifier &object,
+                           const rockin_msgs::LocationIdentifier &location) const;
+
+        /**
+         * Quantity expected once the first earlier transactions in flight
+         * and then the transaction were applied to the last inventory,
+         * never below zero.
+         */
+        int64_t expectedQuantity(const rockin_msgs::Transaction &transaction, size_t earlier) const;
+
+        /**
+         * True if a transaction in flight changes a quantity the transaction
+         * changes in the other direction.
+         */
+        bool conflictsInFlight(const rockin_msgs::Transaction &transaction) const;
+
+        /**
+         * True if the last inventory shows the effect of the transaction.
+         */
+        bool isConfirmed(const Entry &entry) const;
+
+        Entry &enqueue(const rockin_msgs::Transaction &transaction);
+
+        void send(Entry &entry, Clock::time_point now);
+
+        Config config_;
+
+        Sender sender_;
+
+        SubmitHandler submit_handler_;
+
+        CompletionHandler completion_handler_;
+
+        mutable std::mutex mutex_;
+
+        /**
+         * Transactions not sent yet, in id order.
+         */
+        std::deque<Entry> queued_;
+
+        /**
+         * Sent and unconfirmed transactions, in id order.
+         */
+        std::deque<Entry> in_flight_;
+
+        /**
+         * Quantities of the last inventory broadcast, the baseline for new
+         * transactions. Items without a location are left out.
+         */
+        std::vector<Quantity> quantities_;
+
+        bool inventory_seen_;
+
+        uint64_t next_id_;
+
+        Statistics statistics_;
+};
+
+#endif
@@ -0,0 +1,486 @@
+#include <ros/ros.h>
+#include <at_work_robot_example_ros/refbox_simulator.h>
+
+#include <rockin_msgs/BenchmarkFeedback.pb.h>
+#include <rockin_msgs/LoggingStatus.pb.h>
+#include <rockin_msgs/RobotStatusReport.pb.h>
+
+#include <at_work_robot_example_ros/BenchmarkFeedback.h>
+#include <at_work_robot_example_ros/BenchmarkState.h>
+#include <at_work_robot_example_ros/DrillingMachineCommand.h>
+#include <at_work_robot_example_ros/DrillingMachineStatus.h>
+#include <at_work_robot_example_ros/InventoryDelta.h>
+#include <at_work_robot_example_ros/LoggingStatus.h>
+#include <at_work_robot_example_ros/OrderInfoDelta.h>
+#include <at_work_robot_example_ros/RobotStatusReport.h>
+#include <at_work_robot_example_ros/Transaction.h>
+#include <at_work_robot_example_ros/TriggeredConveyorBeltCommand.h>
+#include <at_work_robot_example_ros/TriggeredConveyorBeltStatus.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+  /**
+   * Latency samples and message count of one channel.
+   */
+  class Channel
+  {
+    public:
+      Channel(const std::string &name):
+        name_(name), count_(0)
+      {
+      }
+
+      /**
+       * Remember the send time of a message.
+       */
+      void sent(unsigned long seq, double send_time)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        //forget messages which were never matched, e.g. dropped ones
+        if (pending_.size() > 10000) {
+          pending_.erase(pending_.begin());
+        }
+        pending_[seq] = send_time;
+      }
+
+      /**
+       * Match a received message with its send time.
+       */
+      void received(unsigned long seq, double receive_time, bool measuring)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        std::map<unsigned long, double>::iterator it = pending_.find(seq);
+        if (it == pending_.end()) {
+          return;
+        }
+
+        if (measuring) {
+          samples_.push_back(receive_time - it->second);
+          ++count_;
+        }
+        pending_.erase(it);
+      }
+
+      /**
+       * Count a message whose send time is carried in the message itself.
+       */
+      void timed(double send_time, double receive_time, bool measuring)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (measuring) {
+          samples_.push_back(receive_time - send_time);
+          ++count_;
+        }
+      }
+
+      /**
+       * Count a message which cannot be matched with its send time.
+       */
+      void counted(bool measuring)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (measuring) {
+          ++count_;
+        }
+      }
+
+      void report(double duration)
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (samples_.empty()) {
+          ROS_INFO("%-32s %8lu msgs %10.1f msgs/s", name_.c_str(), count_, count_ / duration);
+          return;
+        }
+
+        std::sort(samples_.begin(), samples_.end());
+
+        ROS_INFO("%-32s %8lu msgs %10.1f msgs/s  latency us: min %8.1f p50 %8.1f p90 %8.1f p99 %8.1f max %8.1f",
+                 name_.c_str(), count_, count_ / duration,
+                 samples_.front() * 1e6, percentile(0.5) * 1e6, percentile(0.9) * 1e6,
+                 percentile(0.99) * 1e6, samples_.back() * 1e6);
+      }
+
+    private:
+      double percentile(double p) const
+      {
+        return samples_[std::min(samples_.size() - 1, (size_t)(p * samples_.size()))];
+      }
+
+      std::string name_;
+
+      std::mutex mutex_;
+
+      std::map<unsigned long, double> pending_;
+
+      std::vector<double> samples_;
+
+      unsigned long count_;
+  };
+
+  /**
+   * Drives the bridge with a simulated refbox and measures the wire-to-publish
+   * latency of each published topic and the ROS-to-wire latency of each
+   * subscriber callback.
+   */
+  class BridgeBenchmark
+  {
+    public:
+      BridgeBenchmark(ros::NodeHandle &nh, const RefboxSimulator::Config &config):
+        simulator_(config),
+        measuring_(false),
+        command_seq_(0),
+        drilling_commands_received_(0),
+        logging_status_received_(0),
+        benchmark_state_("wire->benchmark_state"),
+        inventory_("wire->inventory_delta"),
+        order_info_("wire->order_info_delta"),
+        drill_machine_status_("wire->drill_machine_status"),
+        conveyor_belt_status_("wire->conveyor_belt_status"),
+        drilling_machine_command_("drilling_machine_command->wire"),
+        conveyor_belt_command_("conveyor_belt_command->wire"),
+        benchmark_feedback_("benchmark_feedback->wire"),
+        logging_status_("logging_status->wire"),
+        inventory_transaction_("inventory_transaction->wire"),
+        robot_status_report_("robot_status_report->wire")
+      {
+        std::string bridge_namespace;
+        nh.param<std::string>("bridge_namespace", bridge_namespace, "/robot_example_ros");
+        ros::NodeHandle bridge_nh(bridge_namespace);
+
+        ros::TransportHints hints = ros::TransportHints().tcpNoDelay();
+
+        benchmark_state_sub_ = bridge_nh.subscribe<at_work_robot_example_ros::BenchmarkState>(
+                      "benchmark_state", 1000, &BridgeBenchmark::benchmarkStateCB, this, hints);
+        inventory_delta_sub_ = bridge_nh.subscribe<at_work_robot_example_ros::InventoryDelta>(
+                      "inventory_delta", 1000, &BridgeBenchmark::inventoryDeltaCB, this, hints);
+        order_info_delta_sub_ = bridge_nh.subscribe<at_work_robot_example_ros::OrderInfoDelta>(
+                      "order_info_delta", 1000, &BridgeBenchmark::orderInfoDeltaCB, this, hints);
+        drill_machine_status_sub_ = bridge_nh.subscribe<at_work_robot_example_ros::DrillingMachineStatus>(
+                      "drill_machine_status", 1000, &BridgeBenchmark::drillMachineStatusCB, this, hints);
+        conveyor_belt_status_sub_ = bridge_nh.subscribe<at_work_robot_example_ros::TriggeredConveyorBeltStatus>(
+                      "conveyor_belt_status", 1000, &BridgeBenchmark::conveyorBeltStatusCB, this, hints);
+
+        drilling_machine_command_pub_ = bridge_nh.advertise<at_work_robot_example_ros::DrillingMachineCommand>(
+                      "drilling_machine_command", 1000);
+        conveyor_belt_command_pub_ = bridge_nh.advertise<at_work_robot_example_ros::TriggeredConveyorBeltCommand>(
+                      "conveyor_belt_command", 1000);
+        benchmark_feedback_pub_ = bridge_nh.advertise<at_work_robot_example_ros::BenchmarkFeedback>(
+                      "benchmark_feedback", 1000);
+        logging_status_pub_ = bridge_nh.advertise<at_work_robot_example_ros::LoggingStatus>(
+                      "logging_status", 1000);
+        inventory_transaction_pub_ = bridge_nh.advertise<at_work_robot_example_ros::Transaction>(
+                      "inventory_transaction", 1000);
+        robot_status_report_pub_ = bridge_nh.advertise<at_work_robot_example_ros::RobotStatusReport>(
+                      "robot_status_report", 1000);
+
+        simulator_.onBroadcast(boost::bind(&BridgeBenchmark::handleBroadcast, this, _1, _2, _3, _4));
+        simulator_.onCommand(boost::bind(&BridgeBenchmark::handleCommand, this, _1, _2, _3));
+      }
+
+      void start()
+      {
+        simulator_.start();
+      }
+
+      void startMeasuring()
+      {
+        measuring_ = true;
+      }
+
+      void stopMeasuring()
+      {
+        measuring_ = false;
+      }
+
+      /**
+       * Publish one message on each of the bridge's command topics.
+       */
+      void sendCommands()
+      {
+        unsigned long seq = ++command_seq_;
+        double now = RefboxSimulator::now();
+
+        at_work_robot_example_ros::DrillingMachineCommand drilling_machine_command;
+        drilling_machine_command.command.data = seq % 2;
+        drilling_machine_command_.sent(seq, now);
+        drilling_machine_command_pub_.publish(drilling_machine_command);
+
+        at_work_robot_example_ros::TriggeredConveyorBeltCommand conveyor_belt_command;
+        conveyor_belt_command.command.data = seq % 2;
+        conveyor_belt_command.next_cycle.data = seq;
+        conveyor_belt_command_.sent(seq, now);
+        conveyor_belt_command_pub_.publish(conveyor_belt_command);
+
+        at_work_robot_example_ros::BenchmarkFeedback benchmark_feedback;
+        benchmark_feedback.object_instance_name.data = std::to_string(seq);
+        benchmark_feedback_.sent(seq, now);
+        benchmark_feedback_pub_.publish(benchmark_feedback);
+
+        at_work_robot_example_ros::LoggingStatus logging_status;
+        logging_status.is_logging.data = true;
+        logging_status_.sent(seq, now);
+        logging_status_pub_.publish(logging_status);
+
+        at_work_robot_example_ros::Transaction transaction;
+        transaction.transaction_id.data = seq;
+        transaction.order_id.data = seq;
+        transaction.object.type.data = at_work_robot_example_ros::ObjectIdentifier::AX;
+        transaction.action.data = at_work_robot_example_ros::Transaction::MOVE;
+        transaction.source.type.data = at_work_robot_example_ros::LocationIdentifier::SH;
+        transaction.destination.type.data = at_work_robot_example_ros::LocationIdentifier::ROBOT;
+        inventory_transaction_.sent(seq, now);
+        inventory_transaction_pub_.publish(transaction);
+
+        at_work_robot_example_ros::RobotStatusReport robot_status_report;
+        robot_status_report.meta_data.data = std::to_string(seq);
+        robot_status_report_.sent(seq, now);
+        robot_status_report_pub_.publish(robot_status_report);
+      }
+
+      void report(double duration)
+      {
+        ROS_INFO("Bridge benchmark over %.1f s, %lu refbox broadcasts sent",
+                 duration, simulator_.sentCount());
+
+        benchmark_state_.report(duration);
+        inventory_.report(duration);
+        order_info_.report(duration);
+        drill_machine_status_.report(duration);
+        conveyor_belt_status_.report(duration);
+        drilling_machine_command_.report(duration);
+        conveyor_belt_command_.report(duration);
+        benchmark_feedback_.report(duration);
+        logging_status_.report(duration);
+        inventory_transaction_.report(duration);
+        robot_status_report_.report(duration);
+      }
+
+    private:
+      void handleBroadcast(uint16_t component_id, uint16_t msg_type,
+                           unsigned long seq, double send_time)
+      {
+        if (component_id == rockin_msgs::Inventory::COMP_ID
+            && msg_type == rockin_msgs::Inventory::MSG_TYPE) {
+          inventory_.sent(seq, send_time);
+        } else if (component_id == rockin_msgs::OrderInfo::COMP_ID
+                   && msg_type == rockin_msgs::OrderInfo::MSG_TYPE) {
+          order_info_.sent(seq, send_time);
+        } else if (component_id == rockin_msgs::TriggeredConveyorBeltStatus::COMP_ID
+                   && msg_type == rockin_msgs::TriggeredConveyorBeltStatus::MSG_TYPE) {
+          conveyor_belt_status_.sent(seq, send_time);
+        }
+      }
+
+      void handleCommand(uint16_t component_id, uint16_t msg_type,
+                         const google::protobuf::Message &msg)
+      {
+        double now = RefboxSimulator::now();
+
+        if (component_id != rockin_msgs::BenchmarkFeedback::COMP_ID) {
+          return;
+        }
+
+        //commands without a free field are matched in publishing order
+        switch (msg_type) {
+          case rockin_msgs::DrillingMachineCommand::MSG_TYPE:
+            drilling_machine_command_.received(++drilling_commands_received_, now, measuring_);
+            break;
+          case rockin_msgs::TriggeredConveyorBeltCommand::MSG_TYPE:
+            conveyor_belt_command_.received(
+                (unsigned long)static_cast<const rockin_msgs::TriggeredConveyorBeltCommand &>(msg).next_cycle(),
+                now, measuring_);
+            break;
+          case rockin_msgs::BenchmarkFeedback::MSG_TYPE:
+            benchmark_feedback_.received(
+                strtoul(static_cast<const rockin_msgs::BenchmarkFeedback &>(msg).object_instance_name().c_str(), NULL, 10),
+                now, measuring_);
+            break;
+          case rockin_msgs::LoggingStatus::MSG_TYPE:
+            logging_status_.received(++logging_status_received_, now, measuring_);
+            break;
+          case rockin_msgs::Transaction::MSG_TYPE:
+            inventory_transaction_.received(
+                (unsigned long)static_cast<const rockin_msgs::Transaction &>(msg).order_id(),
+                now, measuring_);
+            break;
+          case rockin_msgs::RobotStatus::MSG_TYPE:
+            robot_status_report_.received(
+                strtoul(static_cast<const rockin_msgs::RobotStatus &>(msg).meta_data().c_str(), NULL, 10),
+                now, measuring_);
+            break;
+        }
+      }
+
+      void benchmarkStateCB(const at_work_robot_example_ros::BenchmarkState::ConstPtr &msg)
+      {
+        benchmark_state_.timed(msg->benchmark_time.data.toSec(), RefboxSimulator::now(), measuring_);
+      }
+
+      void inventoryDeltaCB(const at_work_robot_example_ros::InventoryDelta::ConstPtr &msg)
+      {
+        double now = RefboxSimulator::now();
+
+        //the simulator counts the quantity of the first item
+        for (size_t i = 0; i < msg->changed.size(); i++) {
+          if (msg->changed[i].object.instance_id.data == 1) {
+            inventory_.received(msg->changed[i].quantity.data, now, measuring_);
+          }
+        }
+      }
+
+      void orderInfoDeltaCB(const at_work_robot_example_ros::OrderInfoDelta::ConstPtr &msg)
+      {
+        double now = RefboxSimulator::now();
+
+        //the simulator counts the delivered quantity of the first order
+        for (size_t i = 0; i < msg->changed.size(); i++) {
+          if (msg->changed[i].id.data == 1) {
+            order_info_.received(msg->changed[i].quantity_delivered.data, now, measuring_);
+          }
+        }
+      }
+
+      void drillMachineStatusCB(const at_work_robot_example_ros::DrillingMachineStatus::ConstPtr &msg)
+      {
+        drill_machine_status_.counted(measuring_);
+      }
+
+      void conveyorBeltStatusCB(const at_work_robot_example_ros::TriggeredConveyorBeltStatus::ConstPtr &msg)
+      {
+        conveyor_belt_status_.received(msg->cycle.data, RefboxSimulator::now(), measuring_);
+      }
+
+      RefboxSimulator simulator_;
+
+      bool measuring_;
+
+      unsigned long command_seq_;
+
+      unsigned long drilling_commands_received_;
+
+      unsigned long logging_status_received_;
+
+      Channel benchmark_state_;
+      Channel inventory_;
+      Channel order_info_;
+      Channel drill_machine_status_;
+      Channel conveyor_belt_status_;
+      Channel drilling_machine_command_;
+      Channel conveyor_belt_command_;
+      Channel benchmark_feedback_;
+      Channel logging_status_;
+      Channel inventory_transaction_;
+      Channel robot_status_report_;
+
+      ros::Subscriber benchmark_state_sub_;
+      ros::Subscriber inventory_delta_sub_;
+      ros::Subscriber order_info_delta_sub_;
+      ros::Subscriber drill_machine_status_sub_;
+      ros::Subscriber conveyor_belt_status_sub_;
+
+      ros::Publisher drilling_machine_command_pub_;
+      ros::Publisher conveyor_belt_command_pub_;
+      ros::Publisher benchmark_feedback_pub_;
+      ros::Publisher logging_status_pub_;
+      ros::Publisher inventory_transaction_pub_;
+      ros::Publisher robot_status_report_pub_;
+  };
+
+  RefboxSimulator::Config readSimulatorConfig(ros::NodeHandle &nh)
+  {
+    RefboxSimulator::Config config;
+    int port;
+
+    nh.param<std::string>("host_name", config.host_name, config.host_name);
+
+    //same parameter names as the bridge, so both can share a launch file
+    nh.param<int>("refbox_send_port", port, config.refbox_send_port);
+    config.refbox_send_port = port;
+    nh.param<int>("refbox_recv_port", port, config.refbox_recv_port);
+    config.refbox_recv_port = port;
+    nh.param<int>("team_send_port", port, config.team_send_port);
+    config.team_send_port = port;
+    nh.param<int>("team_recv_port", port, config.team_recv_port);
+    config.team_recv_port = port;
+
+    nh.param<std::string>("crypto_key", config.crypto_key, config.crypto_key);
+    nh.param<std::string>("cipher", config.cipher, config.cipher);
+
+    nh.param<double>("benchmark_state_rate", config.benchmark_state_rate, config.benchmark_state_rate);
+    nh.param<double>("inventory_rate", config.inventory_rate, config.inventory_rate);
+    nh.param<double>("order_info_rate", config.order_info_rate, config.order_info_rate);
+    nh.param<double>("drilling_machine_rate", config.drilling_machine_rate, config.drilling_machine_rate);
+    nh.param<double>("conveyor_belt_rate", config.conveyor_belt_rate, config.conveyor_belt_rate);
+
+    nh.param<int>("inventory_items", config.inventory_items, config.inventory_items);
+    nh.param<int>("orders", config.orders, config.orders);
+    nh.param<int>("description_length", config.description_length, config.description_length);
+    nh.param<int>("known_teams", config.known_teams, config.known_teams);
+
+    return config;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "bridge_benchmark");
+  ros::NodeHandle nh("~");
+
+  bool measure;
+  double warmup;
+  double duration;
+  double command_rate;
+
+  nh.param<bool>("measure", measure, true);
+  nh.param<double>("warmup", warmup, 2.0);
+  nh.param<double>("duration", duration, 10.0);
+  nh.param<double>("command_rate", command_rate, 10.0);
+
+  BridgeBenchmark benchmark(nh, readSimulatorConfig(nh));
+
+  ros::AsyncSpinner spinner(1);
+  spinner.start();
+
+  benchmark.start();
+
+  if (!measure) {
+    ROS_INFO("Simulated refbox is running!");
+    ros::waitForShutdown();
+    return 0;
+  }
+
+  ROS_INFO("Bridge benchmark is running, warming up for %.1f s", warmup);
+  ros::WallDuration(warmup).sleep();
+
+  benchmark.startMeasuring();
+
+  ros::WallTime start = ros::WallTime::now();
+  ros::WallRate command_loop(command_rate);
+
+  while (ros::ok() && (ros::WallTime::now() - start).toSec() < duration) {
+    benchmark.sendCommands();
+    command_loop.sleep();
+  }
+
+  //let the last messages arrive before reporting
+  ros::WallDuration(0.5).sleep();
+  benchmark.stopMeasuring();
+
+  benchmark.report((ros::WallTime::now() - start).toSec());
+
+  ros::shutdown();
+
+  return 0;
+}
@@ -0,0 +1,524 @@
+#include <at_work_robot_example_ros/clock_estimator.h>
+#include <at_work_robot_example_ros/converters.h>
+#include <at_work_robot_example_ros/order_index.h>
+#include <at_work_robot_example_ros/outbound_message.h>
+#include <at_work_robot_example_ros/snapshot_cache.h>
+
+#include <rockin_msgs/BeaconSignal.pb.h>
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace
+{
+  /**
+   * Every allocation of the process, counted by the operator new below.
+   */
+  std::atomic<unsigned long> allocations(0);
+  std::atomic<unsigned long> allocated_bytes(0);
+}
+
+void *operator new(size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+  void *p = malloc(size > 0 ? size : 1);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  free(p);
+}
+
+namespace
+{
+  /**
+   * Runs registered benchmarks in the manner of Google Benchmark: each body
+   * is repeated with growing iteration counts until a run takes at least
+   * min_time seconds, and the time, allocations and allocated bytes per
+   * iteration of that run are reported.
+   */
+  class Runner
+  {
+    public:
+      Runner(double min_time, const std::string &filter):
+        min_time_(min_time), filter_(filter)
+      {
+      }
+
+      /**
+       * Register a benchmark, body returns the size of the message it
+       * handled on the wire, zero if there is none.
+       */
+      void add(const std::string &name, const std::function<size_t ()> &body)
+      {
+        if (name.find(filter_) != std::string::npos) {
+          benchmarks_.push_back(Benchmark());
+          benchmarks_.back().name = name;
+          benchmarks_.back().body = body;
+        }
+      }
+
+      void run()
+      {
+        printf("%-58s %12s %10s %12s %10s %12s\n", "Benchmark", "ns/op", "allocs/op",
+               "alloc B/op", "wire B", "iterations");
+
+        for (size_t i = 0; i < benchmarks_.size(); i++) {
+          runOne(benchmarks_[i]);
+        }
+      }
+
+    private:
+      struct Benchmark
+      {
+        std::string name;
+
+        std::function<size_t ()> body;
+      };
+
+      void runOne(const Benchmark &benchmark)
+      {
+        // warm up caches, allocators and reused messages
+        size_t wire_bytes = benchmark.body();
+
+        unsigned long iterations = 1;
+
+        while (true) {
+          unsigned long start_allocations = allocations.load(std::memory_order_relaxed);
+          unsigned long start_bytes = allocated_bytes.load(std::memory_order_relaxed);
+          std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+          for (unsigned long i = 0; i < iterations; i++) {
+            benchmark.body();
+          }
+
+          double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+          if (elapsed >= min_time_ || iterations >= 1000000000UL) {
+            printf("%-58s %12.1f %10.2f %12.1f %10zu %12lu\n", benchmark.name.c_str(),
+                   elapsed * 1e9 / iterations,
+                   double(allocations.load(std::memory_order_relaxed) - start_allocations) / iterations,
+                   double(allocated_bytes.load(std::memory_order_relaxed) - start_bytes) / iterations,
+                   wire_bytes, iterations);
+            return;
+          }
+
+          // aim 40% beyond min_time, but grow at most tenfold per run
+          double factor = elapsed > 0 ? min_time_ * 1.4 / elapsed : 10.0;
+          iterations = static_cast<unsigned long>(iterations * std::min(std::max(factor, 2.0), 10.0));
+        }
+      }
+
+      double min_time_;
+
+      std::string filter_;
+
+      std::vector<Benchmark> benchmarks_;
+  };
+
+  std::string name(const char *base, const char *param, int value)
+  {
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "%s/%s:%i", base, param, value);
+    return buffer;
+  }
+
+  std::string name(const char *base, const char *param, int value, const char *param2, int value2)
+  {
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "%s/%s:%i/%s:%i", base, param, value, param2, value2);
+    return buffer;
+  }
+
+  std::string text(int length, int i)
+  {
+    // distinct values of the same length, as the refbox's descriptions are
+    std::string value(length, 'a' + i % 26);
+    return value;
+  }
+
+  void fillObject(rockin_msgs::ObjectIdentifier *object, int i, int description_length)
+  {
+    object->set_type(rockin_msgs::ObjectIdentifier::EM);
+    object->set_type_id(i % 7);
+    object->set_instance_id(i);
+    object->set_description(text(description_length, i));
+  }
+
+  void fillLocation(rockin_msgs::LocationIdentifier *location, int i, int description_length)
+  {
+    location->set_type(rockin_msgs::LocationIdentifier::SH);
+    location->set_instance_id(i % 5);
+    location->set_description(text(description_length, i));
+  }
+
+  rockin_msgs::Inventory inventory(int items, int description_length)
+  {
+    rockin_msgs::Inventory inventory;
+
+    for (int i = 0; i < items; i++) {
+      rockin_msgs::Item *item = inventory.add_items();
+      fillObject(item->mutable_object(), i, description_length);
+      item->set_quantity(i % 3 + 1);
+      fillObject(item->mutable_container(), i + 1, description_length);
+      fillLocation(item->mutable_location(), i, description_length);
+    }
+
+    return inventory;
+  }
+
+  rockin_msgs::OrderInfo orderInfo(int orders, int description_length)
+  {
+    rockin_msgs::OrderInfo order_info;
+
+    for (int i = 0; i < orders; i++) {
+      rockin_msgs::Order *order = order_info.add_orders();
+      order->set_id(i);
+      order->set_status(rockin_msgs::Order::OFFERED);
+      fillObject(order->mutable_object(), i, description_length);
+      fillObject(order->mutable_container(), i + 1, description_length);
+      order->set_quantity_delivered(0);
+      order->set_quantity_requested(i % 3 + 1);
+      fillLocation(order->mutable_destination(), i, description_length);
+      fillLocation(order->mutable_source(), i + 1, description_length);
+      order->set_processing_team(text(description_length, i));
+    }
+
+    return order_info;
+  }
+
+  void fillPose(geometry_msgs::Pose &pose)
+  {
+    pose.position.x = 1.0;
+    pose.position.y = 0.5;
+    pose.position.z = 0.1;
+    pose.orientation.w = 1.0;
+  }
+
+  /**
+   * Decode of the refbox's broadcasts, done by the peers on their socket
+   * threads, and the branches of handleMessage which convert them.
+   */
+  void addInbound(Runner &runner)
+  {
+    const int ITEMS[] = {10, 100, 1000};
+    const int ORDERS[] = {10, 100};
+    const int DESCRIPTIONS[] = {8, 32, 128};
+
+    for (size_t d = 0; d < sizeof(DESCRIPTIONS) / sizeof(DESCRIPTIONS[0]); d++) {
+      int description = DESCRIPTIONS[d];
+
+      for (size_t n = 0; n < sizeof(ITEMS) / sizeof(ITEMS[0]); n++) {
+        int items = ITEMS[n];
+
+        std::shared_ptr<rockin_msgs::Inventory> unchanged(new rockin_msgs::Inventory(inventory(items, description)));
+        std::shared_ptr<rockin_msgs::Inventory> changed(new rockin_msgs::Inventory(*unchanged));
+        changed->mutable_items(items / 2)->set_quantity(0);
+
+        std::shared_ptr<std::string> payload(new std::string(unchanged->SerializeAsString()));
+
+        runner.add(name("decode/Inventory", "items", items, "desc", description), [=]() -> size_t {
+          rockin_msgs::Inventory decoded;
+          decoded.ParseFromString(*payload);
+          return payload->size();
+        });
+
+        // a repeated broadcast, the common case
+        std::shared_ptr<InventoryCache> cache(new InventoryCache);
+        runner.add(name("handleInventory/unchanged", "items", items, "desc", description), [=]() -> size_t {
+          at_work_robot_example_ros::InventoryDeltaPtr delta(new at_work_robot_example_ros::InventoryDelta);
+          cache->update(*unchanged, *delta);
+          return payload->size();
+        });
+
+        // one item changes with every broadcast, the delta goes into the index
+        std::shared_ptr<InventoryCache> changing_cache(new InventoryCache);
+        std::shared_ptr<OrderIndex> index(new OrderIndex);
+        std::shared_ptr<bool> flip(new bool(false));
+        runner.add(name("handleInventory/changed", "items", items, "desc", description), [=]() -> size_t {
+          at_work_robot_example_ros::InventoryDeltaPtr delta(new at_work_robot_example_ros::InventoryDelta);
+          *flip = !*flip;
+          if (changing_cache->update(*flip ? *changed : *unchanged, *delta)) {
+            index->update(*delta);
+          }
+          return payload->size();
+        });
+
+        runner.add(name("snapshot/Inventory", "items", items, "desc", description), [=]() -> size_t {
+          at_work_robot_example_ros::InventoryPtr snapshot(new at_work_robot_example_ros::Inventory);
+          cache->snapshot(*snapshot);
+          return payload->size();
+        });
+      }
+
+      for (size_t n = 0; n < sizeof(ORDERS) / sizeof(ORDERS[0]); n++) {
+        int orders = ORDERS[n];
+
+        std::shared_ptr<rockin_msgs::OrderInfo> unchanged(new rockin_msgs::OrderInfo(orderInfo(orders, description)));
+        std::shared_ptr<rockin_msgs::OrderInfo> changed(new rockin_msgs::OrderInfo(*unchanged));
+        changed->mutable_orders(orders / 2)->set_quantity_delivered(1);
+
+        std::shared_ptr<std::string> payload(new std::string(unchanged->SerializeAsString()));
+
+        runner.add(name("decode/OrderInfo", "orders", orders, "desc", description), [=]() -> size_t {
+          rockin_msgs::OrderInfo decoded;
+          decoded.ParseFromString(*payload);
+          return payload->size();
+        });
+
+        std::shared_ptr<OrderInfoCache> cache(new OrderInfoCache);
+        runner.add(name("handleOrderInfo/unchanged", "orders", orders, "desc", description), [=]() -> size_t {
+          at_work_robot_example_ros::OrderInfoDeltaPtr delta(new at_work_robot_example_ros::OrderInfoDelta);
+          cache->update(*unchanged, *delta);
+          return payload->size();
+        });
+
+        std::shared_ptr<OrderInfoCache> changing_cache(new OrderInfoCache);
+        std::shared_ptr<OrderIndex> index(new OrderIndex);
+        std::shared_ptr<bool> flip(new bool(false));
+        runner.add(name("handleOrderInfo/changed", "orders", orders, "desc", description), [=]() -> size_t {
+          at_work_robot_example_ros::OrderInfoDeltaPtr delta(new at_work_robot_example_ros::OrderInfoDelta);
+          *flip = !*flip;
+          if (changing_cache->update(*flip ? *changed : *unchanged, *delta)) {
+            index->update(*delta);
+          }
+          return payload->size();
+        });
+
+        runner.add(name("snapshot/OrderInfo", "orders", orders, "desc", description), [=]() -> size_t {
+          at_work_robot_example_ros::OrderInfoPtr snapshot(new at_work_robot_example_ros::OrderInfo);
+          cache->snapshot(*snapshot);
+          return payload->size();
+        });
+      }
+
+      std::shared_ptr<rockin_msgs::AttentionMessage> attention(new rockin_msgs::AttentionMessage);
+      attention->set_message(text(description, 0));
+      attention->set_time_to_show(5.0);
+      attention->set_team(text(description, 1));
+      size_t attention_bytes = attention->SerializeAsString().size();
+      runner.add(name("handleAttentionMessage", "desc", description), [=]() -> size_t {
+        at_work_robot_example_ros::AttentionMessagePtr msg(new at_work_robot_example_ros::AttentionMessage);
+        converters::toRos(*attention, *msg);
+        return attention_bytes;
+      });
+
+      std::shared_ptr<rockin_msgs::BenchmarkState> benchmark_state(new rockin_msgs::BenchmarkState);
+      benchmark_state->mutable_benchmark_time()->set_sec(42);
+      benchmark_state->mutable_benchmark_time()->set_nsec(0);
+      benchmark_state->set_state(rockin_msgs::BenchmarkState::RUNNING);
+      benchmark_state->set_phase(rockin_msgs::BenchmarkState::EXECUTION);
+      benchmark_state->mutable_scenario()->set_type(rockin_msgs::BenchmarkScenario::TBM);
+      benchmark_state->mutable_scenario()->set_type_id(1);
+      benchmark_state->mutable_scenario()->set_description(text(description, 2));
+      for (int i = 0; i < 8; i++) {
+        benchmark_state->add_known_teams(text(description, i));
+        benchmark_state->add_connected_teams(text(description, i));
+      }
+      size_t benchmark_state_bytes = benchmark_state->SerializeAsString().size();
+      runner.add(name("handleBenchmarkState", "desc", description, "teams", 8), [=]() -> size_t {
+        at_work_robot_example_ros::BenchmarkStatePtr msg(new at_work_robot_example_ros::BenchmarkState);
+        converters::toRos(*benchmark_state, *msg);
+        return benchmark_state_bytes;
+      });
+    }
+
+    std::shared_ptr<rockin_msgs::DrillingMachineStatus> drill_status(new rockin_msgs::DrillingMachineStatus);
+    drill_status->set_state(rockin_msgs::DrillingMachineStatus::AT_TOP);
+    size_t drill_status_bytes = drill_status->SerializeAsString().size();
+    runner.add("handleDrillingMachineStatus", [=]() -> size_t {
+      at_work_robot_example_ros::DrillingMachineStatusPtr msg(new at_work_robot_example_ros::DrillingMachineStatus);
+      converters::toRos(*drill_status, *msg);
+      return drill_status_bytes;
+    });
+
+    std::shared_ptr<rockin_msgs::TriggeredConveyorBeltStatus> conveyor_status(
+                        new rockin_msgs::TriggeredConveyorBeltStatus);
+    conveyor_status->set_state(rockin_msgs::START);
+    conveyor_status->set_cycle(3);
+    size_t conveyor_status_bytes = conveyor_status->SerializeAsString().size();
+    runner.add("handleTriggeredConveyorBeltStatus", [=]() -> size_t {
+      at_work_robot_example_ros::TriggeredConveyorBeltStatusPtr msg(
+                        new at_work_robot_example_ros::TriggeredConveyorBeltStatus);
+      converters::toRos(*conveyor_status, *msg);
+      return conveyor_status_bytes;
+    });
+
+    std::shared_ptr<ClockEstimator> clock(new ClockEstimator);
+    std::shared_ptr<int64_t> beacon_time(new int64_t(0));
+    runner.add("handleBeaconSignal", [=]() -> size_t {
+      *beacon_time += 100000000;
+      clock->addSample(*beacon_time, *beacon_time + 1000000 + *beacon_time % 7919);
+      return 0;
+    });
+  }
+
+  /**
+   * The subscriber callbacks: fill the reused outbound message and
+   * serialize it as the team peer does before sending.
+   */
+  void addOutbound(Runner &runner)
+  {
+    const int DESCRIPTIONS[] = {8, 32, 128};
+
+    for (size_t d = 0; d < sizeof(DESCRIPTIONS) / sizeof(DESCRIPTIONS[0]); d++) {
+      int description = DESCRIPTIONS[d];
+
+      std::shared_ptr<OutboundMessage<rockin_msgs::RobotStatus> > robot_status_out(
+                        new OutboundMessage<rockin_msgs::RobotStatus>);
+      std::shared_ptr<at_work_robot_example_ros::RobotStatusReport> robot_status(
+                        new at_work_robot_example_ros::RobotStatusReport);
+      robot_status->capability.data = at_work_robot_example_ros::RobotStatusReport::NAVIGATION;
+      robot_status->functionality.data = text(description, 0);
+      robot_status->meta_data.data = text(description, 1);
+      std::shared_ptr<std::string> buffer(new std::string);
+
+      runner.add(name("RobotStatusReportCB", "desc", description), [=]() -> size_t {
+        OutboundMessage<rockin_msgs::RobotStatus>::Lease msg(*robot_status_out);
+        converters::toProtobuf(*robot_status, *msg);
+        msg->SerializeToString(buffer.get());
+        return buffer->size();
+      });
+
+      std::shared_ptr<OutboundMessage<rockin_msgs::Transaction> > transaction_out(
+                        new OutboundMessage<rockin_msgs::Transaction>);
+      std::shared_ptr<at_work_robot_example_ros::Transaction> transaction(
+                        new at_work_robot_example_ros::Transaction);
+      transaction->transaction_id.data = 42;
+      transaction->order_id.data = 7;
+      transaction->object.type.data = rockin_msgs::ObjectIdentifier::EM;
+      transaction->object.type_id.data = 1;
+      transaction->object.description.data = text(description, 0);
+      transaction->quantity.data = 1;
+      transaction->action.data = rockin_msgs::Transaction::MOVE;
+      transaction->source.type.data = rockin_msgs::LocationIdentifier::SH;
+      transaction->source.description.data = text(description, 1);
+      transaction->destination.type.data = rockin_msgs::LocationIdentifier::WS;
+      transaction->destination.description.data = text(description, 2);
+
+      runner.add(name("InventoryTransactionCB", "desc", description), [=]() -> size_t {
+        OutboundMessage<rockin_msgs::Transaction>::Lease msg(*transaction_out);
+        converters::toProtobuf(*transaction, *msg);
+        msg->SerializeToString(buffer.get());
+        return buffer->size();
+      });
+
+      std::shared_ptr<OutboundMessage<rockin_msgs::BenchmarkFeedback> > feedback_out(
+                        new OutboundMessage<rockin_msgs::BenchmarkFeedback>);
+      std::shared_ptr<at_work_robot_example_ros::BenchmarkFeedback> feedback(
+                        new at_work_robot_example_ros::BenchmarkFeedback);
+      feedback->phase_to_terminate.data = rockin_msgs::BenchmarkState::EXECUTION;
+      feedback->object_class_name.data = text(description, 0);
+      feedback->object_instance_name.data = text(description, 1);
+      feedback->assembly_aid_tray_id.data = text(description, 2);
+      feedback->container_id.data = text(description, 3);
+      feedback->grasp_notification.data = true;
+      feedback->plate_state_after_receiving.data = at_work_robot_example_ros::BenchmarkFeedback::PERFECT;
+      feedback->plate_state_after_drilling.data = at_work_robot_example_ros::BenchmarkFeedback::FAULTY;
+      fillPose(feedback->object_pose);
+      fillPose(feedback->end_effector_pose);
+
+      runner.add(name("BenchmarkFeedbackCB", "desc", description), [=]() -> size_t {
+        OutboundMessage<rockin_msgs::BenchmarkFeedback>::Lease msg(*feedback_out);
+        converters::toProtobuf(*feedback, *msg);
+        msg->SerializeToString(buffer.get());
+        return buffer->size();
+      });
+    }
+
+    std::shared_ptr<std::string> buffer(new std::string);
+
+    std::shared_ptr<OutboundMessage<rockin_msgs::LoggingStatus> > logging_status_out(
+                        new OutboundMessage<rockin_msgs::LoggingStatus>);
+    std::shared_ptr<at_work_robot_example_ros::LoggingStatus> logging_status(
+                        new at_work_robot_example_ros::LoggingStatus);
+    logging_status->is_logging.data = true;
+
+    runner.add("LoggingStatusCB", [=]() -> size_t {
+      OutboundMessage<rockin_msgs::LoggingStatus>::Lease msg(*logging_status_out);
+      converters::toProtobuf(*logging_status, *msg);
+      msg->SerializeToString(buffer.get());
+      return buffer->size();
+    });
+
+    std::shared_ptr<OutboundMessage<rockin_msgs::DrillingMachineCommand> > drill_out(
+                        new OutboundMessage<rockin_msgs::DrillingMachineCommand>);
+
+    runner.add("DrillingMachineCommandCB", [=]() -> size_t {
+      OutboundMessage<rockin_msgs::DrillingMachineCommand>::Lease msg(*drill_out);
+      msg->set_command(rockin_msgs::DrillingMachineCommand::MOVE_DOWN);
+      msg->SerializeToString(buffer.get());
+      return buffer->size();
+    });
+
+    std::shared_ptr<OutboundMessage<rockin_msgs::TriggeredConveyorBeltCommand> > conveyor_out(
+                        new OutboundMessage<rockin_msgs::TriggeredConveyorBeltCommand>);
+
+    runner.add("TriggeredConveyorBeltCommandCB", [=]() -> size_t {
+      OutboundMessage<rockin_msgs::TriggeredConveyorBeltCommand>::Lease msg(*conveyor_out);
+      msg->set_command(rockin_msgs::START);
+      msg->set_next_cycle(4);
+      msg->SerializeToString(buffer.get());
+      return buffer->size();
+    });
+
+    std::shared_ptr<OutboundMessage<rockin_msgs::BeaconSignal> > beacon_out(
+                        new OutboundMessage<rockin_msgs::BeaconSignal>);
+    std::shared_ptr<unsigned long> seq(new unsigned long(0));
+
+    runner.add("sendBeacon", [=]() -> size_t {
+      OutboundMessage<rockin_msgs::BeaconSignal>::Lease msg(*beacon_out);
+      msg->mutable_time()->set_sec(1500000000);
+      msg->mutable_time()->set_nsec(123456789);
+      msg->set_peer_name("spqr");
+      msg->set_team_name("SPQR");
+      msg->set_seq(++*seq);
+      msg->SerializeToString(buffer.get());
+      return buffer->size();
+    });
+  }
+}
+
+int main(int argc, char **argv)
+{
+  // bridge_microbenchmark [--benchmark_filter=<substring>] [--benchmark_min_time=<seconds>]
+  std::string filter;
+  double min_time = 0.5;
+
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--benchmark_filter=", 19) == 0) {
+      filter = argv[i] + 19;
+    } else if (strncmp(argv[i], "--benchmark_min_time=", 21) == 0) {
+      min_time = atof(argv[i] + 21);
+    } else {
+      fprintf(stderr, "usage: %s [--benchmark_filter=<substring>] [--benchmark_min_time=<seconds>]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  Runner runner(min_time, filter);
+
+  addInbound(runner);
+  addOutbound(runner);
+
+  runner.run();
+
+  google::protobuf::ShutdownProtobufLibrary();
+
+  return 0;
+}
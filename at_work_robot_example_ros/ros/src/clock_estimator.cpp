@@ -0,0 +1,69 @@
+#include <at_work_robot_example_ros/clock_estimator.h>
+
+#include <cstdlib>
+
+ClockEstimator::ClockEstimator():
+    window_(64),
+    min_samples_(8)
+{
+    reset();
+}
+
+void ClockEstimator::configure(size_t window, size_t min_samples)
+{
+    window_ = window > 0 ? window : 1;
+    min_samples_ = min_samples;
+
+    reset();
+}
+
+void ClockEstimator::reset()
+{
+    count_ = 0;
+    minima_.clear();
+    last_remote_time_ = 0;
+    last_difference_ = 0;
+    jitter_ = 0.0;
+}
+
+void ClockEstimator::addSample(int64_t remote_time, int64_t local_time)
+{
+    if (count_ > 0 && remote_time < last_remote_time_) {
+        reset();
+    }
+
+    int64_t difference = local_time - remote_time;
+
+    //RFC 3550: change of the transit time between two messages, smoothed by 1/16
+    if (count_ > 0) {
+        int64_t transit_change = std::llabs(difference - last_difference_);
+        jitter_ += (transit_change - jitter_) / 16.0;
+    }
+
+    //the front is the minimum of the window, larger samples behind a smaller one never will be
+    while (!minima_.empty() && minima_.back().second >= difference) {
+        minima_.pop_back();
+    }
+    minima_.push_back(std::make_pair(count_, difference));
+
+    if (minima_.front().first + window_ <= count_) {
+        minima_.pop_front();
+    }
+
+    ++count_;
+    last_remote_time_ = remote_time;
+    last_difference_ = difference;
+}
+
+ClockEstimator::Estimate ClockEstimator::estimate() const
+{
+    Estimate estimate;
+
+    estimate.samples = count_ < window_ ? count_ : window_;
+    estimate.valid = count_ > 0 && estimate.samples >= min_samples_;
+    estimate.offset = minima_.empty() ? 0 : minima_.front().second;
+    estimate.delay = minima_.empty() ? 0 : last_difference_ - estimate.offset;
+    estimate.jitter = jitter_;
+
+    return estimate;
+}
@@ -0,0 +1,80 @@
+#include <at_work_robot_example_ros/command_tracker.h>
+
+CommandTracker::CommandTracker():
+    active_(false),
+    accepted_(false),
+    attempts_(0),
+    max_attempts_(0),
+    retry_timeout_(Clock::duration::zero())
+{
+}
+
+void CommandTracker::start(Clock::time_point now, Clock::duration timeout,
+                           Clock::duration retry_timeout, unsigned max_attempts)
+{
+    active_ = true;
+    accepted_ = false;
+    attempts_ = 1;
+    max_attempts_ = max_attempts;
+    retry_timeout_ = retry_timeout;
+    first_send_ = now;
+    last_send_ = now;
+    deadline_ = now + timeout;
+}
+
+void CommandTracker::cancel()
+{
+    active_ = false;
+}
+
+bool CommandTracker::active() const
+{
+    return active_;
+}
+
+CommandTracker::Event CommandTracker::status(bool accepted, bool reached)
+{
+    if (!active_) {
+        return NONE;
+    }
+
+    if (reached) {
+        active_ = false;
+        return SUCCEEDED;
+    }
+
+    accepted_ = accepted_ || accepted;
+
+    return NONE;
+}
+
+CommandTracker::Event CommandTracker::poll(Clock::time_point now)
+{
+    if (!active_) {
+        return NONE;
+    }
+
+    if (now >= deadline_) {
+        active_ = false;
+        return TIMED_OUT;
+    }
+
+    //a machine which reacted got the command, resending would only restart it
+    if (!accepted_ && attempts_ < max_attempts_ && now - last_send_ >= retry_timeout_) {
+        ++attempts_;
+        last_send_ = now;
+        return RESEND;
+    }
+
+    return NONE;
+}
+
+unsigned CommandTracker::attempts() const
+{
+    return attempts_;
+}
+
+CommandTracker::Clock::duration CommandTracker::elapsed(Clock::time_point now) const
+{
+    return now - first_send_;
+}
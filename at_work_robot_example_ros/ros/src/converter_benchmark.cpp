@@ -0,0 +1,205 @@
+#include <at_work_robot_example_ros/converters.h>
+#include <at_work_robot_example_ros/Inventory.h>
+#include <at_work_robot_example_ros/OrderInfo.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+  void fillObject(rockin_msgs::ObjectIdentifier *object, int i, const std::string &description)
+  {
+    object->set_type(rockin_msgs::ObjectIdentifier::EM);
+    object->set_type_id(i % 7);
+    object->set_instance_id(i);
+    object->set_description(description);
+  }
+
+  void fillLocation(rockin_msgs::LocationIdentifier *location, int i, const std::string &description)
+  {
+    location->set_type(rockin_msgs::LocationIdentifier::SH);
+    location->set_instance_id(i % 5);
+    location->set_description(description);
+  }
+
+  /**
+   * Field by field copies as handleMessage did them before the converters.
+   */
+  void handWrittenInventory(const rockin_msgs::Inventory &inventory, at_work_robot_example_ros::Inventory &inventory_msg)
+  {
+    inventory_msg.items.resize(inventory.items().size());
+
+    for (int i = 0; i < inventory.items().size(); i++) {
+      inventory_msg.items[i].object.type.data = inventory.items(i).object().type();
+      inventory_msg.items[i].object.type_id.data = inventory.items(i).object().type_id();
+      inventory_msg.items[i].object.instance_id.data = inventory.items(i).object().instance_id();
+      inventory_msg.items[i].object.description.data = inventory.items(i).object().description();
+      inventory_msg.items[i].quantity.data = inventory.items(i).quantity();
+      inventory_msg.items[i].container.type.data = inventory.items(i).container().type();
+      inventory_msg.items[i].container.type_id.data = inventory.items(i).container().type_id();
+      inventory_msg.items[i].container.instance_id.data = inventory.items(i).container().instance_id();
+      inventory_msg.items[i].container.description.data = inventory.items(i).container().description();
+      inventory_msg.items[i].location.type.data = inventory.items(i).location().type();
+      inventory_msg.items[i].location.instance_id.data = inventory.items(i).location().instance_id();
+      inventory_msg.items[i].location.description.data = inventory.items(i).location().description();
+    }
+  }
+
+  void handWrittenOrderInfo(const rockin_msgs::OrderInfo &order_info, at_work_robot_example_ros::OrderInfo &order_info_msg)
+  {
+    order_info_msg.orders.resize(order_info.orders().size());
+
+    for (int i = 0; i < order_info.orders().size(); i++) {
+      order_info_msg.orders[i].id.data = order_info.orders(i).id();
+      order_info_msg.orders[i].status.data = order_info.orders(i).status();
+      order_info_msg.orders[i].object.type.data = order_info.orders(i).object().type();
+      order_info_msg.orders[i].object.type_id.data = order_info.orders(i).object().type_id();
+      order_info_msg.orders[i].object.instance_id.data = order_info.orders(i).object().instance_id();
+      order_info_msg.orders[i].object.description.data = order_info.orders(i).object().description();
+      order_info_msg.orders[i].container.type.data = order_info.orders(i).container().type();
+      order_info_msg.orders[i].container.type_id.data = order_info.orders(i).container().type_id();
+      order_info_msg.orders[i].container.instance_id.data = order_info.orders(i).container().instance_id();
+      order_info_msg.orders[i].container.description.data = order_info.orders(i).container().description();
+      order_info_msg.orders[i].quantity_delivered.data = order_info.orders(i).quantity_delivered();
+      order_info_msg.orders[i].quantity_requested.data = order_info.orders(i).quantity_requested();
+      order_info_msg.orders[i].destination.type.data = order_info.orders(i).destination().type();
+      order_info_msg.orders[i].destination.instance_id.data = order_info.orders(i).destination().instance_id();
+      order_info_msg.orders[i].destination.description.data = order_info.orders(i).destination().description();
+      order_info_msg.orders[i].source.type.data = order_info.orders(i).source().type();
+      order_info_msg.orders[i].source.instance_id.data = order_info.orders(i).source().instance_id();
+      order_info_msg.orders[i].source.description.data = order_info.orders(i).source().description();
+      order_info_msg.orders[i].processing_team.data = order_info.orders(i).processing_team();
+    }
+  }
+
+  void handWrittenTransaction(const at_work_robot_example_ros::Transaction &msg, rockin_msgs::Transaction &transaction)
+  {
+    transaction.set_transaction_id(msg.transaction_id.data);
+    transaction.set_order_id(msg.order_id.data);
+
+    rockin_msgs::ObjectIdentifier *object = transaction.mutable_object();
+    object->set_type((rockin_msgs::ObjectIdentifier_ObjectType)msg.object.type.data);
+    object->set_type_id(msg.object.type_id.data);
+    object->set_instance_id(msg.object.instance_id.data);
+    object->set_description(msg.object.description.data);
+
+    transaction.set_quantity(msg.quantity.data);
+    transaction.set_action((rockin_msgs::Transaction_Action)msg.action.data);
+
+    rockin_msgs::LocationIdentifier *source = transaction.mutable_source();
+    source->set_type((rockin_msgs::LocationIdentifier_LocationType)msg.source.type.data);
+    source->set_instance_id(msg.source.instance_id.data);
+    source->set_description(msg.source.description.data);
+
+    rockin_msgs::LocationIdentifier *destination = transaction.mutable_destination();
+    destination->set_type((rockin_msgs::LocationIdentifier_LocationType)msg.destination.type.data);
+    destination->set_instance_id(msg.destination.instance_id.data);
+    destination->set_description(msg.destination.description.data);
+  }
+
+  /**
+   * Runs body iterations times and prints the time per iteration.
+   */
+  template <class Body>
+  void measure(const char *name, int iterations, Body body)
+  {
+    // warm up caches and allocators
+    for (int i = 0; i < iterations / 10 + 1; i++) {
+      body();
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      body();
+    }
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%-40s %10.1f ns\n", name, elapsed / iterations);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  // converter_benchmark [iterations] [entries] [description length]
+  int iterations = argc > 1 ? atoi(argv[1]) : 100000;
+  int entries = argc > 2 ? atoi(argv[2]) : 20;
+  int description_length = argc > 3 ? atoi(argv[3]) : 32;
+
+  // longer than the small string buffer, so copies allocate
+  std::string description(description_length, 'x');
+
+  rockin_msgs::Inventory inventory;
+  rockin_msgs::OrderInfo order_info;
+
+  for (int i = 0; i < entries; i++) {
+    rockin_msgs::Item *item = inventory.add_items();
+    fillObject(item->mutable_object(), i, description);
+    item->set_quantity(i);
+    fillObject(item->mutable_container(), i + 1, description);
+    fillLocation(item->mutable_location(), i, description);
+
+    rockin_msgs::Order *order = order_info.add_orders();
+    order->set_id(i);
+    order->set_status(rockin_msgs::Order::OFFERED);
+    fillObject(order->mutable_object(), i, description);
+    fillObject(order->mutable_container(), i + 1, description);
+    order->set_quantity_delivered(0);
+    order->set_quantity_requested(i);
+    fillLocation(order->mutable_destination(), i, description);
+    fillLocation(order->mutable_source(), i + 1, description);
+    order->set_processing_team(description);
+  }
+
+  at_work_robot_example_ros::Transaction transaction_msg;
+  converters::toRos(inventory.items(0).object(), transaction_msg.object);
+  converters::toRos(inventory.items(0).location(), transaction_msg.source);
+  converters::toRos(inventory.items(1).location(), transaction_msg.destination);
+  transaction_msg.action.data = rockin_msgs::Transaction::MOVE;
+
+  printf("%i iterations, %i entries, descriptions of %i characters\n\n",
+         iterations, entries, description_length);
+
+  measure("inventory, hand-written, new message", iterations, [&]() {
+    at_work_robot_example_ros::Inventory msg;
+    handWrittenInventory(inventory, msg);
+  });
+  measure("inventory, converters, new message", iterations, [&]() {
+    at_work_robot_example_ros::Inventory msg;
+    converters::toRos(inventory.items(), msg.items);
+  });
+
+  at_work_robot_example_ros::Inventory reused_inventory;
+  measure("inventory, converters, reused message", iterations, [&]() {
+    converters::toRos(inventory.items(), reused_inventory.items);
+  });
+
+  measure("order info, hand-written, new message", iterations, [&]() {
+    at_work_robot_example_ros::OrderInfo msg;
+    handWrittenOrderInfo(order_info, msg);
+  });
+  measure("order info, converters, new message", iterations, [&]() {
+    at_work_robot_example_ros::OrderInfo msg;
+    converters::toRos(order_info.orders(), msg.orders);
+  });
+
+  at_work_robot_example_ros::OrderInfo reused_order_info;
+  measure("order info, converters, reused message", iterations, [&]() {
+    converters::toRos(order_info.orders(), reused_order_info.orders);
+  });
+
+  rockin_msgs::Transaction transaction;
+  measure("transaction, hand-written", iterations, [&]() {
+    handWrittenTransaction(transaction_msg, transaction);
+    transaction.Clear();
+  });
+  measure("transaction, converters", iterations, [&]() {
+    converters::toProtobuf(transaction_msg, transaction);
+    transaction.Clear();
+  });
+
+  google::protobuf::ShutdownProtobufLibrary();
+
+  return 0;
+}
@@ -0,0 +1,288 @@
+#include <rockin_msgs/BeaconSignal.pb.h>
+#include <rockin_msgs/BenchmarkFeedback.pb.h>
+#include <rockin_msgs/ConveyorBelt.pb.h>
+#include <rockin_msgs/DrillingMachine.pb.h>
+#include <rockin_msgs/Inventory.pb.h>
+#include <rockin_msgs/LoggingStatus.pb.h>
+#include <rockin_msgs/RobotStatusReport.pb.h>
+
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+  /**
+   * Encrypts like the team peer: a random IV per message, sent in front of
+   * the cipher text. EVP uses the AES-NI implementation where the CPU has it.
+   *
+   * With reuse_context the key schedule is set up once and only the IV is
+   * reset per message, otherwise a context is created for every message.
+   */
+  class Cipher
+  {
+    public:
+      Cipher(const EVP_CIPHER *cipher, const std::string &key, bool reuse_context):
+        cipher_(cipher),
+        reuse_context_(reuse_context),
+        encrypt_ctx_(NULL),
+        decrypt_ctx_(NULL)
+      {
+        //derived once, as the peer does in setup_crypto
+        EVP_BytesToKey(cipher_, EVP_sha256(), NULL,
+                       reinterpret_cast<const unsigned char *>(key.data()), key.size(), 1,
+                       key_, NULL);
+
+        if (reuse_context_) {
+          encrypt_ctx_ = EVP_CIPHER_CTX_new();
+          decrypt_ctx_ = EVP_CIPHER_CTX_new();
+          EVP_EncryptInit_ex(encrypt_ctx_, cipher_, NULL, key_, NULL);
+          EVP_DecryptInit_ex(decrypt_ctx_, cipher_, NULL, key_, NULL);
+        }
+      }
+
+      ~Cipher()
+      {
+        EVP_CIPHER_CTX_free(encrypt_ctx_);
+        EVP_CIPHER_CTX_free(decrypt_ctx_);
+      }
+
+      void encrypt(const std::string &plain, std::string &encrypted)
+      {
+        int iv_length = EVP_CIPHER_iv_length(cipher_);
+        encrypted.resize(iv_length + plain.size() + EVP_CIPHER_block_size(cipher_));
+
+        unsigned char *iv = reinterpret_cast<unsigned char *>(&encrypted[0]);
+        if (iv_length > 0) {
+          RAND_bytes(iv, iv_length);
+        }
+
+        EVP_CIPHER_CTX *ctx = encrypt_ctx_;
+        if (reuse_context_) {
+          EVP_EncryptInit_ex(ctx, NULL, NULL, NULL, iv_length > 0 ? iv : NULL);
+        } else {
+          ctx = EVP_CIPHER_CTX_new();
+          EVP_EncryptInit_ex(ctx, cipher_, NULL, key_, iv_length > 0 ? iv : NULL);
+        }
+
+        unsigned char *out = iv + iv_length;
+        int length = 0;
+        int final_length = 0;
+
+        EVP_EncryptUpdate(ctx, out, &length,
+                          reinterpret_cast<const unsigned char *>(plain.data()), plain.size());
+        EVP_EncryptFinal_ex(ctx, out + length, &final_length);
+
+        if (!reuse_context_) {
+          EVP_CIPHER_CTX_free(ctx);
+        }
+
+        encrypted.resize(iv_length + length + final_length);
+      }
+
+      bool decrypt(const std::string &encrypted, std::string &plain)
+      {
+        int iv_length = EVP_CIPHER_iv_length(cipher_);
+        const unsigned char *iv = reinterpret_cast<const unsigned char *>(encrypted.data());
+
+        EVP_CIPHER_CTX *ctx = decrypt_ctx_;
+        if (reuse_context_) {
+          EVP_DecryptInit_ex(ctx, NULL, NULL, NULL, iv_length > 0 ? iv : NULL);
+        } else {
+          ctx = EVP_CIPHER_CTX_new();
+          EVP_DecryptInit_ex(ctx, cipher_, NULL, key_, iv_length > 0 ? iv : NULL);
+        }
+
+        plain.resize(encrypted.size());
+
+        unsigned char *out = reinterpret_cast<unsigned char *>(&plain[0]);
+        int length = 0;
+        int final_length = 0;
+
+        bool ok = EVP_DecryptUpdate(ctx, out, &length, iv + iv_length, encrypted.size() - iv_length)
+                  && EVP_DecryptFinal_ex(ctx, out + length, &final_length);
+
+        if (!reuse_context_) {
+          EVP_CIPHER_CTX_free(ctx);
+        }
+
+        plain.resize(length + final_length);
+
+        return ok;
+      }
+
+    private:
+      const EVP_CIPHER *cipher_;
+      bool reuse_context_;
+      unsigned char key_[EVP_MAX_KEY_LENGTH];
+      EVP_CIPHER_CTX *encrypt_ctx_;
+      EVP_CIPHER_CTX *decrypt_ctx_;
+  };
+
+  /**
+   * Runs body iterations times and returns the time per iteration in ns.
+   */
+  template <class Body>
+  double measure(int iterations, Body body)
+  {
+    // warm up caches and allocators
+    for (int i = 0; i < iterations / 10 + 1; i++) {
+      body();
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      body();
+    }
+
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+  }
+
+  bool hasAesInstructions()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_cpu_supports("aes");
+#else
+    return false;
+#endif
+  }
+
+  void fillPose(rockin_msgs::Pose3D *pose, double x, double y, double z)
+  {
+    pose->mutable_position()->set_x(x);
+    pose->mutable_position()->set_y(y);
+    pose->mutable_position()->set_z(z);
+
+    pose->mutable_orientation()->set_x(0.0);
+    pose->mutable_orientation()->set_y(0.0);
+    pose->mutable_orientation()->set_z(0.0);
+    pose->mutable_orientation()->set_w(1.0);
+  }
+
+  /**
+   * Serialized examples of the messages a robot sends on the team channel.
+   */
+  std::vector<std::pair<std::string, std::string> > teamMessages()
+  {
+    std::vector<std::pair<std::string, std::string> > messages;
+
+    rockin_msgs::BeaconSignal beacon_signal;
+    beacon_signal.mutable_time()->set_sec(1500000000);
+    beacon_signal.mutable_time()->set_nsec(123456789);
+    beacon_signal.set_seq(4711);
+    beacon_signal.set_team_name("SPQR");
+    beacon_signal.set_peer_name("spqr");
+    messages.push_back(std::make_pair(std::string("BeaconSignal"), beacon_signal.SerializeAsString()));
+
+    rockin_msgs::DrillingMachineCommand drilling_machine_command;
+    drilling_machine_command.set_command(rockin_msgs::DrillingMachineCommand::MOVE_DOWN);
+    messages.push_back(std::make_pair(std::string("DrillingMachineCommand"),
+                                      drilling_machine_command.SerializeAsString()));
+
+    rockin_msgs::TriggeredConveyorBeltCommand conveyor_belt_command;
+    conveyor_belt_command.set_command(rockin_msgs::START);
+    conveyor_belt_command.set_next_cycle(3);
+    messages.push_back(std::make_pair(std::string("TriggeredConveyorBeltCommand"),
+                                      conveyor_belt_command.SerializeAsString()));
+
+    rockin_msgs::LoggingStatus logging_status;
+    logging_status.set_is_logging(true);
+    messages.push_back(std::make_pair(std::string("LoggingStatus"), logging_status.SerializeAsString()));
+
+    rockin_msgs::RobotStatus robot_status;
+    robot_status.set_capability(rockin_msgs::RobotStatus::NAVIGATION);
+    robot_status.set_functionality("move_base");
+    robot_status.set_meta_data("goal reached at workstation 3");
+    messages.push_back(std::make_pair(std::string("RobotStatus"), robot_status.SerializeAsString()));
+
+    rockin_msgs::Transaction transaction;
+    transaction.set_transaction_id(42);
+    transaction.set_order_id(7);
+    transaction.mutable_object()->set_type(rockin_msgs::ObjectIdentifier::EM);
+    transaction.mutable_object()->set_type_id(1);
+    transaction.mutable_object()->set_description("bearing box");
+    transaction.set_quantity(1);
+    transaction.set_action(rockin_msgs::Transaction::MOVE);
+    transaction.mutable_source()->set_type(rockin_msgs::LocationIdentifier::SH);
+    transaction.mutable_source()->set_instance_id(1);
+    transaction.mutable_destination()->set_type(rockin_msgs::LocationIdentifier::WS);
+    transaction.mutable_destination()->set_instance_id(2);
+    messages.push_back(std::make_pair(std::string("Transaction"), transaction.SerializeAsString()));
+
+    rockin_msgs::BenchmarkFeedback benchmark_feedback;
+    benchmark_feedback.set_phase_to_terminate(rockin_msgs::BenchmarkState::EXECUTION);
+    benchmark_feedback.set_object_class_name("EM-01");
+    benchmark_feedback.set_object_instance_name("EM-01-01");
+    fillPose(benchmark_feedback.mutable_object_pose(), 1.0, 0.5, 0.1);
+    benchmark_feedback.set_grasp_notification(true);
+    fillPose(benchmark_feedback.mutable_end_effector_pose(), 1.0, 0.5, 0.3);
+    messages.push_back(std::make_pair(std::string("BenchmarkFeedback"), benchmark_feedback.SerializeAsString()));
+
+    return messages;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  // crypto_benchmark [iterations] [cipher]
+  int iterations = argc > 1 ? atoi(argv[1]) : 100000;
+  std::string cipher_name = argc > 2 ? argv[2] : "aes-128-cbc";
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+  OpenSSL_add_all_ciphers();
+#endif
+
+  const EVP_CIPHER *cipher = EVP_get_cipherbyname(cipher_name.c_str());
+  if (!cipher) {
+    fprintf(stderr, "Unknown cipher %s\n", cipher_name.c_str());
+    return 1;
+  }
+
+  printf("%i iterations, %s, AES instructions %s\n\n", iterations, cipher_name.c_str(),
+         hasAesInstructions() ? "available" : "not available");
+  printf("%-30s %6s %14s %14s %14s %14s\n", "", "bytes",
+         "encrypt (ns)", "reused (ns)", "decrypt (ns)", "reused (ns)");
+
+  Cipher per_message(cipher, "benchmark key", false);
+  Cipher reused(cipher, "benchmark key", true);
+
+  std::vector<std::pair<std::string, std::string> > messages = teamMessages();
+
+  for (size_t i = 0; i < messages.size(); i++) {
+    const std::string &plain = messages[i].second;
+    std::string encrypted;
+    std::string decrypted;
+
+    double encrypt = measure(iterations, [&]() {
+      per_message.encrypt(plain, encrypted);
+    });
+    double encrypt_reused = measure(iterations, [&]() {
+      reused.encrypt(plain, encrypted);
+    });
+
+    double decrypt = measure(iterations, [&]() {
+      per_message.decrypt(encrypted, decrypted);
+    });
+    double decrypt_reused = measure(iterations, [&]() {
+      reused.decrypt(encrypted, decrypted);
+    });
+
+    if (decrypted != plain) {
+      fprintf(stderr, "%s does not decrypt to its plain text\n", messages[i].first.c_str());
+      return 1;
+    }
+
+    printf("%-30s %6zu %14.1f %14.1f %14.1f %14.1f\n", messages[i].first.c_str(), plain.size(),
+           encrypt, encrypt_reused, decrypt, decrypt_reused);
+  }
+
+  google::protobuf::ShutdownProtobufLibrary();
+
+  return 0;
+}
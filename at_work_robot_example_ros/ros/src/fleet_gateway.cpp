@@ -0,0 +1,209 @@
+#include <at_work_robot_example_ros/fleet_gateway.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    int64_t steadyNow()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+FleetGateway::FleetGateway(const ros::NodeHandle &nh):
+    nh_(nh),
+    reconnect_backoff_(0),
+    last_reconnect_(0),
+    next_reconnect_(0),
+    health_send_errors_(0),
+    reconnects_(0),
+    public_socket_drops_(0),
+    send_errors_(0),
+    receive_errors_(0),
+    last_receive_(0)
+{
+    std::vector<std::string> robot_names;
+    nh_.param<std::vector<std::string> >("robots", robot_names, std::vector<std::string>());
+
+    if (robot_names.empty()) {
+        ROS_WARN("Gateway: no robots configured in %s/robots", nh_.getNamespace().c_str());
+    }
+
+    //each robot reads its parameters from its own namespace
+    for (size_t i = 0; i < robot_names.size(); i++) {
+        ros::NodeHandle robot_nh(nh_, robot_names[i]);
+
+        if (!robot_nh.hasParam("robot_name")) {
+            robot_nh.setParam("robot_name", robot_names[i]);
+        }
+
+        ROS_INFO("Gateway: starting robot %s", robot_names[i].c_str());
+
+        robots_.push_back(std::shared_ptr<RobotExampleROS>(new RobotExampleROS(robot_nh, true)));
+    }
+
+    int public_port;
+    int public_send_port;
+    int public_recv_port;
+
+    //the gateway only has the public peer, the robots have their own team peers
+    CFHClient::Config config;
+    config.team_peer = false;
+
+    nh_.param<bool>("remote_refbox", config.remote_refbox, false);
+    nh_.param<std::string>("host_name", config.host_name, "localhost");
+    nh_.param<int>("public_port", public_port, 4444);
+    nh_.param<int>("refbox_send_port", public_recv_port, 4444);
+    nh_.param<int>("refbox_recv_port", public_send_port, 4445);
+    nh_.param<int>("socket_receive_buffer", config.socket_receive_buffer, 0);
+    nh_.param<int>("socket_send_buffer", config.socket_send_buffer, 0);
+    nh_.param<double>("health_check_period", health_check_period_, 0.1);
+    nh_.param<double>("refbox_timeout", refbox_timeout_, 2.0);
+    nh_.param<double>("reconnect_backoff_min", reconnect_backoff_min_, 0.1);
+    nh_.param<double>("reconnect_backoff_max", reconnect_backoff_max_, 5.0);
+    nh_.param<double>("reconnect_send_error_rate", reconnect_send_error_rate_, 0.0);
+
+    config.public_port      = public_port;
+    config.public_send_port = public_send_port;
+    config.public_recv_port = public_recv_port;
+
+    client_.reset(new CFHClient(config));
+
+    client_->onReceive([this](CFHClient::Channel channel, uint16_t component_id, uint16_t msg_type,
+                              const std::shared_ptr<google::protobuf::Message> &msg) {
+                            receiveMessage(component_id, msg_type, msg);
+                        });
+    client_->onSendError([this](const std::string &msg) {
+                            handleSendError(msg);
+                        });
+    client_->onReceiveError([this](const std::string &msg) {
+                            handleReceiveError(msg);
+                        });
+
+    createPublicPeer();
+
+    //the robots only check their team peers, the public peer is checked here
+    if (health_check_period_ > 0) {
+        reconnect_backoff_ = reconnect_backoff_min_;
+        health_timer_ = nh_.createSteadyTimer(ros::WallDuration(health_check_period_),
+                        &FleetGateway::healthTimerCB, this);
+        ROS_INFO("Gateway health check: every %.2f s, refbox timeout %.1f s, send errors above %.1f Hz, "
+                 "backoff %.2f - %.1f s", health_check_period_, refbox_timeout_, reconnect_send_error_rate_,
+                 reconnect_backoff_min_, reconnect_backoff_max_);
+    }
+
+    ROS_INFO("Gateway: %zu robots share the public peer on %s", robots_.size(), config.host_name.c_str());
+}
+
+FleetGateway::~FleetGateway()
+{
+    health_timer_.stop();
+
+    ROS_INFO("Gateway: %lu datagrams dropped by the kernel on the public socket, "
+             "%lu send and %lu receive errors, %lu reconnects of the public peer",
+             public_socket_drops_ + client_->publicSockets().statistics().drops,
+             send_errors_.load(), receive_errors_.load(), reconnects_);
+
+    // Stop the shared producer before the robots
+    client_->stop();
+    robots_.clear();
+}
+
+size_t FleetGateway::size() const
+{
+    return robots_.size();
+}
+
+void FleetGateway::receiveMessage(uint16_t component_id, uint16_t msg_type,
+                    const std::shared_ptr<google::protobuf::Message> &msg)
+{
+    last_receive_.store(steadyNow(), std::memory_order_relaxed);
+
+    //the robots only read the message, so all of them share it
+    for (size_t i = 0; i < robots_.size(); i++) {
+        robots_[i]->receivePublicMessage(component_id, msg_type, msg);
+    }
+}
+
+void FleetGateway::createPublicPeer()
+{
+    client_->start();
+
+    //the bursts of all robots' broadcasts arrive on this one socket
+    if (!client_->socketError().empty()) {
+        ROS_WARN("Gateway %s", client_->socketError().c_str());
+    }
+}
+
+void FleetGateway::healthTimerCB(const ros::SteadyTimerEvent &event)
+{
+    int64_t now = steadyNow();
+
+    //other teams' traffic which cannot be decoded raises receive errors, only failed sends count
+    unsigned long send_errors = send_errors_.load(std::memory_order_relaxed);
+    int64_t last_receive = last_receive_.load(std::memory_order_relaxed);
+
+    //the timeout only counts once the refbox was heard, and restarts with every reconnect
+    const char *reason = NULL;
+
+    if (send_errors - health_send_errors_ > reconnect_send_error_rate_ * health_check_period_) {
+        reason = "send errors";
+    } else if (last_receive != 0
+               && now - std::max(last_receive, last_reconnect_) > refbox_timeout_ * 1e9) {
+        reason = "refbox timeout";
+    }
+
+    health_send_errors_ = send_errors;
+
+    if (!reason) {
+        if (last_receive > last_reconnect_) {
+            reconnect_backoff_ = reconnect_backoff_min_;
+        }
+        return;
+    }
+
+    if (now < next_reconnect_) {
+        return;
+    }
+
+    reconnectPublicPeer(reason);
+
+    last_reconnect_ = steadyNow();
+    next_reconnect_ = last_reconnect_ + static_cast<int64_t>(reconnect_backoff_ * 1e9);
+    reconnect_backoff_ = std::min(reconnect_backoff_ * 2, reconnect_backoff_max_);
+}
+
+void FleetGateway::reconnectPublicPeer(const char *reason)
+{
+    ROS_WARN("Gateway: recreating the public peer after %s", reason);
+
+    public_socket_drops_ += client_->publicSockets().statistics().drops;
+
+    client_->stop();
+
+    try {
+        createPublicPeer();
+    } catch (std::exception &e) {
+        //e.g. the interface is still down, the next attempt follows the backoff
+        ROS_WARN("Gateway: recreating the public peer failed: %s", e.what());
+        return;
+    }
+
+    ++reconnects_;
+}
+
+void FleetGateway::handleSendError(std::string msg)
+{
+    send_errors_.fetch_add(1, std::memory_order_relaxed);
+
+    ROS_WARN("Gateway send error: %s\n", msg.c_str());
+}
+
+void FleetGateway::handleReceiveError(std::string msg)
+{
+    receive_errors_.fetch_add(1, std::memory_order_relaxed);
+
+    ROS_WARN("Gateway recv error: %s\n", msg.c_str());
+}
@@ -0,0 +1,27 @@
+#include <ros/ros.h>
+#include <at_work_robot_example_ros/fleet_gateway.h>
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "fleet_gateway_node");
+  ros::NodeHandle nh("~");
+
+  int spinner_threads;
+  nh.param<int>("spinner_threads", spinner_threads, 2);
+
+  {
+    FleetGateway gateway(nh);
+
+    // the robots' callbacks and timers share the global callback queue
+    ros::AsyncSpinner spinner(spinner_threads);
+    spinner.start();
+
+    ROS_INFO("CFH fleet gateway is running with %zu robots!", gateway.size());
+
+    ros::waitForShutdown();
+  }
+
+  google::protobuf::ShutdownProtobufLibrary();
+
+  return 0;
+}
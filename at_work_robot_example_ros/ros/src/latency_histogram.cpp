@@ -0,0 +1,94 @@
+#include <at_work_robot_example_ros/latency_histogram.h>
+
+#include <algorithm>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram():
+    sum_(0),
+    max_(0)
+{
+    for (size_t i = 0; i < BUCKETS; i++) {
+        buckets_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::record(int64_t latency)
+{
+    uint64_t value = latency > 0 ? static_cast<uint64_t>(latency) : 0;
+
+    buckets_[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const
+{
+    uint64_t counts[BUCKETS];
+    uint64_t count = 0;
+
+    for (size_t i = 0; i < BUCKETS; i++) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        count += counts[i];
+    }
+
+    Summary summary;
+    summary.count = count;
+    summary.max = max_.load(std::memory_order_relaxed);
+    summary.mean = count > 0 ? static_cast<double>(sum_.load(std::memory_order_relaxed)) / count : 0.0;
+    summary.p50 = 0;
+    summary.p90 = 0;
+    summary.p99 = 0;
+
+    if (count == 0) {
+        return summary;
+    }
+
+    const double percentiles[3] = {0.5, 0.9, 0.99};
+    int64_t *results[3] = {&summary.p50, &summary.p90, &summary.p99};
+
+    uint64_t seen = 0;
+    size_t next = 0;
+    for (size_t i = 0; i < BUCKETS && next < 3; i++) {
+        seen += counts[i];
+
+        while (next < 3 && seen >= std::ceil(percentiles[next] * count)) {
+            *results[next] = std::min<int64_t>(bucketValue(i), summary.max);
+            ++next;
+        }
+    }
+
+    return summary;
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t value)
+{
+    const uint64_t sub_buckets = static_cast<uint64_t>(1) << SUB_BUCKET_BITS;
+
+    if (value < sub_buckets) {
+        return value;
+    }
+
+    value = std::min(value, (static_cast<uint64_t>(2) << MAX_EXPONENT) - 1);
+
+    int exponent = 63 - __builtin_clzll(value);
+    int shift = exponent - SUB_BUCKET_BITS;
+
+    return (static_cast<size_t>(shift + 1) << SUB_BUCKET_BITS) + ((value >> shift) - sub_buckets);
+}
+
+uint64_t LatencyHistogram::bucketValue(size_t index)
+{
+    const uint64_t sub_buckets = static_cast<uint64_t>(1) << SUB_BUCKET_BITS;
+
+    if (index < sub_buckets) {
+        return index;
+    }
+
+    int shift = static_cast<int>(index >> SUB_BUCKET_BITS) - 1;
+    uint64_t lowest = (sub_buckets + (index & (sub_buckets - 1))) << shift;
+
+    return lowest + (static_cast<uint64_t>(1) << shift) - 1;
+}
@@ -0,0 +1,100 @@
+#include <at_work_robot_example_ros/message_statistics.h>
+
+namespace
+{
+    uint32_t typeKey(uint16_t component_id, uint16_t msg_type)
+    {
+        return (static_cast<uint32_t>(component_id) << 16) | msg_type;
+    }
+}
+
+MessageStatistics::MessageStatistics():
+    send_errors_(0),
+    receive_errors_(0)
+{
+}
+
+void MessageStatistics::add(uint16_t component_id, uint16_t msg_type, const std::string &name)
+{
+    std::shared_ptr<TypeStatistics> &type = types_[typeKey(component_id, msg_type)];
+
+    if (!type) {
+        type.reset(new TypeStatistics);
+        type->name = name;
+        type->received = 0;
+        type->sent = 0;
+        type->rate_limited = 0;
+    }
+}
+
+void MessageStatistics::received(uint16_t component_id, uint16_t msg_type)
+{
+    TypeStatistics *type = find(component_id, msg_type);
+
+    if (type) {
+        type->received.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void MessageStatistics::published(uint16_t component_id, uint16_t msg_type,
+                                  int64_t receive_time, int64_t dispatch_time, int64_t publish_time)
+{
+    TypeStatistics *type = find(component_id, msg_type);
+
+    if (type) {
+        type->queue_latency.record(dispatch_time - receive_time);
+        type->publish_latency.record(publish_time - receive_time);
+    }
+}
+
+void MessageStatistics::sent(uint16_t component_id, uint16_t msg_type,
+                             int64_t callback_time, int64_t send_time)
+{
+    TypeStatistics *type = find(component_id, msg_type);
+
+    if (type) {
+        type->sent.fetch_add(1, std::memory_order_relaxed);
+        type->send_latency.record(send_time - callback_time);
+    }
+}
+
+void MessageStatistics::rateLimited(uint16_t component_id, uint16_t msg_type)
+{
+    TypeStatistics *type = find(component_id, msg_type);
+
+    if (type) {
+        type->rate_limited.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void MessageStatistics::sendError()
+{
+    send_errors_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MessageStatistics::receiveError()
+{
+    receive_errors_.fetch_add(1, std::memory_order_relaxed);
+}
+
+unsigned long MessageStatistics::sendErrors() const
+{
+    return send_errors_.load(std::memory_order_relaxed);
+}
+
+unsigned long MessageStatistics::receiveErrors() const
+{
+    return receive_errors_.load(std::memory_order_relaxed);
+}
+
+const MessageStatistics::TypeMap &MessageStatistics::types() const
+{
+    return types_;
+}
+
+MessageStatistics::TypeStatistics *MessageStatistics::find(uint16_t component_id, uint16_t msg_type) const
+{
+    TypeMap::const_iterator it = types_.find(typeKey(component_id, msg_type));
+
+    return it != types_.end() ? it->second.get() : NULL;
+}
@@ -0,0 +1,195 @@
+#include <at_work_robot_example_ros/order_index.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    bool isOpen(const at_work_robot_example_ros::Order &order)
+    {
+        return order.status.data == at_work_robot_example_ros::Order::OFFERED
+            || order.status.data == at_work_robot_example_ros::Order::IN_PROGRESS
+            || order.status.data == at_work_robot_example_ros::Order::PAUSED;
+    }
+}
+
+OrderIndex::OrderIndex()
+{
+}
+
+OrderIndex::ObjectClass OrderIndex::classOf(const at_work_robot_example_ros::ObjectIdentifier &object)
+{
+    return ObjectClass(object.type.data, object.type_id.data);
+}
+
+void OrderIndex::update(const at_work_robot_example_ros::InventoryDelta &delta)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (size_t i = 0; i < delta.removed.size(); i++) {
+        items_.erase(snapshot_cache::ItemKey::of(delta.removed[i]));
+    }
+
+    //changed items keep their key, only the quantity or descriptions differ
+    for (size_t i = 0; i < delta.changed.size(); i++) {
+        items_[snapshot_cache::ItemKey::of(delta.changed[i])] = delta.changed[i];
+    }
+
+    for (size_t i = 0; i < delta.added.size(); i++) {
+        items_[snapshot_cache::ItemKey::of(delta.added[i])] = delta.added[i];
+    }
+}
+
+void OrderIndex::update(const at_work_robot_example_ros::OrderInfoDelta &delta)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (size_t i = 0; i < delta.removed.size(); i++) {
+        removeOrder(delta.removed[i].id.data);
+    }
+
+    //the object of a changed order is looked up again in case it differs
+    for (size_t i = 0; i < delta.changed.size(); i++) {
+        removeOrder(delta.changed[i].id.data);
+        orders_[delta.changed[i].id.data] = delta.changed[i];
+        orders_by_class_.insert(std::make_pair(classOf(delta.changed[i].object), delta.changed[i].id.data));
+    }
+
+    for (size_t i = 0; i < delta.added.size(); i++) {
+        orders_[delta.added[i].id.data] = delta.added[i];
+        orders_by_class_.insert(std::make_pair(classOf(delta.added[i].object), delta.added[i].id.data));
+    }
+}
+
+void OrderIndex::removeOrder(uint64_t id)
+{
+    OrderMap::iterator it = orders_.find(id);
+    if (it == orders_.end()) {
+        return;
+    }
+
+    orders_by_class_.erase(std::make_pair(classOf(it->second.object), id));
+    orders_.erase(it);
+}
+
+void OrderIndex::findItems(const at_work_robot_example_ros::ObjectIdentifier &object,
+                           const at_work_robot_example_ros::LocationIdentifier &location,
+                           const at_work_robot_example_ros::ObjectIdentifier &container,
+                           std::vector<at_work_robot_example_ros::Item> &items) const
+{
+    //the object class and location are a prefix of the key
+    snapshot_cache::ItemKey first;
+    snapshot_cache::ItemKey last;
+
+    std::fill(first.fields, first.fields + 10, 0);
+    std::fill(last.fields, last.fields + 10, std::numeric_limits<uint64_t>::max());
+
+    first.fields[0] = last.fields[0] = object.type.data;
+    first.fields[1] = last.fields[1] = object.type_id.data;
+
+    if (location.type.data != 0) {
+        first.fields[2] = last.fields[2] = 1;
+        first.fields[3] = last.fields[3] = location.type.data;
+        first.fields[4] = last.fields[4] = location.instance_id.data;
+    }
+
+    ItemMap::const_iterator end = items_.upper_bound(last);
+
+    for (ItemMap::const_iterator it = items_.lower_bound(first); it != end; ++it) {
+        const at_work_robot_example_ros::Item &item = it->second;
+
+        if (object.instance_id.data != 0 && item.object.instance_id.data != object.instance_id.data) {
+            continue;
+        }
+
+        if (container.type.data != 0
+            && (item.container.type.data != container.type.data
+                || item.container.type_id.data != container.type_id.data
+                || (container.instance_id.data != 0
+                    && item.container.instance_id.data != container.instance_id.data))) {
+            continue;
+        }
+
+        items.push_back(item);
+    }
+}
+
+bool OrderIndex::query(uint64_t order_id, at_work_robot_example_ros::GetOrderItems::Response &response) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    response.items.clear();
+    response.containers.clear();
+    response.delivered.clear();
+
+    OrderMap::const_iterator it = orders_.find(order_id);
+    if (it == orders_.end()) {
+        response.found = false;
+        return false;
+    }
+
+    const at_work_robot_example_ros::Order &order = it->second;
+    at_work_robot_example_ros::LocationIdentifier any_location;
+    at_work_robot_example_ros::ObjectIdentifier any_container;
+
+    response.found = true;
+    response.order = order;
+
+    findItems(order.object, order.source, any_container, response.items);
+
+    if (order.container.type.data != 0) {
+        findItems(order.container, any_location, any_container, response.containers);
+    }
+
+    //without a destination, the container is the delivery location
+    if (order.destination.type.data != 0) {
+        findItems(order.object, order.destination, order.container, response.delivered);
+    } else if (order.container.type.data != 0) {
+        findItems(order.object, any_location, order.container, response.delivered);
+    }
+
+    return true;
+}
+
+void OrderIndex::query(const at_work_robot_example_ros::ObjectIdentifier &object,
+                       at_work_robot_example_ros::GetItemOrders::Response &response) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    response.orders.clear();
+
+    ObjectClass object_class = classOf(object);
+
+    std::set<std::pair<ObjectClass, uint64_t> >::const_iterator it =
+                    orders_by_class_.lower_bound(std::make_pair(object_class, 0));
+
+    for (; it != orders_by_class_.end() && it->first == object_class; ++it) {
+        const at_work_robot_example_ros::Order &order = orders_.find(it->second)->second;
+
+        if (!isOpen(order)) {
+            continue;
+        }
+
+        //an order for a class is satisfied by any of its instances
+        if (object.instance_id.data != 0 && order.object.instance_id.data != 0
+            && order.object.instance_id.data != object.instance_id.data) {
+            continue;
+        }
+
+        response.orders.push_back(order);
+    }
+}
+
+size_t OrderIndex::itemCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return items_.size();
+}
+
+size_t OrderIndex::orderCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return orders_.size();
+}
@@ -0,0 +1,456 @@
+#include <at_work_robot_example_ros/outbound_journal.h>
+
+#include <google/protobuf/descriptor.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <map>
+
+namespace
+{
+    const char MAGIC[8] = {'C', 'F', 'H', 'J', 'R', 'N', 'L', '1'};
+
+    size_t align(size_t size)
+    {
+        return (size + 7) & ~static_cast<size_t>(7);
+    }
+
+    /**
+     * FNV-1a, continuing from hash.
+     */
+    uint32_t fnv1a(const char *data, size_t size, uint32_t hash)
+    {
+        for (size_t i = 0; i < size; i++) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 16777619u;
+        }
+
+        return hash;
+    }
+
+    /**
+     * Component id and message type from the message's CompType enum, as
+     * protobuf_comm determines them.
+     */
+    bool messageType(const google::protobuf::Message &msg,
+                     uint16_t &component_id, uint16_t &msg_type)
+    {
+        const google::protobuf::EnumDescriptor *comp_type =
+                                msg.GetDescriptor()->FindEnumTypeByName("CompType");
+        if (!comp_type) {
+            return false;
+        }
+
+        const google::protobuf::EnumValueDescriptor *comp_id = comp_type->FindValueByName("COMP_ID");
+        const google::protobuf::EnumValueDescriptor *type = comp_type->FindValueByName("MSG_TYPE");
+        if (!comp_id || !type) {
+            return false;
+        }
+
+        component_id = comp_id->number();
+        msg_type = type->number();
+
+        return true;
+    }
+}
+
+struct OutboundJournal::FileHeader
+{
+    char magic[8];
+
+    uint64_t next_transaction_id;
+
+    uint64_t next_command_seq;
+
+    uint64_t reserved;
+};
+
+struct OutboundJournal::RecordHeader
+{
+    /**
+     * Over the rest of the header and the payload, so that a record
+     * which was not written completely is detected.
+     */
+    uint32_t checksum;
+
+    uint32_t length;
+
+    uint16_t type;
+
+    uint16_t component_id;
+
+    uint16_t msg_type;
+
+    uint16_t reserved;
+
+    /**
+     * Transaction id or command sequence number.
+     */
+    uint64_t id;
+
+    uint32_t computeChecksum(const char *payload) const
+    {
+        const char *fields = reinterpret_cast<const char *>(this) + sizeof(checksum);
+
+        return fnv1a(payload, length, fnv1a(fields, sizeof(RecordHeader) - sizeof(checksum), 2166136261u));
+    }
+};
+
+OutboundJournal::OutboundJournal():
+    fd_(-1),
+    base_(NULL),
+    size_(0),
+    offset_(0),
+    header_(NULL),
+    dirty_(false),
+    sync_all_(false),
+    dropped_(0)
+{
+}
+
+OutboundJournal::~OutboundJournal()
+{
+    sync();
+    close();
+}
+
+bool OutboundJournal::open(const std::string &path, size_t size, Recovery &recovery)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    close();
+
+    recovery.next_transaction_id = 1;
+    recovery.transactions.clear();
+    recovery.commands.clear();
+    recovery.damaged = false;
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) {
+        error_ = "cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+
+    //a second bridge must not write to the same journal
+    if (flock(fd_, LOCK_EX | LOCK_NB) != 0) {
+        error_ = path + " is used by another process";
+        close();
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        error_ = "cannot stat " + path + ": " + strerror(errno);
+        close();
+        return false;
+    }
+
+    size_ = std::max(align(std::max(size, sizeof(FileHeader) + 4096)), static_cast<size_t>(st.st_size));
+    if (static_cast<size_t>(st.st_size) < size_ && ftruncate(fd_, size_) != 0) {
+        error_ = "cannot resize " + path + ": " + strerror(errno);
+        close();
+        return false;
+    }
+
+    void *base = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (base == MAP_FAILED) {
+        error_ = "cannot map " + path + ": " + strerror(errno);
+        base_ = NULL;
+        close();
+        return false;
+    }
+
+    base_ = static_cast<char *>(base);
+    header_ = reinterpret_cast<FileHeader *>(base_);
+    offset_ = sizeof(FileHeader);
+
+    if (memcmp(header_->magic, MAGIC, sizeof(MAGIC)) != 0) {
+        //new or foreign file, start from scratch
+        memset(base_, 0, size_);
+        memcpy(header_->magic, MAGIC, sizeof(MAGIC));
+        header_->next_transaction_id = 1;
+        header_->next_command_seq = 1;
+        sync_all_ = true;
+        dirty_ = true;
+
+        return true;
+    }
+
+    std::vector<size_t> open_transactions;
+    std::vector<size_t> open_commands;
+    scan(open_transactions, open_commands, recovery.damaged);
+
+    recovery.next_transaction_id = std::max<uint64_t>(header_->next_transaction_id, 1);
+
+    for (size_t i = 0; i < open_transactions.size(); i++) {
+        const RecordHeader *record = reinterpret_cast<const RecordHeader *>(base_ + open_transactions[i]);
+
+        recovery.transactions.push_back(rockin_msgs::Transaction());
+        if (!recovery.transactions.back().ParseFromArray(record + 1, record->length)) {
+            recovery.transactions.pop_back();
+            recovery.damaged = true;
+        }
+    }
+
+    for (size_t i = 0; i < open_commands.size(); i++) {
+        const RecordHeader *record = reinterpret_cast<const RecordHeader *>(base_ + open_commands[i]);
+
+        Command command;
+        command.component_id = record->component_id;
+        command.msg_type = record->msg_type;
+        command.payload.assign(reinterpret_cast<const char *>(record + 1), record->length);
+
+        recovery.commands.push_back(command);
+    }
+
+    //the recovered commands are journaled again when they are resent
+    rewrite(open_transactions);
+
+    return true;
+}
+
+bool OutboundJournal::appendTransaction(const rockin_msgs::Transaction &transaction)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!append(TRANSACTION, rockin_msgs::Transaction::COMP_ID, rockin_msgs::Transaction::MSG_TYPE,
+                transaction.transaction_id(), &transaction)) {
+        return false;
+    }
+
+    header_->next_transaction_id = std::max<uint64_t>(header_->next_transaction_id,
+                                                      transaction.transaction_id() + 1);
+
+    return true;
+}
+
+bool OutboundJournal::appendTransactionDone(uint64_t transaction_id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return append(TRANSACTION_DONE, 0, 0, transaction_id, NULL);
+}
+
+uint64_t OutboundJournal::appendCommand(const google::protobuf::Message &command)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    uint16_t component_id;
+    uint16_t msg_type;
+    if (!base_ || !messageType(command, component_id, msg_type)) {
+        return 0;
+    }
+
+    uint64_t seq = header_->next_command_seq;
+    if (!append(COMMAND, component_id, msg_type, seq, &command)) {
+        return 0;
+    }
+
+    header_->next_command_seq = seq + 1;
+
+    return seq;
+}
+
+bool OutboundJournal::appendCommandSent(uint64_t seq)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (seq == 0) {
+        return false;
+    }
+
+    return append(COMMAND_SENT, 0, 0, seq, NULL);
+}
+
+void OutboundJournal::sync()
+{
+    size_t length;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (!base_ || !dirty_) {
+            return;
+        }
+
+        length = sync_all_ ? size_ : offset_;
+        dirty_ = false;
+        sync_all_ = false;
+    }
+
+    //only dirty pages are written, the header is on the first one
+    msync(base_, length, MS_SYNC);
+}
+
+unsigned long OutboundJournal::dropped() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return dropped_;
+}
+
+const std::string &OutboundJournal::error() const
+{
+    return error_;
+}
+
+bool OutboundJournal::append(uint16_t type, uint16_t component_id, uint16_t msg_type,
+                             uint64_t id, const google::protobuf::Message *msg)
+{
+    if (!base_) {
+        return false;
+    }
+
+    //protobuf before 3.1 only has ByteSize
+#if GOOGLE_PROTOBUF_VERSION >= 3001000
+    size_t payload_size = msg ? msg->ByteSizeLong() : 0;
+#else
+    size_t payload_size = msg ? msg->ByteSize() : 0;
+#endif
+    size_t record_size = align(sizeof(RecordHeader) + payload_size);
+
+    if (offset_ + record_size > size_ && (!compact() || offset_ + record_size > size_)) {
+        ++dropped_;
+        return false;
+    }
+
+    char *record = base_ + offset_;
+    char *payload = record + sizeof(RecordHeader);
+
+    if (msg) {
+        msg->SerializeWithCachedSizesToArray(reinterpret_cast<google::protobuf::uint8 *>(payload));
+    }
+
+    RecordHeader header;
+    header.length = payload_size;
+    header.type = type;
+    header.component_id = component_id;
+    header.msg_type = msg_type;
+    header.reserved = 0;
+    header.id = id;
+    header.checksum = header.computeChecksum(payload);
+
+    //the header goes last, a record without it ends the journal
+    memcpy(record, &header, sizeof(header));
+
+    offset_ += record_size;
+    dirty_ = true;
+
+    return true;
+}
+
+size_t OutboundJournal::scan(std::vector<size_t> &open_transactions,
+                             std::vector<size_t> &open_commands, bool &damaged) const
+{
+    std::map<uint64_t, size_t> transactions;
+    std::map<uint64_t, size_t> commands;
+
+    size_t offset = sizeof(FileHeader);
+    damaged = false;
+
+    while (offset + sizeof(RecordHeader) <= size_) {
+        const RecordHeader *record = reinterpret_cast<const RecordHeader *>(base_ + offset);
+
+        if (record->type == 0 && record->length == 0) {
+            break;
+        }
+
+        if (offset + sizeof(RecordHeader) + record->length > size_
+            || record->computeChecksum(reinterpret_cast<const char *>(record + 1)) != record->checksum) {
+            damaged = true;
+            break;
+        }
+
+        switch (record->type) {
+            case TRANSACTION:
+                transactions[record->id] = offset;
+                break;
+            case TRANSACTION_DONE:
+                transactions.erase(record->id);
+                break;
+            case COMMAND:
+                commands[record->id] = offset;
+                break;
+            case COMMAND_SENT:
+                commands.erase(record->id);
+                break;
+        }
+
+        offset += align(sizeof(RecordHeader) + record->length);
+    }
+
+    open_transactions.clear();
+    for (std::map<uint64_t, size_t>::const_iterator it = transactions.begin(); it != transactions.end(); ++it) {
+        open_transactions.push_back(it->second);
+    }
+
+    open_commands.clear();
+    for (std::map<uint64_t, size_t>::const_iterator it = commands.begin(); it != commands.end(); ++it) {
+        open_commands.push_back(it->second);
+    }
+
+    return offset;
+}
+
+void OutboundJournal::rewrite(const std::vector<size_t> &records)
+{
+    std::vector<char> buffer;
+
+    for (size_t i = 0; i < records.size(); i++) {
+        const RecordHeader *record = reinterpret_cast<const RecordHeader *>(base_ + records[i]);
+        const char *begin = base_ + records[i];
+
+        buffer.insert(buffer.end(), begin, begin + align(sizeof(RecordHeader) + record->length));
+    }
+
+    if (!buffer.empty()) {
+        memcpy(base_ + sizeof(FileHeader), &buffer[0], buffer.size());
+    }
+
+    offset_ = sizeof(FileHeader) + buffer.size();
+    memset(base_ + offset_, 0, size_ - offset_);
+
+    //the whole file changed, it is left to the next sync() like the appends
+    sync_all_ = true;
+    dirty_ = true;
+}
+
+bool OutboundJournal::compact()
+{
+    std::vector<size_t> open_transactions;
+    std::vector<size_t> open_commands;
+    bool damaged;
+
+    scan(open_transactions, open_commands, damaged);
+
+    std::vector<size_t> records;
+    std::merge(open_transactions.begin(), open_transactions.end(),
+               open_commands.begin(), open_commands.end(), std::back_inserter(records));
+
+    size_t before = offset_;
+    rewrite(records);
+
+    return offset_ < before;
+}
+
+void OutboundJournal::close()
+{
+    if (base_) {
+        munmap(base_, size_);
+        base_ = NULL;
+        header_ = NULL;
+    }
+
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
@@ -0,0 +1,37 @@
+#include <at_work_robot_example_ros/publish_filter.h>
+
+PublishFilter::PublishFilter():
+    suppress_unchanged_(false),
+    heartbeat_period_(Clock::duration::zero()),
+    published_(false),
+    last_fingerprint_(0),
+    suppressed_(0)
+{
+}
+
+void PublishFilter::configure(bool suppress_unchanged, double heartbeat_period)
+{
+    suppress_unchanged_ = suppress_unchanged;
+    heartbeat_period_ = std::chrono::duration_cast<Clock::duration>(
+                        std::chrono::duration<double>(heartbeat_period > 0 ? heartbeat_period : 0));
+}
+
+bool PublishFilter::shouldPublish(uint64_t fingerprint, Clock::time_point now)
+{
+    if (suppress_unchanged_ && published_ && fingerprint == last_fingerprint_
+        && (heartbeat_period_ == Clock::duration::zero() || now - last_publish_ < heartbeat_period_)) {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    published_ = true;
+    last_fingerprint_ = fingerprint;
+    last_publish_ = now;
+
+    return true;
+}
+
+unsigned long PublishFilter::suppressed() const
+{
+    return suppressed_.load(std::memory_order_relaxed);
+}
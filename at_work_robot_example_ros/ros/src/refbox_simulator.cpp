@@ -0,0 +1,341 @@
+#include <at_work_robot_example_ros/refbox_simulator.h>
+
+#include <rockin_msgs/BeaconSignal.pb.h>
+#include <rockin_msgs/BenchmarkFeedback.pb.h>
+#include <rockin_msgs/LoggingStatus.pb.h>
+#include <rockin_msgs/RobotStatusReport.pb.h>
+#include <rockin_msgs/Time.pb.h>
+
+#include <boost/bind.hpp>
+
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+using namespace protobuf_comm;
+using namespace rockin_msgs;
+
+RefboxSimulator::Config::Config():
+    host_name("localhost"),
+    refbox_send_port(4444),
+    refbox_recv_port(4445),
+    team_send_port(4453),
+    team_recv_port(4452),
+    cipher("aes-128-cbc"),
+    benchmark_state_rate(1.0),
+    inventory_rate(1.0),
+    order_info_rate(1.0),
+    drilling_machine_rate(1.0),
+    conveyor_belt_rate(1.0),
+    inventory_items(20),
+    orders(5),
+    description_length(16),
+    known_teams(8)
+{
+}
+
+RefboxSimulator::RefboxSimulator(const Config &config):
+    config_(config),
+    peer_public_(NULL),
+    peer_team_(NULL),
+    running_(false),
+    sent_count_(0)
+{
+    message_register_.add_message_type<BeaconSignal>();
+    message_register_.add_message_type<BenchmarkState>();
+    message_register_.add_message_type<BenchmarkFeedback>();
+    message_register_.add_message_type<Inventory>();
+    message_register_.add_message_type<OrderInfo>();
+    message_register_.add_message_type<Transaction>();
+    message_register_.add_message_type<DrillingMachineStatus>();
+    message_register_.add_message_type<DrillingMachineCommand>();
+    message_register_.add_message_type<TriggeredConveyorBeltStatus>();
+    message_register_.add_message_type<TriggeredConveyorBeltCommand>();
+    message_register_.add_message_type<LoggingStatus>();
+    message_register_.add_message_type<RobotStatus>();
+
+    fillMessages();
+}
+
+RefboxSimulator::~RefboxSimulator()
+{
+    stop();
+}
+
+void RefboxSimulator::onCommand(const CommandHandler &handler)
+{
+    command_handler_ = handler;
+}
+
+void RefboxSimulator::onBroadcast(const BroadcastHandler &handler)
+{
+    broadcast_handler_ = handler;
+}
+
+void RefboxSimulator::notifyBroadcast(uint16_t component_id, uint16_t msg_type,
+                                      unsigned long seq, double send_time)
+{
+    if (broadcast_handler_) {
+        broadcast_handler_(component_id, msg_type, seq, send_time);
+    }
+}
+
+void RefboxSimulator::start()
+{
+    //the refbox side of the bridge's local refbox configuration
+    peer_public_.reset(new ProtobufBroadcastPeer(config_.host_name,
+                                                config_.refbox_send_port,
+                                                config_.refbox_recv_port,
+                                                &message_register_));
+    peer_team_.reset(new ProtobufBroadcastPeer(config_.host_name,
+                                                config_.team_recv_port,
+                                                config_.team_send_port,
+                                                &message_register_));
+
+    if (!config_.crypto_key.empty()) {
+        peer_team_->setup_crypto(config_.crypto_key, config_.cipher);
+    }
+
+    peer_team_->signal_received().connect(boost::bind(&RefboxSimulator::handleMessage, this, _1, _2, _3, _4));
+
+    running_ = true;
+    broadcast_thread_ = std::thread(&RefboxSimulator::broadcastLoop, this);
+}
+
+void RefboxSimulator::stop()
+{
+    running_ = false;
+
+    if (broadcast_thread_.joinable()) {
+        broadcast_thread_.join();
+    }
+
+    peer_public_.reset();
+    peer_team_.reset();
+}
+
+unsigned long RefboxSimulator::sentCount() const
+{
+    return sent_count_;
+}
+
+double RefboxSimulator::now()
+{
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+void RefboxSimulator::fillMessages()
+{
+    std::string description(config_.description_length, 'x');
+
+    benchmark_state_.mutable_benchmark_time()->set_sec(0);
+    benchmark_state_.mutable_benchmark_time()->set_nsec(0);
+    benchmark_state_.set_state(BenchmarkState::RUNNING);
+    benchmark_state_.set_phase(BenchmarkState::EXECUTION);
+    benchmark_state_.mutable_scenario()->set_type(BenchmarkScenario::TBM);
+    benchmark_state_.mutable_scenario()->set_type_id(1);
+    benchmark_state_.mutable_scenario()->set_description(description);
+
+    for (int i = 0; i < config_.known_teams; i++) {
+        std::ostringstream team;
+        team << "Team" << i;
+        benchmark_state_.add_known_teams(team.str());
+        benchmark_state_.add_connected_teams(team.str());
+    }
+
+    for (int i = 0; i < config_.inventory_items; i++) {
+        Item *item = inventory_.add_items();
+
+        item->mutable_object()->set_type(ObjectIdentifier::AX);
+        item->mutable_object()->set_type_id(i % 10 + 1);
+        item->mutable_object()->set_instance_id(i + 1);
+        item->mutable_object()->set_description(description);
+        item->set_quantity(1);
+        item->mutable_location()->set_type(LocationIdentifier::SH);
+        item->mutable_location()->set_instance_id(i % 12 + 1);
+        item->mutable_location()->set_description(description);
+    }
+
+    for (int i = 0; i < config_.orders; i++) {
+        Order *order = order_info_.add_orders();
+
+        order->set_id(i + 1);
+        order->set_status(Order::OFFERED);
+        order->mutable_object()->set_type(ObjectIdentifier::AX);
+        order->mutable_object()->set_type_id(i % 10 + 1);
+        order->mutable_object()->set_description(description);
+        order->mutable_container()->set_type(ObjectIdentifier::EM);
+        order->mutable_container()->set_type_id(1);
+        order->mutable_container()->set_description(description);
+        order->set_quantity_delivered(0);
+        order->set_quantity_requested(1);
+        order->mutable_destination()->set_type(LocationIdentifier::WS);
+        order->mutable_destination()->set_instance_id(i % 5 + 1);
+        order->mutable_destination()->set_description(description);
+        order->mutable_source()->set_type(LocationIdentifier::SH);
+        order->mutable_source()->set_instance_id(i % 12 + 1);
+        order->mutable_source()->set_description(description);
+    }
+
+    drilling_machine_status_.set_state(DrillingMachineStatus::AT_TOP);
+
+    conveyor_belt_status_.set_state(STOP);
+    conveyor_belt_status_.set_cycle(0);
+}
+
+void RefboxSimulator::broadcastLoop()
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const double rates[5] = {
+        config_.benchmark_state_rate, config_.inventory_rate, config_.order_info_rate,
+        config_.drilling_machine_rate, config_.conveyor_belt_rate
+    };
+
+    Clock::time_point next[5];
+    Clock::duration period[5];
+    unsigned long seq[5] = {0, 0, 0, 0, 0};
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point never = Clock::time_point::max();
+
+    for (int i = 0; i < 5; i++) {
+        if (rates[i] > 0) {
+            period[i] = std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double>(1.0 / rates[i]));
+            next[i] = start;
+        } else {
+            next[i] = never;
+        }
+    }
+
+    while (running_) {
+        Clock::time_point now = Clock::now();
+
+        for (int i = 0; i < 5; i++) {
+            if (next[i] > now) {
+                continue;
+            }
+
+            switch (i) {
+                case 0: sendBenchmarkState(); break;
+                case 1: sendInventory(++seq[i]); break;
+                case 2: sendOrderInfo(++seq[i]); break;
+                case 3: sendDrillingMachineStatus(); break;
+                case 4: sendConveyorBeltStatus(++seq[i]); break;
+            }
+
+            //do not try to catch up after a stall, keep the configured rate
+            next[i] = std::max(next[i] + period[i], now);
+        }
+
+        Clock::time_point wakeup = *std::min_element(next, next + 5);
+        if (wakeup == never) {
+            wakeup = now + std::chrono::milliseconds(100);
+        }
+
+        std::this_thread::sleep_until(std::min(wakeup, now + std::chrono::milliseconds(100)));
+    }
+}
+
+void RefboxSimulator::sendBenchmarkState()
+{
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    benchmark_state_.mutable_benchmark_time()->set_sec(now.tv_sec);
+    benchmark_state_.mutable_benchmark_time()->set_nsec(now.tv_nsec);
+
+    peer_public_->send(benchmark_state_);
+    ++sent_count_;
+
+    notifyBroadcast(BenchmarkState::COMP_ID, BenchmarkState::MSG_TYPE, 0,
+                    now.tv_sec + now.tv_nsec * 1e-9);
+}
+
+void RefboxSimulator::sendInventory(unsigned long seq)
+{
+    if (inventory_.items_size() > 0) {
+        inventory_.mutable_items(0)->set_quantity(seq);
+    }
+
+    double send_time = now();
+
+    peer_public_->send(inventory_);
+    ++sent_count_;
+
+    notifyBroadcast(Inventory::COMP_ID, Inventory::MSG_TYPE, seq, send_time);
+}
+
+void RefboxSimulator::sendOrderInfo(unsigned long seq)
+{
+    if (order_info_.orders_size() > 0) {
+        order_info_.mutable_orders(0)->set_quantity_delivered(seq);
+    }
+
+    double send_time = now();
+
+    peer_public_->send(order_info_);
+    ++sent_count_;
+
+    notifyBroadcast(OrderInfo::COMP_ID, OrderInfo::MSG_TYPE, seq, send_time);
+}
+
+void RefboxSimulator::sendDrillingMachineStatus()
+{
+    std::lock_guard<std::mutex> lock(device_mutex_);
+
+    peer_public_->send(drilling_machine_status_);
+    ++sent_count_;
+}
+
+void RefboxSimulator::sendConveyorBeltStatus(unsigned long seq)
+{
+    std::lock_guard<std::mutex> lock(device_mutex_);
+
+    conveyor_belt_status_.set_cycle(seq);
+
+    double send_time = now();
+
+    peer_public_->send(conveyor_belt_status_);
+    ++sent_count_;
+
+    notifyBroadcast(TriggeredConveyorBeltStatus::COMP_ID, TriggeredConveyorBeltStatus::MSG_TYPE,
+                    seq, send_time);
+}
+
+void RefboxSimulator::handleMessage(boost::asio::ip::udp::endpoint &sender,
+                                    uint16_t component_id, uint16_t msg_type,
+                                    std::shared_ptr<google::protobuf::Message> msg)
+{
+    std::shared_ptr<DrillingMachineCommand> drilling_command;
+    std::shared_ptr<TriggeredConveyorBeltCommand> conveyor_command;
+
+    //echo device commands back as a status change, like the real devices
+    if ((drilling_command = std::dynamic_pointer_cast<DrillingMachineCommand>(msg))) {
+        std::lock_guard<std::mutex> lock(device_mutex_);
+
+        if (drilling_command->command() == DrillingMachineCommand::MOVE_DOWN) {
+            drilling_machine_status_.set_state(DrillingMachineStatus::AT_BOTTOM);
+        } else {
+            drilling_machine_status_.set_state(DrillingMachineStatus::AT_TOP);
+        }
+
+        peer_public_->send(drilling_machine_status_);
+    } else if ((conveyor_command = std::dynamic_pointer_cast<TriggeredConveyorBeltCommand>(msg))) {
+        std::lock_guard<std::mutex> lock(device_mutex_);
+
+        conveyor_belt_status_.set_state(conveyor_command->command());
+
+        peer_public_->send(conveyor_belt_status_);
+    }
+
+    if (command_handler_) {
+        command_handler_(component_id, msg_type, *msg);
+    }
+}
@@ -1,540 +1,2020 @@
 #include <at_work_robot_example_ros/robot_example_ros.h>
 
+namespace
+{
+    int64_t steadyNow()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * CLOCK_REALTIME at a steadyNow() time, the clock of the beacon signals.
+     */
+    int64_t realtimeAt(int64_t steady_time)
+    {
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+
+        return now.tv_sec * 1000000000LL + now.tv_nsec - (steadyNow() - steady_time);
+    }
+
+    ros::Time toRosTime(int64_t nsec)
+    {
+        ros::Time time;
+        time.fromNSec(nsec > 0 ? nsec : 0);
+        return time;
+    }
+
+    template <class T>
+    void addValue(diagnostic_msgs::DiagnosticStatus &status, const std::string &key, const T &value)
+    {
+        std::ostringstream stream;
+        stream << value;
+
+        diagnostic_msgs::KeyValue key_value;
+        key_value.key = key;
+        key_value.value = stream.str();
+
+        status.values.push_back(key_value);
+    }
+
+    /**
+     * Percentiles in microseconds, nothing if no latency was recorded.
+     */
+    void addLatency(diagnostic_msgs::DiagnosticStatus &status, const std::string &key,
+                    const LatencyHistogram &histogram)
+    {
+        LatencyHistogram::Summary summary = histogram.summary();
+        if (summary.count == 0) {
+            return;
+        }
+
+        addValue(status, key + " mean (us)", summary.mean / 1e3);
+        addValue(status, key + " p50 (us)", summary.p50 / 1e3);
+        addValue(status, key + " p90 (us)", summary.p90 / 1e3);
+        addValue(status, key + " p99 (us)", summary.p99 / 1e3);
+        addValue(status, key + " max (us)", summary.max / 1e3);
+    }
+
+    void logLatency(const std::string &name, const char *what, const LatencyHistogram &histogram)
+    {
+        LatencyHistogram::Summary summary = histogram.summary();
+        if (summary.count == 0) {
+            return;
+        }
+
+        ROS_INFO("%s %s: %lu samples, mean %.1f us, p50 %.1f us, p90 %.1f us, p99 %.1f us, max %.1f us",
+                 name.c_str(), what, summary.count, summary.mean / 1e3, summary.p50 / 1e3,
+                 summary.p90 / 1e3, summary.p99 / 1e3, summary.max / 1e3);
+    }
+}
 
-RobotExampleROS::RobotExampleROS(const ros::NodeHandle &nh):
-    nh_(nh), seq_(0), 
-    peer_public_(NULL),
-    peer_team_(NULL)
+RobotExampleROS::RobotExampleROS(const ros::NodeHandle &nh, bool external_public_peer):
+    nh_(nh),
+    dispatch_running_(false),
+    dispatch_waiting_(false),
+    capture_flush_(false),
+    replay_running_(false),
+    drilling_machine_command_(DrillingMachineCommand::MOVE_DOWN),
+    conveyor_belt_command_(rockin_msgs::STOP),
+    conveyor_belt_next_cycle_(0),
+    drilling_machine_state_(DrillingMachineStatus::UNKNOWN),
+    conveyor_belt_status_known_(false),
+    conveyor_belt_state_(rockin_msgs::STOP),
+    conveyor_belt_cycle_(0),
+    transactions_given_up_(0),
+    diagnostics_errors_(0),
+    dispatch_receive_time_(0),
+    peers_broken_(false),
+    reconnect_buffer_drops_(0),
+    reconnects_(0),
+    public_socket_drops_(0),
+    team_socket_drops_(0),
+    last_reconnect_(0),
+    next_reconnect_(0),
+    health_send_errors_(0),
+    last_public_receive_(0),
+    last_team_listed_(0),
+    string_pool_(new StringPool),
+    inventory_cache_(string_pool_),
+    order_info_cache_(string_pool_)
 {
+    //the gateway receives the public broadcasts for all its robots
+    client_config_.public_peer = !external_public_peer;
+
     readParameters();
 
     //Publishers
     attention_message_pub_ = nh_.advertise<at_work_robot_example_ros::AttentionMessage> (
-                            "attention_message", 10);
+                            "attention_message", topicQos("attention_message", 10).queue_size);
 
+    //states are only published on change, latched for late subscribers
     benchmark_state_pub_ = nh_.advertise<at_work_robot_example_ros::BenchmarkState> (
-                            "benchmark_state", 10);
+                            "benchmark_state", topicQos("benchmark_state", 10).queue_size, true);
 
     drill_machine_status_pub_ = nh_.advertise<at_work_robot_example_ros::DrillingMachineStatus> (
-                            "drill_machine_status", 10);
+                            "drill_machine_status", topicQos("drill_machine_status", 10).queue_size, true);
+
+    diagnostics_pub_ = nh_.advertise<diagnostic_msgs::DiagnosticArray> (
+                            "/diagnostics", 10);
 
     conveyor_belt_status_pub_ = nh_.advertise<at_work_robot_example_ros::TriggeredConveyorBeltStatus> (
-                        "conveyor_belt_status", 10);
+                        "conveyor_belt_status", topicQos("conveyor_belt_status", 10).queue_size, true);
+
+    inventory_pub_ = nh_.advertise<at_work_robot_example_ros::Inventory> (
+                        "inventory", topicQos("inventory", 10).queue_size);
+
+    order_info_pub_ = nh_.advertise<at_work_robot_example_ros::OrderInfo> (
+                        "order_info", topicQos("order_info", 10).queue_size);
+
+    inventory_delta_pub_ = nh_.advertise<at_work_robot_example_ros::InventoryDelta> (
+                        "inventory_delta", topicQos("inventory_delta", 10).queue_size);
+
+    order_info_delta_pub_ = nh_.advertise<at_work_robot_example_ros::OrderInfoDelta> (
+                        "order_info_delta", topicQos("order_info_delta", 10).queue_size);
 
-    inventory_pub_ = nh_.advertise<at_work_robot_example_ros::Inventory> ("inventory", 10);
+    clock_offset_pub_ = nh_.advertise<at_work_robot_example_ros::ClockOffset> (
+                        "clock_offset", topicQos("clock_offset", 10).queue_size);
 
-    order_info_pub_ = nh_.advertise<at_work_robot_example_ros::OrderInfo> ("order_info", 10);
 
+    initializeRobot();
 
-    //Subscribers
+    //Subscribers, without Nagle so that commands are forwarded immediately
+    TopicQos qos = topicQos("drilling_machine_command", 1000);
+    drilling_machine_command_limiter_.configure(qos.max_rate, qos.burst);
     drillling_machine_command_sub_ = nh_.subscribe<at_work_robot_example_ros::DrillingMachineCommand>(
-                        "drilling_machine_command", 1000, &RobotExampleROS::DrillingMachineCommandCB, this);
+                        "drilling_machine_command", qos.queue_size, &RobotExampleROS::DrillingMachineCommandCB, this,
+                        ros::TransportHints().tcpNoDelay());
 
+    qos = topicQos("conveyor_belt_command", 1000);
+    conveyor_belt_command_limiter_.configure(qos.max_rate, qos.burst);
     conveyor_belt_command_sub_ = nh_.subscribe<at_work_robot_example_ros::TriggeredConveyorBeltCommand>(
-                        "conveyor_belt_command", 1000, &RobotExampleROS::TriggeredConveyorBeltCommandCB, this);
+                        "conveyor_belt_command", qos.queue_size, &RobotExampleROS::TriggeredConveyorBeltCommandCB, this,
+                        ros::TransportHints().tcpNoDelay());
 
+    qos = topicQos("benchmark_feedback", 1000);
+    benchmark_feedback_limiter_.configure(qos.max_rate, qos.burst);
     benchmark_feedback_sub_ = nh_.subscribe<at_work_robot_example_ros::BenchmarkFeedback>(
-                        "benchmark_feedback", 1000, &RobotExampleROS::BenchmarkFeedbackCB, this);
+                        "benchmark_feedback", qos.queue_size, &RobotExampleROS::BenchmarkFeedbackCB, this,
+                        ros::TransportHints().tcpNoDelay());
 
+    qos = topicQos("logging_status", 1000);
+    logging_status_limiter_.configure(qos.max_rate, qos.burst);
     logging_status_sub_ = nh_.subscribe<at_work_robot_example_ros::LoggingStatus>(
-                        "logging_status", 1000, &RobotExampleROS::LoggingStatusCB, this);
+                        "logging_status", qos.queue_size, &RobotExampleROS::LoggingStatusCB, this,
+                        ros::TransportHints().tcpNoDelay());
 
+    //transactions are paced by the sequencer's window, not rate limited
+    qos = topicQos("inventory_transaction", 1000);
+    if (qos.max_rate > 0) {
+        ROS_WARN("Inventory transactions are not rate limited, ignoring max_rate");
+    }
     transaction_sub_ = nh_.subscribe<at_work_robot_example_ros::Transaction>(
-                        "inventory_transaction", 1000, &RobotExampleROS::InventoryTransactionCB, this);
+                        "inventory_transaction", qos.queue_size, &RobotExampleROS::InventoryTransactionCB, this,
+                        ros::TransportHints().tcpNoDelay());
 
+    qos = topicQos("robot_status_report", 1000);
+    robot_status_limiter_.configure(qos.max_rate, qos.burst);
     robot_status_sub_ = nh_.subscribe<at_work_robot_example_ros::RobotStatusReport>(
-                        "robot_status_report", 1000, &RobotExampleROS::RobotStatusReportCB, this);
+                        "robot_status_report", qos.queue_size, &RobotExampleROS::RobotStatusReportCB, this,
+                        ros::TransportHints().tcpNoDelay());
 
-    initializeRobot();
+    //Services
+    get_order_items_srv_ = nh_.advertiseService("get_order_items",
+                        &RobotExampleROS::getOrderItemsCB, this);
+
+    get_item_orders_srv_ = nh_.advertiseService("get_item_orders",
+                        &RobotExampleROS::getItemOrdersCB, this);
+
+    submit_transaction_srv_ = nh_.advertiseService("submit_transaction",
+                        &RobotExampleROS::submitTransactionCB, this);
+
+    //Actions, their goals are completed by the machine status on the dispatch thread
+    drilling_machine_action_.reset(new DrillingMachineActionServer(nh_, "drilling_machine",
+                        boost::bind(&RobotExampleROS::drillingMachineGoalCB, this, _1),
+                        boost::bind(&RobotExampleROS::drillingMachineCancelCB, this, _1), false));
+    drilling_machine_action_->start();
+
+    conveyor_belt_action_.reset(new ConveyorBeltActionServer(nh_, "conveyor_belt",
+                        boost::bind(&RobotExampleROS::conveyorBeltGoalCB, this, _1),
+                        boost::bind(&RobotExampleROS::conveyorBeltCancelCB, this, _1), false));
+    conveyor_belt_action_->start();
+
+    beacon_timer_ = nh_.createSteadyTimer(ros::WallDuration(beacon_period_),
+                        &RobotExampleROS::beaconTimerCB, this);
+
+    transaction_timer_ = nh_.createSteadyTimer(ros::WallDuration(transaction_send_period_),
+                        &RobotExampleROS::transactionTimerCB, this);
+
+    action_timer_ = nh_.createSteadyTimer(ros::WallDuration(action_check_period_),
+                        &RobotExampleROS::actionTimerCB, this);
+
+    if (journal_) {
+        journal_timer_ = nh_.createSteadyTimer(ros::WallDuration(journal_sync_period_),
+                        &RobotExampleROS::journalTimerCB, this);
+    }
+
+    //nothing to reconnect while replaying
+    if (health_check_period_ > 0 && !replay_) {
+        reconnect_backoff_ = reconnect_backoff_min_;
+        health_timer_ = nh_.createSteadyTimer(ros::WallDuration(health_check_period_),
+                        &RobotExampleROS::healthTimerCB, this);
+    }
+
+    if (diagnostics_period_ > 0) {
+        last_diagnostics_ = ros::WallTime::now();
+        diagnostics_timer_ = nh_.createSteadyTimer(ros::WallDuration(diagnostics_period_),
+                        &RobotExampleROS::diagnosticsTimerCB, this);
+    }
 }
 
 RobotExampleROS::~RobotExampleROS()
 {
-    // Delete all global objects allocated by libprotobuf
-    google::protobuf::ShutdownProtobufLibrary();
+    beacon_timer_.stop();
+    transaction_timer_.stop();
+    journal_timer_.stop();
+    action_timer_.stop();
+    diagnostics_timer_.stop();
+    health_timer_.stop();
+
+    //the kernel forgets the counters with the sockets
+    if (client_ && !replay_) {
+        ROS_INFO("Kernel socket drops: public %lu, team %lu",
+                 public_socket_drops_ + client_->publicSockets().statistics().drops,
+                 team_socket_drops_ + client_->teamSockets().statistics().drops);
+    }
+
+    // Stop the producers before the consumer
+    if (client_) {
+        client_->stop();
+    }
+
+    replay_running_ = false;
+    if (replay_thread_.joinable()) {
+        replay_thread_.join();
+    }
+
+    stopDispatching();
+
+    if (capture_) {
+        ROS_INFO("Captured %lu messages to %s", capture_->count(), capture_path_.c_str());
+        capture_.reset();
+    }
+
+    if (shared_snapshot_) {
+        ROS_INFO("Exported %lu snapshots to %s, %lu did not fit", shared_snapshot_->written(),
+                 shared_snapshot_name_.c_str(), shared_snapshot_->oversized());
+        shared_snapshot_.reset();
+    }
+
+    logStatistics();
+
+    if (reconnects_ > 0 || reconnect_buffer_drops_ > 0) {
+        ROS_INFO("Reconnects: %lu, %lu team messages dropped while reconnecting",
+                 reconnects_, reconnect_buffer_drops_);
+    }
+
+    if (public_queue_ && team_queue_) {
+        ReceiveQueueStatistics public_stats = publicQueueStatistics();
+        ReceiveQueueStatistics team_stats = teamQueueStatistics();
+
+        ROS_INFO("Public receive queue: %lu dropped, high-water mark %zu of %zu",
+                 public_stats.drops, public_stats.high_water_mark, public_stats.capacity);
+        ROS_INFO("Team receive queue: %lu dropped, high-water mark %zu of %zu",
+                 team_stats.drops, team_stats.high_water_mark, team_stats.capacity);
+    }
+
+    if (transaction_sequencer_) {
+        TransactionSequencer::Statistics stats = transaction_sequencer_->statistics();
+
+        ROS_INFO("Transactions: %lu submitted, %lu confirmed, %lu retransmitted, %lu given up, "
+                 "%lu renumbered, %zu unconfirmed, %zu unsent",
+                 stats.submitted, stats.confirmed, stats.retransmitted, stats.given_up,
+                 stats.gaps, stats.in_flight, stats.queued);
+    }
+
+    if (journal_) {
+        if (journal_->dropped() > 0) {
+            ROS_WARN("Journal: %lu records did not fit into %s", journal_->dropped(), journal_path_.c_str());
+        }
+
+        // Flushes the journal
+        journal_.reset();
+    }
+
 }
 
 
-void RobotExampleROS::RobotStatusReportCB(at_work_robot_example_ros::RobotStatusReport msg)
+void RobotExampleROS::RobotStatusReportCB(const at_work_robot_example_ros::RobotStatusReport::ConstPtr &msg)
 {
-    //create a new message
-    std::shared_ptr<RobotStatus> robot_status_report(new RobotStatus);
+    int64_t callback_time = steadyNow();
+
+    if (!robot_status_limiter_.tryAcquire(RateLimiter::Clock::now())) {
+        message_statistics_.rateLimited<RobotStatus>();
+        return;
+    }
+
+    //reuse the outbound message
+    OutboundMessage<RobotStatus>::Lease robot_status_report(robot_status_out_);
 
     //fill the message
-    robot_status_report->set_capability((rockin_msgs::RobotStatus_Capability)msg.capability.data);
-    robot_status_report->set_functionality(msg.functionality.data);
-    robot_status_report->set_meta_data((std::string)msg.meta_data.data);
+    converters::toProtobuf(*msg, *robot_status_report);
 
     //send the Message over team peer
-    peer_team_->send(robot_status_report);
+    sendToTeam(*robot_status_report);
+
+    message_statistics_.sent<RobotStatus>(callback_time, steadyNow());
 }
 
-void RobotExampleROS::InventoryTransactionCB(at_work_robot_example_ros::Transaction msg)
+bool RobotExampleROS::getOrderItemsCB(at_work_robot_example_ros::GetOrderItems::Request &request,
+                                      at_work_robot_example_ros::GetOrderItems::Response &response)
 {
-    //create a new message
-    std::shared_ptr<Transaction> inventory_transaction(new Transaction);
+    //an unknown order is an answer, not a failed call
+    order_index_.query(request.order_id, response);
+    return true;
+}
 
-    //fill the message
-    inventory_transaction->set_transaction_id(msg.transaction_id.data);
-    inventory_transaction->set_order_id(msg.order_id.data);
-    
-    rockin_msgs::ObjectIdentifier *object_identifier =  inventory_transaction->mutable_object();
-    object_identifier->set_type((rockin_msgs::ObjectIdentifier_ObjectType)msg.object.type.data);
-    object_identifier->set_type_id(msg.object.type_id.data);
-    object_identifier->set_instance_id(msg.object.instance_id.data);
-    object_identifier->set_description((std::string)msg.object.description.data);
-
-    inventory_transaction->set_quantity(msg.quantity.data);
-    inventory_transaction->set_action((rockin_msgs::Transaction_Action)msg.action.data);
-    
-    rockin_msgs::LocationIdentifier *source_location =  inventory_transaction->mutable_source();
-    source_location->set_type((rockin_msgs::LocationIdentifier_LocationType)msg.source.type.data);
-    source_location->set_instance_id(msg.source.instance_id.data);
-    source_location->set_description((std::string)msg.source.description.data);
-
-    rockin_msgs::LocationIdentifier *destination_location =  inventory_transaction->mutable_destination();
-    destination_location->set_type((rockin_msgs::LocationIdentifier_LocationType)msg.destination.type.data);
-    destination_location->set_instance_id(msg.destination.instance_id.data);
-    destination_location->set_description((std::string)msg.destination.description.data);
+bool RobotExampleROS::getItemOrdersCB(at_work_robot_example_ros::GetItemOrders::Request &request,
+                                      at_work_robot_example_ros::GetItemOrders::Response &response)
+{
+    order_index_.query(request.object, response);
+    return true;
+}
 
-    //send the Message over team peer
-    peer_team_->send(inventory_transaction);
+bool RobotExampleROS::submitTransactionCB(at_work_robot_example_ros::SubmitTransaction::Request &request,
+                                          at_work_robot_example_ros::SubmitTransaction::Response &response)
+{
+    response.transaction_id.data = submitTransaction(request.transaction);
+    return true;
+}
+
+void RobotExampleROS::InventoryTransactionCB(const at_work_robot_example_ros::Transaction::ConstPtr &msg)
+{
+    uint64_t transaction_id = submitTransaction(*msg);
+
+    if (msg->transaction_id.data != 0 && msg->transaction_id.data != transaction_id) {
+        ROS_WARN("Transaction %lu is sent as %lu to keep the transaction ids contiguous, "
+                 "submit_transaction returns the id a transaction is sent with",
+                 (unsigned long)msg->transaction_id.data, (unsigned long)transaction_id);
+    }
 }
 
-void RobotExampleROS::LoggingStatusCB(at_work_robot_example_ros::LoggingStatus msg)
+uint64_t RobotExampleROS::submitTransaction(const at_work_robot_example_ros::Transaction &msg)
 {
-    //create a new message
-    std::shared_ptr<LoggingStatus> logging_status(new LoggingStatus);
+    int64_t callback_time = steadyNow();
+
+    //reuse the outbound message
+    OutboundMessage<Transaction>::Lease inventory_transaction(transaction_out_);
 
     //fill the message
-    logging_status->set_is_logging(msg.is_logging.data);
+    converters::toProtobuf(msg, *inventory_transaction);
 
+    //queue the Message for the next send cycle of the team peer
+    uint64_t transaction_id = transaction_sequencer_->submit(*inventory_transaction);
 
-    //send the Message over team peer
-    peer_team_->send(logging_status);
+    message_statistics_.sent<Transaction>(callback_time, steadyNow());
+
+    return transaction_id;
 }
 
-void RobotExampleROS::DrillingMachineCommandCB(at_work_robot_example_ros::DrillingMachineCommand msg)
+void RobotExampleROS::LoggingStatusCB(const at_work_robot_example_ros::LoggingStatus::ConstPtr &msg)
 {
-    //create a new message
-    std::shared_ptr<DrillingMachineCommand> drill_machine_command(new DrillingMachineCommand());
+    int64_t callback_time = steadyNow();
+
+    if (!logging_status_limiter_.tryAcquire(RateLimiter::Clock::now())) {
+        message_statistics_.rateLimited<LoggingStatus>();
+        return;
+    }
 
-    rockin_msgs::DrillingMachineCommand_Command cmd = drill_machine_command->command();
+    //reuse the outbound message
+    OutboundMessage<LoggingStatus>::Lease logging_status(logging_status_out_);
 
-    cmd = (rockin_msgs::DrillingMachineCommand_Command)msg.command.data;
+    //fill the message
+    converters::toProtobuf(*msg, *logging_status);
 
-    drill_machine_command->set_command(cmd);
+    //journal and send the Message over team peer
+    sendCommand(*logging_status);
 
-    //send the Message over team peer
-    peer_team_->send(drill_machine_command);
+    message_statistics_.sent<LoggingStatus>(callback_time, steadyNow());
 }
 
-void RobotExampleROS::TriggeredConveyorBeltCommandCB(at_work_robot_example_ros::TriggeredConveyorBeltCommand msg)
+void RobotExampleROS::DrillingMachineCommandCB(const at_work_robot_example_ros::DrillingMachineCommand::ConstPtr &msg)
 {
-    //create a new message
-    std::shared_ptr<TriggeredConveyorBeltCommand> conveyor_belt_command(new TriggeredConveyorBeltCommand);
+    int64_t callback_time = steadyNow();
 
-    //fill the message
-    rockin_msgs::ConveyorBeltRunMode cmd = conveyor_belt_command->command();
+    if (!drilling_machine_command_limiter_.tryAcquire(RateLimiter::Clock::now())) {
+        message_statistics_.rateLimited<DrillingMachineCommand>();
+        return;
+    }
 
-    cmd = (rockin_msgs::ConveyorBeltRunMode)msg.command.data;
+    sendDrillingMachineCommand((rockin_msgs::DrillingMachineCommand_Command)msg->command.data);
 
-    conveyor_belt_command->set_command(cmd);
+    message_statistics_.sent<DrillingMachineCommand>(callback_time, steadyNow());
+}
+
+void RobotExampleROS::sendDrillingMachineCommand(DrillingMachineCommand_Command command)
+{
+    //reuse the outbound message
+    OutboundMessage<DrillingMachineCommand>::Lease drill_machine_command(drilling_machine_command_out_);
 
-    conveyor_belt_command->set_next_cycle(msg.next_cycle.data);
+    drill_machine_command->set_command(command);
 
-    //send the Message over team peer
-    peer_team_->send(conveyor_belt_command);
+    //journal and send the Message over team peer
+    sendCommand(*drill_machine_command);
 }
 
-void RobotExampleROS::BenchmarkFeedbackCB(at_work_robot_example_ros::BenchmarkFeedback msg)
+void RobotExampleROS::TriggeredConveyorBeltCommandCB(const at_work_robot_example_ros::TriggeredConveyorBeltCommand::ConstPtr &msg)
 {
-    //create a new message
-    std::shared_ptr<BenchmarkFeedback> benchmark_feedback(new BenchmarkFeedback);
+    int64_t callback_time = steadyNow();
 
-    //fill the message for FBM1
-    benchmark_feedback->set_phase_to_terminate((rockin_msgs::BenchmarkState_Phase)msg.phase_to_terminate.data);
+    if (!conveyor_belt_command_limiter_.tryAcquire(RateLimiter::Clock::now())) {
+        message_statistics_.rateLimited<TriggeredConveyorBeltCommand>();
+        return;
+    }
 
-    benchmark_feedback->set_object_class_name((std::string)msg.object_class_name.data);
+    sendConveyorBeltCommand((rockin_msgs::ConveyorBeltRunMode)msg->command.data, msg->next_cycle.data);
 
-    rockin_msgs::Pose3D *pose_object = benchmark_feedback->mutable_object_pose();
+    message_statistics_.sent<TriggeredConveyorBeltCommand>(callback_time, steadyNow());
+}
 
-    rockin_msgs::Position3D *position_object =  pose_object->mutable_position();
-    rockin_msgs::Quaternion *orientation_object =  pose_object->mutable_orientation();
+void RobotExampleROS::sendConveyorBeltCommand(ConveyorBeltRunMode command, uint32_t next_cycle)
+{
+    //reuse the outbound message
+    OutboundMessage<TriggeredConveyorBeltCommand>::Lease conveyor_belt_command(conveyor_belt_command_out_);
 
-    position_object->set_x(msg.object_pose.position.x);
-    position_object->set_y(msg.object_pose.position.y);
-    position_object->set_z(msg.object_pose.position.z);
+    //fill the message
+    conveyor_belt_command->set_command(command);
 
-    orientation_object->set_x(msg.object_pose.orientation.x);
-    orientation_object->set_y(msg.object_pose.orientation.y);
-    orientation_object->set_z(msg.object_pose.orientation.z);
-    orientation_object->set_w(msg.object_pose.orientation.w);
+    conveyor_belt_command->set_next_cycle(next_cycle);
 
-    //fill the message for FBM1+FMB2
-    benchmark_feedback->set_object_instance_name((std::string)msg.object_instance_name.data);
+    //journal and send the Message over team peer
+    sendCommand(*conveyor_belt_command);
+}
 
-    //fill the message for FBM2
-    benchmark_feedback->set_grasp_notification(msg.grasp_notification.data);
-    rockin_msgs::Pose3D *pose_eef = benchmark_feedback->mutable_end_effector_pose();
+RobotExampleROS::ActionStatistics::ActionStatistics():
+    succeeded(0),
+    timed_out(0),
+    preempted(0),
+    canceled(0),
+    resent(0)
+{
+}
 
-    rockin_msgs::Position3D *position_eef =  pose_eef->mutable_position();
-    rockin_msgs::Quaternion *orientation_eef =  pose_eef->mutable_orientation();
+CommandTracker::Clock::duration RobotExampleROS::actionTimeout(double timeout) const
+{
+    return std::chrono::duration_cast<CommandTracker::Clock::duration>(
+                        std::chrono::duration<double>(timeout > 0 ? timeout : action_timeout_));
+}
 
-    position_eef->set_x(msg.end_effector_pose.position.x);
-    position_eef->set_y(msg.end_effector_pose.position.y);
-    position_eef->set_z(msg.end_effector_pose.position.z);
+at_work_robot_example_ros::DrillingMachineResult RobotExampleROS::drillingMachineResult(
+                        CommandTracker::Clock::time_point now)
+{
+    at_work_robot_example_ros::DrillingMachineResult result;
 
-    orientation_eef->set_x(msg.end_effector_pose.orientation.x);
-    orientation_eef->set_y(msg.end_effector_pose.orientation.y);
-    orientation_eef->set_z(msg.end_effector_pose.orientation.z);
-    orientation_eef->set_w(msg.end_effector_pose.orientation.w);
+    result.state = drilling_machine_state_;
+    result.attempts = drilling_machine_tracker_.attempts();
+    result.latency = std::chrono::duration<double>(drilling_machine_tracker_.elapsed(now)).count();
 
-    // make sure we have a valid plate state (if it wasn't set earlier)
-    if (msg.plate_state_after_receiving.data == 0)
-    {
-        msg.plate_state_after_receiving.data = BenchmarkFeedback::UNUSABLE;
+    return result;
+}
+
+at_work_robot_example_ros::ConveyorBeltResult RobotExampleROS::conveyorBeltResult(
+                        CommandTracker::Clock::time_point now)
+{
+    at_work_robot_example_ros::ConveyorBeltResult result;
+
+    result.state = conveyor_belt_state_;
+    result.cycle = conveyor_belt_cycle_;
+    result.attempts = conveyor_belt_tracker_.attempts();
+    result.latency = std::chrono::duration<double>(conveyor_belt_tracker_.elapsed(now)).count();
+
+    return result;
+}
+
+void RobotExampleROS::drillingMachineGoalCB(DrillingMachineActionServer::GoalHandle goal)
+{
+    int64_t callback_time = steadyNow();
+    CommandTracker::Clock::time_point now = CommandTracker::Clock::now();
+
+    std::lock_guard<std::mutex> lock(action_mutex_);
+
+    uint8_t command = goal.getGoal()->command;
+    if (command != at_work_robot_example_ros::DrillingMachineGoal::MOVE_DOWN
+        && command != at_work_robot_example_ros::DrillingMachineGoal::MOVE_UP) {
+        at_work_robot_example_ros::DrillingMachineResult result;
+        result.state = drilling_machine_state_;
+
+        goal.setRejected(result, "unknown command");
+        return;
     }
-    if (msg.plate_state_after_drilling.data == 0)
-    {
-        msg.plate_state_after_drilling.data = BenchmarkFeedback::PERFECT;
+
+    if (drilling_machine_tracker_.active()) {
+        drilling_machine_tracker_.cancel();
+        drilling_machine_goal_.setAborted(drillingMachineResult(now), "preempted by a new goal");
+        ++drilling_machine_statistics_.preempted;
     }
 
-    //fill the message for TBM1
-    benchmark_feedback->set_assembly_aid_tray_id((std::string)msg.assembly_aid_tray_id.data);
-    benchmark_feedback->set_container_id((std::string)msg.container_id.data);
+    goal.setAccepted();
 
-    ////fill the message TBM2
-    rockin_msgs::BenchmarkFeedback_PlateState plate_state = benchmark_feedback->after_receiving();
-    plate_state = (rockin_msgs::BenchmarkFeedback_PlateState)msg.plate_state_after_receiving.data;
-    benchmark_feedback->set_after_receiving(plate_state);
+    drilling_machine_goal_ = goal;
+    drilling_machine_command_ = (DrillingMachineCommand_Command)command;
 
-    plate_state = benchmark_feedback->after_drilling();
-    plate_state = (rockin_msgs::BenchmarkFeedback_PlateState)msg.plate_state_after_drilling.data;
-    benchmark_feedback->set_after_drilling(plate_state);
+    sendDrillingMachineCommand(drilling_machine_command_);
 
-    //send the Message over team peer
-    peer_team_->send(benchmark_feedback);
-}
+    drilling_machine_tracker_.start(now, actionTimeout(goal.getGoal()->timeout),
+                        actionTimeout(action_retry_timeout_), std::max(action_max_attempts_, 1));
 
+    message_statistics_.sent<DrillingMachineCommand>(callback_time, steadyNow());
+}
 
-void RobotExampleROS::readParameters()
+void RobotExampleROS::drillingMachineCancelCB(DrillingMachineActionServer::GoalHandle goal)
 {
-    ros::param::param<bool>("~remote_refbox", remote_refbox_, false);
-    ros::param::param<std::string>("~host_name", host_name_, "localhost");
+    std::lock_guard<std::mutex> lock(action_mutex_);
 
-    //Paramters to use when ref box is running on remote machine.
-    ros::param::param<int>("~public_port", public_port_, 4444);
-    ros::param::param<int>("~team_port", team_port_, 4452);
+    //goals which are not running anymore already have their result
+    if (!drilling_machine_tracker_.active() || goal != drilling_machine_goal_) {
+        return;
+    }
 
-    //Paramters to use when ref box is running on same machine as client.
-    ros::param::param<int>("~refbox_send_port", public_recv_port_ , 4444);
-    ros::param::param<int>("~refbox_recv_port", public_send_port_, 4445);
-    ros::param::param<int>("~team_send_port", team_send_port_, 4453);
-    ros::param::param<int>("~team_recv_port", team_recv_port_, 4452);
+    //the machine keeps moving, the goal only stops being tracked
+    drilling_machine_tracker_.cancel();
+    goal.setCanceled(drillingMachineResult(CommandTracker::Clock::now()));
+    ++drilling_machine_statistics_.canceled;
+}
 
-    ros::param::param<std::string>("~robot_name", robot_name_, "spqr");
-    ros::param::param<std::string>("~team_name", team_name_, "SPQR");
+void RobotExampleROS::conveyorBeltGoalCB(ConveyorBeltActionServer::GoalHandle goal)
+{
+    int64_t callback_time = steadyNow();
+    CommandTracker::Clock::time_point now = CommandTracker::Clock::now();
 
-    ROS_INFO("Hostname: %s", host_name_.c_str());
+    std::lock_guard<std::mutex> lock(action_mutex_);
 
-    if (remote_refbox_) {
-        ROS_INFO("Team Port: %i", team_port_);
-        ROS_INFO("Public Port: %i", public_port_);
-    } else {
-        ROS_INFO("Team Send Port: %i", team_send_port_);
-        ROS_INFO("Team Receieve Port: %i", team_recv_port_);
-        ROS_INFO("Refbox Send Port: %i", public_recv_port_);
-        ROS_INFO("Refbox Receieve Port: %i", public_send_port_);
+    at_work_robot_example_ros::ConveyorBeltResult rejected;
+    rejected.state = conveyor_belt_state_;
+    rejected.cycle = conveyor_belt_cycle_;
+
+    uint8_t command = goal.getGoal()->command;
+    if (command != at_work_robot_example_ros::ConveyorBeltGoal::STOP
+        && command != at_work_robot_example_ros::ConveyorBeltGoal::START) {
+        goal.setRejected(rejected, "unknown command");
+        return;
     }
-    ROS_INFO("Name: %s", robot_name_.c_str());
-    ROS_INFO("Team Name: %s", team_name_.c_str());
-}
 
-void RobotExampleROS::initializeRobot()
-{
-    //create public peer
-    if (remote_refbox_) {
-        //ref box is running on remote machine.
-        peer_public_.reset(new ProtobufBroadcastPeer(host_name_, 
-                                                    public_port_));
-    } else {
-        //ref box is running on same machine as client.
-        peer_public_.reset(new ProtobufBroadcastPeer(host_name_, 
-                                                    public_send_port_, 
-                                                    public_recv_port_));    
+    //the command has to name the cycle after the current one
+    if (!conveyor_belt_status_known_) {
+        goal.setRejected(rejected, "no conveyor belt status received yet");
+        return;
     }
-    
 
-    //create internal message handler
-    MessageRegister &message_register = peer_public_->message_register();
-    //added messagetype to the handler
-    message_register.add_message_type<AttentionMessage>();
-    message_register.add_message_type<BeaconSignal>();
-    message_register.add_message_type<BenchmarkState>();
-    message_register.add_message_type<BenchmarkFeedback>();
-    message_register.add_message_type<Inventory>();
-    message_register.add_message_type<OrderInfo>();
-    message_register.add_message_type<RobotInfo>();
-    message_register.add_message_type<VersionInfo>();
-    message_register.add_message_type<DrillingMachineStatus>();
-    message_register.add_message_type<TriggeredConveyorBeltStatus>();
-    message_register.add_message_type<DrillingMachineCommand>();
-    message_register.add_message_type<TriggeredConveyorBeltCommand>();
-
-    //create team peer and linked to internal message handler
-    if (remote_refbox_) {
-        //ref box is running on remote machine.
-        peer_team_.reset(new ProtobufBroadcastPeer(host_name_,
-                                                    team_port_, 
-                                                    &message_register));
-    } else {
-        //ref box is running on same machine as client.
-        peer_team_.reset(new ProtobufBroadcastPeer(host_name_,
-                                                    team_send_port_, 
-                                                    team_recv_port_, 
-                                                    &message_register));
+    if (conveyor_belt_tracker_.active()) {
+        conveyor_belt_tracker_.cancel();
+        conveyor_belt_goal_.setAborted(conveyorBeltResult(now), "preempted by a new goal");
+        ++conveyor_belt_statistics_.preempted;
     }
 
-    //bind the peers to the callback funktions
-    peer_public_->signal_received().connect(boost::bind(&RobotExampleROS::handleMessage, this, _1, _2, _3, _4));
-    peer_public_->signal_send_error().connect(boost::bind( &RobotExampleROS::handleSendError, this, _1));
-    peer_public_->signal_recv_error().connect(boost::bind(&RobotExampleROS::handleReceiveError, this, _1, _2));
+    goal.setAccepted();
+
+    conveyor_belt_goal_ = goal;
+    conveyor_belt_command_ = (ConveyorBeltRunMode)command;
+    conveyor_belt_next_cycle_ = conveyor_belt_cycle_ + 1;
+
+    sendConveyorBeltCommand(conveyor_belt_command_, conveyor_belt_next_cycle_);
 
-    peer_team_->signal_received().connect(boost::bind(&RobotExampleROS::handleMessage, this, _1, _2, _3, _4));
-    peer_team_->signal_send_error().connect(boost::bind( &RobotExampleROS::handleSendError, this, _1));
-    peer_team_->signal_recv_error().connect(boost::bind(&RobotExampleROS::handleReceiveError, this, _1, _2));
+    conveyor_belt_tracker_.start(now, actionTimeout(goal.getGoal()->timeout),
+                        actionTimeout(action_retry_timeout_), std::max(action_max_attempts_, 1));
+
+    message_statistics_.sent<TriggeredConveyorBeltCommand>(callback_time, steadyNow());
 }
 
-void RobotExampleROS::sendBeacon()
+void RobotExampleROS::conveyorBeltCancelCB(ConveyorBeltActionServer::GoalHandle goal)
 {
-    //generate the timestamp
-    timespec start;
-    clock_gettime(CLOCK_REALTIME, &start);
-    int32_t sec = start.tv_sec;
-    int32_t nsec = start.tv_nsec;
+    std::lock_guard<std::mutex> lock(action_mutex_);
 
-    //create the message
-    std::shared_ptr<BeaconSignal> signal(new BeaconSignal());
-
-    //seperate the time segment of the message
-    Time *time = signal->mutable_time(); 
-    //write the timestamp into the message
-    time->set_sec(sec);
-    time->set_nsec(nsec);
+    if (!conveyor_belt_tracker_.active() || goal != conveyor_belt_goal_) {
+        return;
+    }
 
-    //write the name and sequence counter into the message
-    signal->set_peer_name(robot_name_);
-    signal->set_team_name(team_name_);
-    //increase the sequence number
-    signal->set_seq(++seq_);
-    //send over team peer       
-    peer_team_->send(signal);
+    conveyor_belt_tracker_.cancel();
+    goal.setCanceled(conveyorBeltResult(CommandTracker::Clock::now()));
+    ++conveyor_belt_statistics_.canceled;
 }
 
-void RobotExampleROS::handleSendError(std::string msg)
+void RobotExampleROS::actionTimerCB(const ros::SteadyTimerEvent &event)
 {
-    ROS_WARN("Send error: %s\n", msg.c_str());
+    CommandTracker::Clock::time_point now = CommandTracker::Clock::now();
+
+    DrillingMachineActionServer::GoalHandle drilling_machine_goal;
+    at_work_robot_example_ros::DrillingMachineResult drilling_machine_result;
+    bool drilling_machine_timed_out = false;
+
+    ConveyorBeltActionServer::GoalHandle conveyor_belt_goal;
+    at_work_robot_example_ros::ConveyorBeltResult conveyor_belt_result;
+    bool conveyor_belt_timed_out = false;
+
+    {
+        std::lock_guard<std::mutex> lock(action_mutex_);
+
+        switch (drilling_machine_tracker_.poll(now)) {
+            case CommandTracker::RESEND:
+                sendDrillingMachineCommand(drilling_machine_command_);
+                ++drilling_machine_statistics_.resent;
+                break;
+            case CommandTracker::TIMED_OUT:
+                ROS_WARN("Drilling machine did not complete command %i within the timeout",
+                         drilling_machine_command_);
+                drilling_machine_goal = drilling_machine_goal_;
+                drilling_machine_result = drillingMachineResult(now);
+                drilling_machine_timed_out = true;
+                ++drilling_machine_statistics_.timed_out;
+                break;
+            default:
+                break;
+        }
+
+        switch (conveyor_belt_tracker_.poll(now)) {
+            case CommandTracker::RESEND:
+                //the cycle did not change, so the command is still for the same one
+                sendConveyorBeltCommand(conveyor_belt_command_, conveyor_belt_next_cycle_);
+                ++conveyor_belt_statistics_.resent;
+                break;
+            case CommandTracker::TIMED_OUT:
+                ROS_WARN("Conveyor belt did not complete command %i for cycle %u within the timeout",
+                         conveyor_belt_command_, conveyor_belt_next_cycle_);
+                conveyor_belt_goal = conveyor_belt_goal_;
+                conveyor_belt_result = conveyorBeltResult(now);
+                conveyor_belt_timed_out = true;
+                ++conveyor_belt_statistics_.timed_out;
+                break;
+            default:
+                break;
+        }
+    }
+
+    //see trackDrillingMachine for why the goals are set outside the lock
+    if (drilling_machine_timed_out) {
+        drilling_machine_goal.setAborted(drilling_machine_result, "timed out");
+    }
+    if (conveyor_belt_timed_out) {
+        conveyor_belt_goal.setAborted(conveyor_belt_result, "timed out");
+    }
 }
 
-void RobotExampleROS::handleReceiveError(boost::asio::ip::udp::endpoint &endpoint,
-                        std::string msg)
+void RobotExampleROS::BenchmarkFeedbackCB(const at_work_robot_example_ros::BenchmarkFeedback::ConstPtr &msg)
 {
-    ROS_WARN("Recv error: %s\n", msg.c_str());
+    int64_t callback_time = steadyNow();
+
+    if (!benchmark_feedback_limiter_.tryAcquire(RateLimiter::Clock::now())) {
+        message_statistics_.rateLimited<BenchmarkFeedback>();
+        return;
+    }
+
+    //reuse the outbound message
+    OutboundMessage<BenchmarkFeedback>::Lease benchmark_feedback(benchmark_feedback_out_);
+
+    //fill the message, the plate states default to valid ones
+    converters::toProtobuf(*msg, *benchmark_feedback);
+
+    //send the Message over team peer
+    sendToTeam(*benchmark_feedback);
+
+    message_statistics_.sent<BenchmarkFeedback>(callback_time, steadyNow());
 }
 
-void RobotExampleROS::handleMessage(boost::asio::ip::udp::endpoint &sender,
-                    uint16_t component_id, uint16_t msg_type,
-                    std::shared_ptr<google::protobuf::Message> msg)
+
+void RobotExampleROS::readParameters()
 {
-    std::shared_ptr<AttentionMessage> attention_msg_ptr;
+    int public_port;
+    int team_port;
+    int public_send_port;
+    int public_recv_port;
+    int team_send_port;
+    int team_recv_port;
 
-    std::shared_ptr<BenchmarkState> benchmark_state_ptr;
+    nh_.param<bool>("remote_refbox", client_config_.remote_refbox, false);
+    nh_.param<std::string>("host_name", client_config_.host_name, "localhost");
 
-    std::shared_ptr<DrillingMachineStatus> drill_machine_status_ptr;
+    //Paramters to use when ref box is running on remote machine.
+    nh_.param<int>("public_port", public_port, 4444);
+    nh_.param<int>("team_port", team_port, 4452);
 
-    std::shared_ptr<TriggeredConveyorBeltStatus> conveyor_belt_status_ptr;
+    //Paramters to use when ref box is running on same machine as client.
+    nh_.param<int>("refbox_send_port", public_recv_port , 4444);
+    nh_.param<int>("refbox_recv_port", public_send_port, 4445);
+    nh_.param<int>("team_send_port", team_send_port, 4453);
+    nh_.param<int>("team_recv_port", team_recv_port, 4452);
+
+    client_config_.public_port      = public_port;
+    client_config_.team_port        = team_port;
+    client_config_.public_send_port = public_send_port;
+    client_config_.public_recv_port = public_recv_port;
+    client_config_.team_send_port   = team_send_port;
+    client_config_.team_recv_port   = team_recv_port;
+
+    nh_.param<std::string>("robot_name", client_config_.robot_name, "spqr");
+    nh_.param<std::string>("team_name", client_config_.team_name, "SPQR");
+
+    nh_.param<std::string>("crypto_key", client_config_.crypto_key, "");
+    nh_.param<std::string>("cipher", client_config_.cipher, "aes-128-cbc");
+
+    //the ciphers protobuf_comm can set up; AES uses AES-NI where the CPU has it
+    const std::string &cipher = client_config_.cipher;
+    if (cipher != "aes-128-ecb" && cipher != "aes-128-cbc"
+        && cipher != "aes-256-ecb" && cipher != "aes-256-cbc") {
+        ROS_WARN("Unsupported cipher %s, using aes-128-cbc", cipher.c_str());
+        client_config_.cipher = "aes-128-cbc";
+    }
 
-    std::shared_ptr<Inventory> inventory_pub_ptr;
+    nh_.param<double>("full_snapshot_period", full_snapshot_period_, 5.0);
+    nh_.param<int>("receive_queue_size", receive_queue_size_, 1024);
+    nh_.param<int>("socket_receive_buffer", client_config_.socket_receive_buffer, 0);
+    nh_.param<int>("socket_send_buffer", client_config_.socket_send_buffer, 0);
+    nh_.param<double>("beacon_period", beacon_period_, 0.1);
+
+    int transaction_window;
+    int transaction_max_attempts;
+    double transaction_retransmit_timeout;
+    double transaction_max_retransmit_timeout;
+
+    nh_.param<double>("transaction_send_period", transaction_send_period_, 0.01);
+    nh_.param<int>("transaction_window", transaction_window, 8);
+    nh_.param<double>("transaction_retransmit_timeout", transaction_retransmit_timeout, 0.5);
+    nh_.param<double>("transaction_max_retransmit_timeout", transaction_max_retransmit_timeout, 4.0);
+    nh_.param<int>("transaction_max_attempts", transaction_max_attempts, 10);
+
+    nh_.param<double>("diagnostics_period", diagnostics_period_, 1.0);
+
+    int clock_window;
+    int clock_min_samples;
+
+    nh_.param<double>("health_check_period", health_check_period_, 0.1);
+    nh_.param<double>("refbox_timeout", refbox_timeout_, 2.0);
+    nh_.param<double>("team_timeout", team_timeout_, 5.0);
+    nh_.param<double>("reconnect_backoff_min", reconnect_backoff_min_, 0.1);
+    nh_.param<double>("reconnect_backoff_max", reconnect_backoff_max_, 5.0);
+    nh_.param<double>("reconnect_send_error_rate", reconnect_send_error_rate_, 0.0);
+    nh_.param<int>("reconnect_buffer_size", reconnect_buffer_size_, 256);
+
+    nh_.param<std::string>("refbox_peer_name", refbox_peer_name_, "RefBox");
+    nh_.param<int>("clock_window", clock_window, 64);
+    nh_.param<int>("clock_min_samples", clock_min_samples, 8);
+    nh_.param<double>("clock_delay_warning", clock_delay_warning_, 0.05);
+    nh_.param<double>("clock_jitter_warning", clock_jitter_warning_, 0.02);
+
+    refbox_clock_.configure(std::max(clock_window, 1), std::max(clock_min_samples, 1));
+    benchmark_clock_.configure(std::max(clock_window, 1), std::max(clock_min_samples, 1));
+
+    bool suppress_unchanged_state;
+    double state_heartbeat_period;
+
+    nh_.param<bool>("suppress_unchanged_state", suppress_unchanged_state, true);
+    nh_.param<double>("state_heartbeat_period", state_heartbeat_period, 1.0);
+
+    benchmark_state_filter_.configure(suppress_unchanged_state, state_heartbeat_period);
+    drill_machine_status_filter_.configure(suppress_unchanged_state, state_heartbeat_period);
+    conveyor_belt_status_filter_.configure(suppress_unchanged_state, state_heartbeat_period);
+
+    nh_.param<double>("action_timeout", action_timeout_, 15.0);
+    nh_.param<double>("action_retry_timeout", action_retry_timeout_, 2.0);
+    nh_.param<int>("action_max_attempts", action_max_attempts_, 3);
+    nh_.param<double>("action_check_period", action_check_period_, 0.05);
+
+    nh_.param<std::string>("capture_path", capture_path_, "");
+    nh_.param<std::string>("replay_path", replay_path_, "");
+    nh_.param<double>("replay_speed", replay_speed_, 1.0);
+
+    nh_.param<std::string>("shared_snapshot_name", shared_snapshot_name_, "");
+    nh_.param<int>("shared_snapshot_size", shared_snapshot_size_, 1024 * 1024);
+
+    nh_.param<std::string>("journal_path", journal_path_, "");
+    nh_.param<int>("journal_size", journal_size_, 4 * 1024 * 1024);
+    nh_.param<double>("journal_sync_period", journal_sync_period_, 0.05);
+
+    transaction_config_.window = std::max(transaction_window, 1);
+    transaction_config_.max_attempts = std::max(transaction_max_attempts, 0);
+    transaction_config_.retransmit_timeout = std::chrono::duration_cast<TransactionSequencer::Clock::duration>(
+                        std::chrono::duration<double>(transaction_retransmit_timeout));
+    transaction_config_.max_retransmit_timeout = std::chrono::duration_cast<TransactionSequencer::Clock::duration>(
+                        std::chrono::duration<double>(transaction_max_retransmit_timeout));
+
+    ROS_INFO("Hostname: %s", client_config_.host_name.c_str());
+
+    if (client_config_.remote_refbox) {
+        ROS_INFO("Team Port: %i", team_port);
+        ROS_INFO("Public Port: %i", public_port);
+    } else {
+        ROS_INFO("Team Send Port: %i", team_send_port);
+        ROS_INFO("Team Receieve Port: %i", team_recv_port);
+        ROS_INFO("Refbox Send Port: %i", public_recv_port);
+        ROS_INFO("Refbox Receieve Port: %i", public_send_port);
+    }
+    ROS_INFO("Name: %s", client_config_.robot_name.c_str());
+    ROS_INFO("Team Name: %s", client_config_.team_name.c_str());
+    if (client_config_.crypto_key.empty()) {
+        ROS_INFO("Team Encryption: disabled");
+    } else {
+        ROS_INFO("Team Encryption: %s", client_config_.cipher.c_str());
+    }
+    ROS_INFO("Full Snapshot Period: %.2f s", full_snapshot_period_);
+    ROS_INFO("Receive Queue Size: %i", receive_queue_size_);
+    if (client_config_.socket_receive_buffer > 0 || client_config_.socket_send_buffer > 0) {
+        ROS_INFO("Socket Buffers: %i bytes receive, %i bytes send (0 is the kernel default)",
+                 client_config_.socket_receive_buffer, client_config_.socket_send_buffer);
+    } else {
+        ROS_INFO("Socket Buffers: kernel default");
+    }
+    ROS_INFO("Beacon Period: %.3f s", beacon_period_);
+    ROS_INFO("Transaction Send Period: %.3f s", transaction_send_period_);
+    ROS_INFO("Transaction Window: %zu", transaction_config_.window);
+    ROS_INFO("Transaction Retransmit Timeout: %.3f - %.3f s, %u attempts",
+             transaction_retransmit_timeout, transaction_max_retransmit_timeout,
+             transaction_config_.max_attempts);
+    if (!suppress_unchanged_state) {
+        ROS_INFO("Unchanged States: published");
+    } else if (state_heartbeat_period > 0) {
+        ROS_INFO("Unchanged States: republished every %.2f s", state_heartbeat_period);
+    } else {
+        ROS_INFO("Unchanged States: suppressed");
+    }
+    if (diagnostics_period_ > 0) {
+        ROS_INFO("Diagnostics Period: %.2f s", diagnostics_period_);
+    } else {
+        ROS_INFO("Diagnostics: disabled");
+    }
+    if (health_check_period_ > 0) {
+        ROS_INFO("Health Check: every %.2f s, refbox timeout %.1f s, team timeout %.1f s, "
+                 "send errors above %.1f Hz, backoff %.2f - %.1f s, %i messages buffered",
+                 health_check_period_, refbox_timeout_, team_timeout_, reconnect_send_error_rate_,
+                 reconnect_backoff_min_, reconnect_backoff_max_, reconnect_buffer_size_);
+    } else {
+        ROS_INFO("Health Check: disabled");
+    }
+    ROS_INFO("Clock Estimate: beacons of %s, window of %i, warning above %.3f s delay or %.3f s jitter",
+             refbox_peer_name_.c_str(), clock_window, clock_delay_warning_, clock_jitter_warning_);
+    ROS_INFO("Machine Actions: timeout %.1f s, resent after %.1f s up to %i attempts",
+             action_timeout_, action_retry_timeout_, action_max_attempts_);
+    if (!capture_path_.empty()) {
+        ROS_INFO("Capture: %s", capture_path_.c_str());
+    }
+    if (!replay_path_.empty()) {
+        ROS_INFO("Replay: %s at %.1fx", replay_path_.c_str(), replay_speed_);
+    }
+    if (!shared_snapshot_name_.empty()) {
+        ROS_INFO("Shared Snapshots: %s, %i bytes per snapshot", shared_snapshot_name_.c_str(),
+                 shared_snapshot_size_);
+    }
+    if (journal_path_.empty()) {
+        ROS_INFO("Journal: disabled");
+    } else {
+        ROS_INFO("Journal: %s, %i bytes, synced every %.3f s",
+                 journal_path_.c_str(), journal_size_, journal_sync_period_);
+    }
+}
 
-    std::shared_ptr<OrderInfo> order_info_ptr;
-             
-    if ((attention_msg_ptr = std::dynamic_pointer_cast<AttentionMessage>(msg))) {
+TopicQos RobotExampleROS::topicQos(const std::string &topic, int default_queue_size)
+{
+    const std::string prefix = "qos/" + topic + "/";
+    TopicQos qos;
 
-        at_work_robot_example_ros::AttentionMessage attention_msg;
+    nh_.param<int>(prefix + "queue_size", qos.queue_size, default_queue_size);
+    nh_.param<bool>(prefix + "keep_latest", qos.keep_latest, false);
+    nh_.param<double>(prefix + "max_rate", qos.max_rate, 0.0);
+    nh_.param<double>(prefix + "burst", qos.burst, 1.0);
 
-        attention_msg.message.data      = attention_msg_ptr->message();
-        attention_msg.time_to_show.data = attention_msg_ptr->time_to_show();
-        attention_msg.team.data         = attention_msg_ptr->team();
+    if (qos.keep_latest) {
+        qos.queue_size = 1;
+    }
 
-        attention_message_pub_.publish(attention_msg);
+    if (qos.max_rate > 0) {
+        ROS_INFO("Topic %s: queue size %i%s, at most %.1f Hz in bursts of %.0f", topic.c_str(),
+                 qos.queue_size, qos.keep_latest ? " (keep latest)" : "", qos.max_rate, qos.burst);
+    } else if (qos.queue_size != default_queue_size) {
+        ROS_INFO("Topic %s: queue size %i%s", topic.c_str(),
+                 qos.queue_size, qos.keep_latest ? " (keep latest)" : "");
+    }
 
-    } else if ((benchmark_state_ptr = std::dynamic_pointer_cast<BenchmarkState>(msg))) {
+    return qos;
+}
 
-        at_work_robot_example_ros::BenchmarkState benchmark_state_msg;
+template <class MT>
+void RobotExampleROS::addMessageType()
+{
+    client_->registerMessageType<MT>();
+    message_statistics_.add<MT>();
+}
 
-        benchmark_state_msg.benchmark_time.data.sec =
-                                        benchmark_state_ptr->benchmark_time().sec();
-        benchmark_state_msg.benchmark_time.data.nsec =
-                                        benchmark_state_ptr->benchmark_time().nsec();
-        benchmark_state_msg.state.data =
-                                        benchmark_state_ptr->state();
-        benchmark_state_msg.phase.data =
-                                        benchmark_state_ptr->phase();
-        benchmark_state_msg.scenario.type.data =
-                                        benchmark_state_ptr->scenario().type();
-        benchmark_state_msg.scenario.type_id.data =
-                                        benchmark_state_ptr->scenario().type_id();
-        benchmark_state_msg.scenario.description.data =
-                                        benchmark_state_ptr->scenario().description();
+template <class MT>
+void RobotExampleROS::registerMessageType(void (RobotExampleROS::*handler)(const MT &))
+{
+    addMessageType<MT>();
 
-        benchmark_state_msg.known_teams.resize(benchmark_state_ptr->known_teams().size());
+    client_->onMessage(std::function<void (const MT &)>(
+        [this, handler](const MT &msg) {
+            (this->*handler)(msg);
+        }));
+}
 
-        for(int i=0; i < benchmark_state_ptr->known_teams().size(); i++) {
-            benchmark_state_msg.known_teams[i].data =
-                                        benchmark_state_ptr->known_teams(i);
-        }
+void RobotExampleROS::initializeRobot()
+{
+    //create the receive queues and start draining them
+    public_queue_.reset(new ReceiveQueue(receive_queue_size_));
+    team_queue_.reset(new ReceiveQueue(receive_queue_size_));
 
-        benchmark_state_msg.connected_teams.resize(benchmark_state_ptr->connected_teams().size());
+    if (!capture_path_.empty()) {
+        capture_.reset(new TrafficCapture);
 
-        for(int i=0; i < benchmark_state_ptr->connected_teams().size(); i++) {
-            benchmark_state_msg.connected_teams[i].data =
-                                        benchmark_state_ptr->connected_teams(i);
+        if (!capture_->open(capture_path_, steadyNow())) {
+            ROS_WARN("Capture disabled: %s", capture_->error().c_str());
+            capture_.reset();
         }
+    }
 
-        benchmark_state_pub_.publish(benchmark_state_msg);
+    if (!shared_snapshot_name_.empty()) {
+        shared_snapshot_.reset(new SnapshotExport);
 
-    } else if ((drill_machine_status_ptr = std::dynamic_pointer_cast<DrillingMachineStatus>(msg))) {
+        if (!shared_snapshot_->open(shared_snapshot_name_, std::max(shared_snapshot_size_, 0))) {
+            ROS_WARN("Shared snapshots disabled: %s", shared_snapshot_->error().c_str());
+            shared_snapshot_.reset();
+        }
+    }
 
-        at_work_robot_example_ros::DrillingMachineStatus drill_machine_msg;
+    dispatch_running_ = true;
+    dispatch_thread_ = std::thread(&RobotExampleROS::dispatchMessages, this);
+
+    //the peers only queue the messages, the dispatch thread handles them
+    client_.reset(new CFHClient(client_config_));
+
+    client_->onReceive([this](CFHClient::Channel channel, uint16_t component_id, uint16_t msg_type,
+                              const std::shared_ptr<google::protobuf::Message> &msg) {
+                            receiveMessage(channel, component_id, msg_type, msg);
+                        });
+    client_->onSendError([this](const std::string &msg) {
+                            handleSendError(msg);
+                        });
+    client_->onReceiveError([this](const std::string &msg) {
+                            handleReceiveError(msg);
+                        });
+
+    //transactions are sent over the team peer by the send cycle
+    transaction_sequencer_.reset(new TransactionSequencer(transaction_config_,
+                        [this](Transaction &transaction) {
+                            sendToTeam(transaction);
+                        }));
+
+    //journal each transaction before it can be sent, and its completion
+    transaction_sequencer_->onSubmit([this](const Transaction &transaction) {
+                            if (journal_) {
+                                journal_->appendTransaction(transaction);
+                            }
+                        });
+    transaction_sequencer_->onCompletion([this](uint64_t transaction_id, bool confirmed) {
+                            if (journal_) {
+                                journal_->appendTransactionDone(transaction_id);
+                            }
+                        });
 
-        drill_machine_msg.state.data = drill_machine_status_ptr->state();
+    //create internal message handler
+    //added messagetype to the handler
+    //and the handlers for the types which are published
+    registerMessageType<AttentionMessage>(&RobotExampleROS::handleAttentionMessage);
+    registerMessageType<BeaconSignal>(&RobotExampleROS::handleBeaconSignal);
+    registerMessageType<BenchmarkState>(&RobotExampleROS::handleBenchmarkState);
+    addMessageType<BenchmarkFeedback>();
+    registerMessageType<Inventory>(&RobotExampleROS::handleInventory);
+    registerMessageType<OrderInfo>(&RobotExampleROS::handleOrderInfo);
+    addMessageType<RobotInfo>();
+    addMessageType<VersionInfo>();
+    registerMessageType<DrillingMachineStatus>(&RobotExampleROS::handleDrillingMachineStatus);
+    registerMessageType<TriggeredConveyorBeltStatus>(&RobotExampleROS::handleTriggeredConveyorBeltStatus);
+    addMessageType<DrillingMachineCommand>();
+    addMessageType<TriggeredConveyorBeltCommand>();
+
+    //types which are only sent
+    message_statistics_.add<RobotStatus>();
+    message_statistics_.add<Transaction>();
+    message_statistics_.add<LoggingStatus>();
+
+    if (!replay_path_.empty()) {
+        //replay a capture instead of connecting to the refbox
+        replay_.reset(new TrafficReplay);
+
+        if (replay_->open(replay_path_)) {
+            replay_running_ = true;
+            replay_thread_ = std::thread(&RobotExampleROS::replayTraffic, this);
+        } else {
+            ROS_WARN("Replay failed: %s", replay_->error().c_str());
+        }
 
-        drill_machine_status_pub_.publish(drill_machine_msg);
+        openJournal();
+        return;
+    }
 
-    } else if ((conveyor_belt_status_ptr = std::dynamic_pointer_cast<TriggeredConveyorBeltStatus>(msg))) {
+    if (!client_config_.public_peer) {
+        ROS_INFO("%s: public broadcasts are received by the gateway", client_config_.robot_name.c_str());
+    }
 
-        at_work_robot_example_ros::TriggeredConveyorBeltStatus conveyor_belt_status_msg;
+    createPeers();
 
-        conveyor_belt_status_msg.state.data = conveyor_belt_status_ptr->state();
+    openJournal();
+}
 
-        conveyor_belt_status_msg.cycle.data = conveyor_belt_status_ptr->cycle();
+void RobotExampleROS::createPeers()
+{
+    client_->start();
 
-        conveyor_belt_status_pub_.publish(conveyor_belt_status_msg);
+    if (!client_->socketError().empty()) {
+        ROS_WARN("%s: %s", client_config_.robot_name.c_str(), client_->socketError().c_str());
+    }
+}
 
-    } else if ((inventory_pub_ptr = std::dynamic_pointer_cast<Inventory>(msg))) {
+void RobotExampleROS::openJournal()
+{
+    if (journal_path_.empty()) {
+        return;
+    }
 
-        at_work_robot_example_ros::Inventory inventory_msg;
+    std::shared_ptr<OutboundJournal> journal(new OutboundJournal);
+    OutboundJournal::Recovery recovery;
 
-        inventory_msg.items.resize(inventory_pub_ptr->items().size());
+    if (!journal->open(journal_path_, journal_size_, recovery)) {
+        ROS_WARN("Journal disabled: %s", journal->error().c_str());
+        return;
+    }
 
-        for(int i=0; i < inventory_pub_ptr->items().size(); i++) {
+    if (recovery.damaged) {
+        ROS_WARN("Journal %s ends with a damaged record, it was ignored", journal_path_.c_str());
+    }
 
-            inventory_msg.items[i].object.type.data =
-                                        inventory_pub_ptr->items(i).object().type();
+    //unconfirmed transactions keep their ids and go out first
+    transaction_sequencer_->setNextTransactionId(recovery.next_transaction_id);
+    for (size_t i = 0; i < recovery.transactions.size(); i++) {
+        transaction_sequencer_->restore(recovery.transactions[i]);
+    }
 
-            inventory_msg.items[i].object.type_id.data =
-                                        inventory_pub_ptr->items(i).object().type_id();
+    journal_ = journal;
+
+    //of the unsent commands only the last one of each type is still wanted
+    std::vector<bool> superseded(recovery.commands.size(), false);
+    for (size_t i = 0; i < recovery.commands.size(); i++) {
+        for (size_t j = i + 1; j < recovery.commands.size(); j++) {
+            if (recovery.commands[j].component_id == recovery.commands[i].component_id
+                && recovery.commands[j].msg_type == recovery.commands[i].msg_type) {
+                superseded[i] = true;
+                break;
+            }
+        }
+    }
 
-            inventory_msg.items[i].object.instance_id.data =
-                                        inventory_pub_ptr->items(i).object().instance_id();
+    size_t resent_commands = 0;
+    for (size_t i = 0; i < recovery.commands.size(); i++) {
+        if (superseded[i]) {
+            continue;
+        }
 
-            inventory_msg.items[i].object.description.data =
-                                        inventory_pub_ptr->items(i).object().description();
+        const OutboundJournal::Command &command = recovery.commands[i];
+        if (replayCommand(command, drilling_machine_command_out_)
+            || replayCommand(command, conveyor_belt_command_out_)
+            || replayCommand(command, logging_status_out_)) {
+            ++resent_commands;
+        }
+    }
 
-            inventory_msg.items[i].quantity.data =
-                                        inventory_pub_ptr->items(i).quantity();
+    ROS_INFO("Journal %s: next transaction id %lu, resending %zu transactions and %zu commands",
+             journal_path_.c_str(), (unsigned long)recovery.next_transaction_id,
+             recovery.transactions.size(), resent_commands);
+}
 
-            inventory_msg.items[i].container.type.data =
-                                        inventory_pub_ptr->items(i).container().type();
+template <class MT>
+bool RobotExampleROS::replayCommand(const OutboundJournal::Command &command, OutboundMessage<MT> &outbound)
+{
+    if (command.component_id != MT::COMP_ID || command.msg_type != MT::MSG_TYPE) {
+        return false;
+    }
 
-            inventory_msg.items[i].container.type_id.data =
-                                        inventory_pub_ptr->items(i).container().type_id();
+    typename OutboundMessage<MT>::Lease msg(outbound);
 
-            inventory_msg.items[i].container.instance_id.data =
-                                        inventory_pub_ptr->items(i).container().instance_id();
+    if (!msg->ParseFromString(command.payload)) {
+        return false;
+    }
 
-            inventory_msg.items[i].container.description.data =
-                                        inventory_pub_ptr->items(i).container().description();
+    sendCommand(*msg);
 
-            inventory_msg.items[i].location.type.data =
-                                        inventory_pub_ptr->items(i).location().type();
+    return true;
+}
 
-            inventory_msg.items[i].location.instance_id.data =
-                                        inventory_pub_ptr->items(i).location().instance_id();
+void RobotExampleROS::sendToTeam(google::protobuf::Message &msg)
+{
+    std::lock_guard<std::mutex> lock(peer_mutex_);
 
-            inventory_msg.items[i].location.description.data =
-                                        inventory_pub_ptr->items(i).location().description();
-        }
+    if (!peers_broken_) {
+        client_->send(msg);
+        return;
+    }
 
-        inventory_pub_.publish(inventory_msg);
+    //a fresh beacon follows the reconnect
+    if (msg.GetDescriptor() == BeaconSignal::descriptor() || reconnect_buffer_size_ <= 0) {
+        return;
+    }
 
-    }  else if ((order_info_ptr = std::dynamic_pointer_cast<OrderInfo>(msg))) {
+    if (reconnect_buffer_.size() >= static_cast<size_t>(reconnect_buffer_size_)) {
+        reconnect_buffer_.pop_front();
+        ++reconnect_buffer_drops_;
+    }
 
-        at_work_robot_example_ros::OrderInfo order_info_msg;
+    std::shared_ptr<google::protobuf::Message> copy(msg.New());
+    copy->CopyFrom(msg);
+    reconnect_buffer_.push_back(copy);
+}
 
-        order_info_msg.orders.resize(order_info_ptr->orders().size());
+void RobotExampleROS::healthTimerCB(const ros::SteadyTimerEvent &event)
+{
+    int64_t now = steadyNow();
 
-        for(int i=0; i < order_info_ptr->orders().size(); i++) {
+    //receive errors include the datagrams of other teams which cannot be decoded,
+    //only failed sends tell a broken socket
+    unsigned long send_errors = message_statistics_.sendErrors();
 
-            order_info_msg.orders[i].id.data =
-                                        order_info_ptr->orders(i).id();
-            order_info_msg.orders[i].status.data =
-                                        order_info_ptr->orders(i).status();
+    //timeouts only count once the refbox was heard, and restart with every reconnect
+    int64_t last_public = last_public_receive_.load(std::memory_order_relaxed);
+    int64_t last_listed = last_team_listed_.load(std::memory_order_relaxed);
 
-            order_info_msg.orders[i].object.type.data =
-                                        order_info_ptr->orders(i).object().type();
+    //the gateway checks and recreates its public peer itself, a robot can only fix its team peer
+    bool refbox_heard = last_public != 0 && now - last_public <= refbox_timeout_ * 1e9;
 
-            order_info_msg.orders[i].object.type_id.data =
-                                        order_info_ptr->orders(i).object().type_id();
+    const char *reason = NULL;
 
-            order_info_msg.orders[i].object.instance_id.data =
-                                        order_info_ptr->orders(i).object().instance_id();
+    if (send_errors - health_send_errors_ > reconnect_send_error_rate_ * health_check_period_) {
+        reason = "send errors";
+    } else if (client_config_.public_peer && last_public != 0
+               && now - std::max(last_public, last_reconnect_) > refbox_timeout_ * 1e9) {
+        reason = "refbox timeout";
+    } else if (last_listed != 0 && (client_config_.public_peer || refbox_heard)
+               && now - std::max(last_listed, last_reconnect_) > team_timeout_ * 1e9) {
+        reason = "team not connected";
+    }
 
-            order_info_msg.orders[i].object.description.data =
-                                        order_info_ptr->orders(i).object().description();
+    health_send_errors_ = send_errors;
 
-            order_info_msg.orders[i].container.type.data =
-                                        order_info_ptr->orders(i).container().type();
+    std::lock_guard<std::mutex> lock(peer_mutex_);
 
-            order_info_msg.orders[i].container.type_id.data =
-                                        order_info_ptr->orders(i).container().type_id();
+    if (!reason) {
+        //the refbox was heard since the last reconnect, through the team peer in the gateway
+        if ((!client_config_.public_peer ? last_listed : last_public) > last_reconnect_) {
+            reconnect_backoff_ = reconnect_backoff_min_;
+        }
+        return;
+    }
 
-            order_info_msg.orders[i].container.instance_id.data =
-                                        order_info_ptr->orders(i).container().instance_id();
+    peers_broken_ = true;
 
-            order_info_msg.orders[i].container.description.data =
-                                        order_info_ptr->orders(i).container().description();
+    if (now < next_reconnect_) {
+        return;
+    }
 
-            order_info_msg.orders[i].quantity_delivered.data =
-                                        order_info_ptr->orders(i).quantity_delivered();
+    reconnectPeers(reason);
 
-            order_info_msg.orders[i].quantity_requested.data =
-                                        order_info_ptr->orders(i).quantity_requested();
+    last_reconnect_ = steadyNow();
+    next_reconnect_ = last_reconnect_ + static_cast<int64_t>(reconnect_backoff_ * 1e9);
+    reconnect_backoff_ = std::min(reconnect_backoff_ * 2, reconnect_backoff_max_);
+}
 
-            order_info_msg.orders[i].destination.type.data =
-                                        order_info_ptr->orders(i).destination().type();
+void RobotExampleROS::reconnectPeers(const char *reason)
+{
+    ROS_WARN("%s: recreating the peers after %s, %zu team messages buffered",
+             client_config_.robot_name.c_str(), reason, reconnect_buffer_.size());
 
-            order_info_msg.orders[i].destination.instance_id.data =
-                                        order_info_ptr->orders(i).destination().instance_id();
+    public_socket_drops_ += client_->publicSockets().statistics().drops;
+    team_socket_drops_ += client_->teamSockets().statistics().drops;
 
-            order_info_msg.orders[i].destination.description.data =
-                                        order_info_ptr->orders(i).destination().description();
+    //the old peers are the only producers of the receive queues, so they go first
+    client_->stop();
 
-            order_info_msg.orders[i].source.type.data =
-                                        order_info_ptr->orders(i).source().type();
+    try {
+        createPeers();
+    } catch (std::exception &e) {
+        //e.g. the interface is still down, the next attempt follows the backoff
+        ROS_WARN("%s: recreating the peers failed: %s", client_config_.robot_name.c_str(), e.what());
+        return;
+    }
 
-            order_info_msg.orders[i].source.instance_id.data =
-                                        order_info_ptr->orders(i).source().instance_id();
+    ++reconnects_;
+    peers_broken_ = false;
 
-            order_info_msg.orders[i].source.description.data =
-                                        order_info_ptr->orders(i).source().description();
+    while (!reconnect_buffer_.empty()) {
+        client_->send(*reconnect_buffer_.front());
+        reconnect_buffer_.pop_front();
+    }
+}
 
-            order_info_msg.orders[i].processing_team.data =
-                                        order_info_ptr->orders(i).processing_team();
-        }
+void RobotExampleROS::sendCommand(google::protobuf::Message &command)
+{
+    uint64_t seq = journal_ ? journal_->appendCommand(command) : 0;
 
-        order_info_pub_.publish(order_info_msg);
+    sendToTeam(command);
 
+    if (journal_) {
+        journal_->appendCommandSent(seq);
     }
 }
+
+void RobotExampleROS::sendBeacon()
+{
+    //reuse the outbound message
+    OutboundMessage<BeaconSignal>::Lease signal(beacon_signal_out_);
+
+    //write the timestamp, the names and the next sequence number into the message
+    client_->fillBeacon(*signal);
+
+    //send over team peer
+    sendToTeam(*signal);
+}
+
+void RobotExampleROS::beaconTimerCB(const ros::SteadyTimerEvent &event)
+{
+    sendBeacon();
+}
+
+void RobotExampleROS::journalTimerCB(const ros::SteadyTimerEvent &event)
+{
+    journal_->sync();
+}
+
+void RobotExampleROS::transactionTimerCB(const ros::SteadyTimerEvent &event)
+{
+    transaction_sequencer_->sendCycle(TransactionSequencer::Clock::now());
+
+    unsigned long given_up = transaction_sequencer_->statistics().given_up;
+    if (given_up != transactions_given_up_) {
+        ROS_WARN("%lu inventory transactions were not confirmed by the refbox and given up",
+                 given_up - transactions_given_up_);
+        transactions_given_up_ = given_up;
+    }
+}
+
+void RobotExampleROS::diagnosticsTimerCB(const ros::SteadyTimerEvent &event)
+{
+    ros::WallTime now = ros::WallTime::now();
+    double elapsed = (now - last_diagnostics_).toSec();
+    last_diagnostics_ = now;
+
+    diagnostic_msgs::DiagnosticArrayPtr diagnostics(new diagnostic_msgs::DiagnosticArray);
+    diagnostics->header.stamp = ros::Time::now();
+
+    const std::string prefix = nh_.getNamespace() + ": ";
+
+    const MessageStatistics::TypeMap &types = message_statistics_.types();
+    for (MessageStatistics::TypeMap::const_iterator it = types.begin(); it != types.end(); ++it) {
+        const MessageStatistics::TypeStatistics &type = *it->second;
+
+        unsigned long received = type.received.load(std::memory_order_relaxed);
+        unsigned long &last_received = diagnostics_received_[it->first];
+
+        diagnostic_msgs::DiagnosticStatus status;
+        status.level = diagnostic_msgs::DiagnosticStatus::OK;
+        status.name = prefix + type.name;
+        status.hardware_id = client_config_.robot_name;
+
+        addValue(status, "received", received);
+        addValue(status, "receive rate (Hz)", elapsed > 0 ? (received - last_received) / elapsed : 0.0);
+        addValue(status, "sent", type.sent.load(std::memory_order_relaxed));
+        addValue(status, "rate limited", type.rate_limited.load(std::memory_order_relaxed));
+        addLatency(status, "queue latency", type.queue_latency);
+        addLatency(status, "receive to publish", type.publish_latency);
+        addLatency(status, "callback to send", type.send_latency);
+
+        last_received = received;
+
+        diagnostics->status.push_back(status);
+    }
+
+    UdpSockets::Statistics public_socket;
+    UdpSockets::Statistics team_socket;
+    unsigned long public_socket_drops;
+    unsigned long team_socket_drops;
+
+    {
+        //a reconnect closes the sockets, their descriptors may be reused right away
+        std::lock_guard<std::mutex> lock(peer_mutex_);
+
+        public_socket = client_->publicSockets().statistics();
+        team_socket = client_->teamSockets().statistics();
+        public_socket_drops = public_socket_drops_ + public_socket.drops;
+        team_socket_drops = team_socket_drops_ + team_socket.drops;
+    }
+
+    //errors since the last publish raise a warning
+    unsigned long errors = message_statistics_.sendErrors() + message_statistics_.receiveErrors()
+                           + public_queue_->drops() + team_queue_->drops()
+                           + public_socket_drops + team_socket_drops;
+
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = prefix + "refbox connection";
+    status.hardware_id = client_config_.robot_name;
+
+    if (errors != diagnostics_errors_) {
+        status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+        status.message = "errors or dropped messages";
+    } else {
+        status.level = diagnostic_msgs::DiagnosticStatus::OK;
+        status.message = "OK";
+    }
+
+    addValue(status, "send errors", message_statistics_.sendErrors());
+    addValue(status, "receive errors", message_statistics_.receiveErrors());
+    addValue(status, "unhandled messages", unhandledMessageCount());
+    addValue(status, "public queue drops", public_queue_->drops());
+    addValue(status, "team queue drops", team_queue_->drops());
+
+    if (public_socket.sockets > 0) {
+        addValue(status, "public socket drops", public_socket_drops);
+        addValue(status, "public socket queued (bytes)", public_socket.receive_queue);
+        addValue(status, "public socket receive buffer (bytes)", public_socket.receive_buffer);
+    }
+
+    if (team_socket.sockets > 0) {
+        addValue(status, "team socket drops", team_socket_drops);
+        addValue(status, "team socket queued (bytes)", team_socket.receive_queue);
+        addValue(status, "team socket receive buffer (bytes)", team_socket.receive_buffer);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(peer_mutex_);
+
+        if (peers_broken_) {
+            status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+            status.message = "reconnecting";
+        }
+
+        addValue(status, "reconnects", reconnects_);
+        addValue(status, "buffered team messages", reconnect_buffer_.size());
+        addValue(status, "dropped team messages", reconnect_buffer_drops_);
+    }
+
+    diagnostics_errors_ = errors;
+
+    diagnostics->status.push_back(status);
+
+    ClockEstimator::Estimate refbox;
+    {
+        std::lock_guard<std::mutex> lock(clock_mutex_);
+        refbox = refbox_clock_.estimate();
+    }
+
+    diagnostic_msgs::DiagnosticStatus clock_status;
+    clock_status.name = prefix + "refbox clock";
+    clock_status.hardware_id = client_config_.robot_name;
+
+    if (!refbox.valid) {
+        clock_status.level = diagnostic_msgs::DiagnosticStatus::OK;
+        clock_status.message = "no estimate";
+    } else if (refbox.delay / 1e9 > clock_delay_warning_ || refbox.jitter / 1e9 > clock_jitter_warning_) {
+        clock_status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+        clock_status.message = "delay or jitter too high";
+    } else {
+        clock_status.level = diagnostic_msgs::DiagnosticStatus::OK;
+        clock_status.message = "OK";
+    }
+
+    addValue(clock_status, "samples", refbox.samples);
+    addValue(clock_status, "offset (ms)", refbox.offset / 1e6);
+    addValue(clock_status, "delay (ms)", refbox.delay / 1e6);
+    addValue(clock_status, "jitter (ms)", refbox.jitter / 1e6);
+
+    diagnostics->status.push_back(clock_status);
+
+    {
+        std::lock_guard<std::mutex> lock(action_mutex_);
+
+        diagnostics->status.push_back(actionStatus(prefix + "drilling machine action",
+                                                   drilling_machine_statistics_));
+        diagnostics->status.push_back(actionStatus(prefix + "conveyor belt action",
+                                                   conveyor_belt_statistics_));
+    }
+
+    diagnostics_pub_.publish(diagnostics);
+
+    //the capture is not thread-safe, the dispatch thread flushes it within its next wait
+    if (capture_) {
+        capture_flush_.store(true, std::memory_order_relaxed);
+    }
+}
+
+void RobotExampleROS::logStatistics()
+{
+    const MessageStatistics::TypeMap &types = message_statistics_.types();
+    for (MessageStatistics::TypeMap::const_iterator it = types.begin(); it != types.end(); ++it) {
+        const MessageStatistics::TypeStatistics &type = *it->second;
+
+        unsigned long received = type.received.load(std::memory_order_relaxed);
+        unsigned long sent = type.sent.load(std::memory_order_relaxed);
+        unsigned long rate_limited = type.rate_limited.load(std::memory_order_relaxed);
+        if (received == 0 && sent == 0 && rate_limited == 0) {
+            continue;
+        }
+
+        ROS_INFO("%s: %lu received, %lu sent, %lu rate limited",
+                 type.name.c_str(), received, sent, rate_limited);
+        logLatency(type.name, "queue latency", type.queue_latency);
+        logLatency(type.name, "receive to publish", type.publish_latency);
+        logLatency(type.name, "callback to send", type.send_latency);
+    }
+
+    ROS_INFO("Send errors: %lu, receive errors: %lu",
+             message_statistics_.sendErrors(), message_statistics_.receiveErrors());
+    ROS_INFO("Unchanged states not republished: %lu benchmark state, %lu drilling machine, "
+             "%lu conveyor belt", benchmark_state_filter_.suppressed(),
+             drill_machine_status_filter_.suppressed(), conveyor_belt_status_filter_.suppressed());
+
+    logAction("Drilling machine action", drilling_machine_statistics_);
+    logAction("Conveyor belt action", conveyor_belt_statistics_);
+}
+
+diagnostic_msgs::DiagnosticStatus RobotExampleROS::actionStatus(const std::string &name,
+                                                                const ActionStatistics &statistics)
+{
+    diagnostic_msgs::DiagnosticStatus status;
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    status.name = name;
+    status.hardware_id = client_config_.robot_name;
+
+    addValue(status, "succeeded", statistics.succeeded);
+    addValue(status, "timed out", statistics.timed_out);
+    addValue(status, "preempted", statistics.preempted);
+    addValue(status, "canceled", statistics.canceled);
+    addValue(status, "resent commands", statistics.resent);
+    addLatency(status, "command to effect", statistics.latency);
+
+    return status;
+}
+
+void RobotExampleROS::logAction(const std::string &name, const ActionStatistics &statistics)
+{
+    std::lock_guard<std::mutex> lock(action_mutex_);
+
+    if (statistics.succeeded + statistics.timed_out + statistics.preempted + statistics.canceled == 0) {
+        return;
+    }
+
+    ROS_INFO("%s: %lu succeeded, %lu timed out, %lu preempted, %lu canceled, %lu commands resent",
+             name.c_str(), statistics.succeeded, statistics.timed_out, statistics.preempted,
+             statistics.canceled, statistics.resent);
+    logLatency(name, "command to effect", statistics.latency);
+}
+
+void RobotExampleROS::handleSendError(std::string msg)
+{
+    message_statistics_.sendError();
+
+    ROS_WARN("Send error: %s\n", msg.c_str());
+}
+
+void RobotExampleROS::handleReceiveError(std::string msg)
+{
+    message_statistics_.receiveError();
+
+    ROS_WARN("Recv error: %s\n", msg.c_str());
+}
+
+unsigned long RobotExampleROS::unhandledMessageCount() const
+{
+    return client_->unhandledMessageCount();
+}
+
+RobotExampleROS::ReceiveQueueStatistics RobotExampleROS::publicQueueStatistics() const
+{
+    ReceiveQueueStatistics stats;
+
+    stats.capacity        = public_queue_->capacity();
+    stats.drops           = public_queue_->drops();
+    stats.high_water_mark = public_queue_->highWaterMark();
+
+    return stats;
+}
+
+RobotExampleROS::ReceiveQueueStatistics RobotExampleROS::teamQueueStatistics() const
+{
+    ReceiveQueueStatistics stats;
+
+    stats.capacity        = team_queue_->capacity();
+    stats.drops           = team_queue_->drops();
+    stats.high_water_mark = team_queue_->highWaterMark();
+
+    return stats;
+}
+
+void RobotExampleROS::receiveMessage(CFHClient::Channel channel,
+                    uint16_t component_id, uint16_t msg_type,
+                    const std::shared_ptr<google::protobuf::Message> &msg)
+{
+    if (channel == CFHClient::TEAM) {
+        queueMessage(team_queue_.get(), component_id, msg_type, msg);
+        return;
+    }
+
+    last_public_receive_.store(steadyNow(), std::memory_order_relaxed);
+
+    queueMessage(public_queue_.get(), component_id, msg_type, msg);
+}
+
+void RobotExampleROS::receivePublicMessage(uint16_t component_id, uint16_t msg_type,
+                    const std::shared_ptr<google::protobuf::Message> &msg)
+{
+    //the replay thread is the producer of the public queue then
+    if (replay_) {
+        return;
+    }
+
+    last_public_receive_.store(steadyNow(), std::memory_order_relaxed);
+
+    queueMessage(public_queue_.get(), component_id, msg_type, msg);
+}
+
+bool RobotExampleROS::queueMessage(ReceiveQueue *queue, uint16_t component_id, uint16_t msg_type,
+                    const std::shared_ptr<google::protobuf::Message> &msg)
+{
+    ReceivedMessage received;
+
+    received.component_id = component_id;
+    received.msg_type     = msg_type;
+    received.msg          = msg;
+    received.receive_time = steadyNow();
+
+    message_statistics_.received(component_id, msg_type);
+
+    if (!queue->push(std::move(received))) {
+        ROS_WARN_THROTTLE(1.0, "Receive queue full, dropped message (component %u, type %u)",
+                          component_id, msg_type);
+        return false;
+    }
+
+    //pairs with the fence in dispatchMessages, either we see the consumer
+    //waiting or it sees the message we just pushed
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (dispatch_waiting_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(dispatch_mutex_);
+        dispatch_cond_.notify_one();
+    }
+
+    return true;
+}
+
+void RobotExampleROS::replayTraffic()
+{
+    traffic_capture::Record record;
+    unsigned long replayed = 0;
+    unsigned long skipped = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int64_t first_time = -1;
+
+    while (replay_running_ && replay_->next(record)) {
+        if (first_time < 0) {
+            first_time = record.time;
+        }
+
+        //keep the captured spacing, scaled by the replay speed
+        if (replay_speed_ > 0) {
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds(
+                        static_cast<int64_t>((record.time - first_time) / replay_speed_)));
+        }
+
+        std::shared_ptr<google::protobuf::Message> msg;
+        try {
+            msg = client_->messageRegister().new_message_for(record.component_id, record.msg_type);
+        } catch (std::runtime_error &e) {
+            ++skipped;
+            continue;
+        }
+
+        if (!msg->ParseFromString(record.payload)) {
+            ++skipped;
+            continue;
+        }
+
+        ReceiveQueue *queue = record.peer == traffic_capture::TEAM ? team_queue_.get()
+                                                                   : public_queue_.get();
+
+        //a replay waits for the dispatch thread instead of dropping
+        while (replay_running_ && queue->full()) {
+            std::this_thread::yield();
+        }
+
+        if (queueMessage(queue, record.component_id, record.msg_type, msg)) {
+            ++replayed;
+        }
+    }
+
+    ROS_INFO("Replay of %s finished: %lu messages in %.3f s, %lu skipped",
+             replay_path_.c_str(), replayed,
+             std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+             skipped);
+}
+
+void RobotExampleROS::dispatchMessages()
+{
+    while (dispatch_running_) {
+        if (capture_flush_.exchange(false, std::memory_order_relaxed) && !capture_->flush()) {
+            ROS_WARN_THROTTLE(10.0, "Cannot flush the capture: %s", capture_->error().c_str());
+        }
+
+        bool handled = drainQueue(*public_queue_);
+        handled = drainQueue(*team_queue_) || handled;
+
+        if (handled) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(dispatch_mutex_);
+
+        dispatch_waiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (dispatch_running_ && public_queue_->empty() && team_queue_->empty()) {
+            dispatch_cond_.wait_for(lock, std::chrono::milliseconds(100));
+        }
+
+        dispatch_waiting_.store(false, std::memory_order_relaxed);
+    }
+}
+
+bool RobotExampleROS::drainQueue(ReceiveQueue &queue)
+{
+    ReceivedMessage received;
+    bool handled = false;
+
+    while (queue.pop(received)) {
+        if (capture_) {
+            traffic_capture::Peer peer = &queue == team_queue_.get() ? traffic_capture::TEAM
+                                                                     : traffic_capture::PUBLIC;
+            capture_->write(peer, received.component_id, received.msg_type,
+                            received.receive_time, *received.msg);
+        }
+
+        int64_t dispatch_time = steadyNow();
+
+        dispatch_receive_time_ = received.receive_time;
+        handleMessage(received.component_id, received.msg_type, received.msg);
+        handled = true;
+
+        message_statistics_.published(received.component_id, received.msg_type,
+                                      received.receive_time, dispatch_time, steadyNow());
+    }
+
+    return handled;
+}
+
+void RobotExampleROS::stopDispatching()
+{
+    if (!dispatch_thread_.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(dispatch_mutex_);
+        dispatch_running_ = false;
+        dispatch_cond_.notify_one();
+    }
+
+    dispatch_thread_.join();
+}
+
+void RobotExampleROS::handleMessage(uint16_t component_id, uint16_t msg_type,
+                    const std::shared_ptr<google::protobuf::Message> &msg)
+{
+    if (!client_->dispatch(component_id, msg_type, *msg)) {
+        handleUnknownMessage(component_id, msg_type);
+    }
+}
+
+void RobotExampleROS::handleUnknownMessage(uint16_t component_id, uint16_t msg_type)
+{
+    unsigned long count = client_->unhandledMessageCount();
+
+    ROS_DEBUG("Unhandled message (component %u, type %u), %lu so far",
+              component_id, msg_type, count);
+}
+
+void RobotExampleROS::handleAttentionMessage(const AttentionMessage &attention)
+{
+    at_work_robot_example_ros::AttentionMessagePtr attention_msg(
+                        new at_work_robot_example_ros::AttentionMessage);
+
+    converters::toRos(attention, *attention_msg);
+
+    attention_message_pub_.publish(attention_msg);
+}
+
+void RobotExampleROS::handleBeaconSignal(const BeaconSignal &beacon_signal)
+{
+    //beacons of the robots on the team channel carry their own clocks
+    if (beacon_signal.peer_name() != refbox_peer_name_) {
+        return;
+    }
+
+    int64_t send_time = beacon_signal.time().sec() * 1000000000LL + beacon_signal.time().nsec();
+
+    std::lock_guard<std::mutex> lock(clock_mutex_);
+
+    refbox_clock_.addSample(send_time, realtimeAt(dispatch_receive_time_));
+    publishClockOffset();
+}
+
+void RobotExampleROS::publishClockOffset()
+{
+    ClockEstimator::Estimate refbox = refbox_clock_.estimate();
+    ClockEstimator::Estimate benchmark = benchmark_clock_.estimate();
+
+    at_work_robot_example_ros::ClockOffsetPtr clock_offset_msg(
+                        new at_work_robot_example_ros::ClockOffset);
+
+    clock_offset_msg->stamp.data = toRosTime(realtimeAt(steadyNow()));
+    clock_offset_msg->valid.data = refbox.valid;
+    clock_offset_msg->samples.data = refbox.samples;
+    clock_offset_msg->offset.data = refbox.offset / 1e9;
+    clock_offset_msg->delay.data = refbox.delay / 1e9;
+    clock_offset_msg->jitter.data = refbox.jitter / 1e9;
+    clock_offset_msg->benchmark_running.data = benchmark.valid;
+    clock_offset_msg->benchmark_start.data = toRosTime(benchmark.offset);
+    clock_offset_msg->benchmark_jitter.data = benchmark.jitter / 1e9;
+
+    if (refbox.valid && (refbox.delay / 1e9 > clock_delay_warning_ || refbox.jitter / 1e9 > clock_jitter_warning_)) {
+        ROS_WARN_THROTTLE(10.0, "Network to the refbox degraded: %.1f ms delay, %.1f ms jitter",
+                          refbox.delay / 1e6, refbox.jitter / 1e6);
+    }
+
+    clock_offset_pub_.publish(clock_offset_msg);
+}
+
+void RobotExampleROS::handleBenchmarkState(const BenchmarkState &benchmark_state)
+{
+    {
+        //the benchmark time only advances while the benchmark is running
+        std::lock_guard<std::mutex> lock(clock_mutex_);
+
+        if (benchmark_state.state() == BenchmarkState::RUNNING) {
+            benchmark_clock_.addSample(benchmark_state.benchmark_time().sec() * 1000000000LL
+                                       + benchmark_state.benchmark_time().nsec(),
+                                       realtimeAt(dispatch_receive_time_));
+        } else {
+            benchmark_clock_.reset();
+        }
+
+        publishClockOffset();
+    }
+
+    //the benchmark time advances with every broadcast
+    exportSnapshot(shared_snapshot::BENCHMARK_STATE, benchmark_state, true);
+
+    //the refbox lists the teams whose beacons it receives
+    for (int i = 0; i < benchmark_state.connected_teams_size(); i++) {
+        if (benchmark_state.connected_teams(i) == client_config_.team_name) {
+            last_team_listed_.store(steadyNow(), std::memory_order_relaxed);
+            break;
+        }
+    }
+
+    //the benchmark time changes with every broadcast, the heartbeat covers it
+    Fingerprint fingerprint;
+    fingerprint.add(benchmark_state.state())
+               .add(benchmark_state.phase())
+               .add(benchmark_state.scenario().type())
+               .add(benchmark_state.scenario().type_id())
+               .add(benchmark_state.scenario().description());
+
+    fingerprint.add(benchmark_state.known_teams_size());
+    for (int i = 0; i < benchmark_state.known_teams_size(); i++) {
+        fingerprint.add(benchmark_state.known_teams(i));
+    }
+
+    fingerprint.add(benchmark_state.connected_teams_size());
+    for (int i = 0; i < benchmark_state.connected_teams_size(); i++) {
+        fingerprint.add(benchmark_state.connected_teams(i));
+    }
+
+    if (!benchmark_state_filter_.shouldPublish(fingerprint.value(), PublishFilter::Clock::now())) {
+        return;
+    }
+
+    at_work_robot_example_ros::BenchmarkStatePtr benchmark_state_msg(
+                        new at_work_robot_example_ros::BenchmarkState);
+
+    converters::toRos(benchmark_state, *benchmark_state_msg);
+
+    benchmark_state_pub_.publish(benchmark_state_msg);
+}
+
+void RobotExampleROS::handleDrillingMachineStatus(const DrillingMachineStatus &drill_machine_status)
+{
+    //every status counts for the running goal, also an unchanged one
+    trackDrillingMachine(drill_machine_status.state());
+
+    Fingerprint fingerprint;
+    fingerprint.add(drill_machine_status.state());
+
+    if (!drill_machine_status_filter_.shouldPublish(fingerprint.value(), PublishFilter::Clock::now())) {
+        return;
+    }
+
+    at_work_robot_example_ros::DrillingMachineStatusPtr drill_machine_msg(
+                        new at_work_robot_example_ros::DrillingMachineStatus);
+
+    converters::toRos(drill_machine_status, *drill_machine_msg);
+
+    drill_machine_status_pub_.publish(drill_machine_msg);
+}
+
+void RobotExampleROS::handleTriggeredConveyorBeltStatus(const TriggeredConveyorBeltStatus &conveyor_belt_status)
+{
+    trackConveyorBelt(conveyor_belt_status.state(), conveyor_belt_status.cycle());
+
+    Fingerprint fingerprint;
+    fingerprint.add(conveyor_belt_status.state())
+               .add(conveyor_belt_status.cycle());
+
+    if (!conveyor_belt_status_filter_.shouldPublish(fingerprint.value(), PublishFilter::Clock::now())) {
+        return;
+    }
+
+    at_work_robot_example_ros::TriggeredConveyorBeltStatusPtr conveyor_belt_status_msg(
+                        new at_work_robot_example_ros::TriggeredConveyorBeltStatus);
+
+    converters::toRos(conveyor_belt_status, *conveyor_belt_status_msg);
+
+    conveyor_belt_status_pub_.publish(conveyor_belt_status_msg);
+}
+
+void RobotExampleROS::trackDrillingMachine(uint32_t state)
+{
+    //the latency ends when the status arrived, not when it was dispatched
+    CommandTracker::Clock::time_point now(std::chrono::duration_cast<CommandTracker::Clock::duration>(
+                        std::chrono::nanoseconds(dispatch_receive_time_)));
+
+    DrillingMachineActionServer::GoalHandle goal;
+    at_work_robot_example_ros::DrillingMachineResult result;
+    at_work_robot_example_ros::DrillingMachineFeedback feedback;
+    bool succeeded;
+
+    {
+        std::lock_guard<std::mutex> lock(action_mutex_);
+
+        drilling_machine_state_ = state;
+
+        if (!drilling_machine_tracker_.active()) {
+            return;
+        }
+
+        bool down = drilling_machine_command_ == DrillingMachineCommand::MOVE_DOWN;
+        bool moving = state == static_cast<uint32_t>(down ? DrillingMachineStatus::MOVING_DOWN
+                                                          : DrillingMachineStatus::MOVING_UP);
+        bool reached = state == static_cast<uint32_t>(down ? DrillingMachineStatus::AT_BOTTOM
+                                                           : DrillingMachineStatus::AT_TOP);
+
+        goal = drilling_machine_goal_;
+        succeeded = drilling_machine_tracker_.status(moving, reached) == CommandTracker::SUCCEEDED;
+
+        if (succeeded) {
+            drilling_machine_statistics_.latency.record(
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    drilling_machine_tracker_.elapsed(now)).count());
+            ++drilling_machine_statistics_.succeeded;
+            result = drillingMachineResult(now);
+        } else {
+            feedback.state = state;
+            feedback.attempts = drilling_machine_tracker_.attempts();
+        }
+    }
+
+    //the goal handle takes the action server's lock, which is held while the goal and
+    //cancel callbacks take action_mutex_, so it must not be called with action_mutex_ held
+    if (succeeded) {
+        goal.setSucceeded(result);
+    } else {
+        goal.publishFeedback(feedback);
+    }
+}
+
+void RobotExampleROS::trackConveyorBelt(uint32_t state, uint32_t cycle)
+{
+    CommandTracker::Clock::time_point now(std::chrono::duration_cast<CommandTracker::Clock::duration>(
+                        std::chrono::nanoseconds(dispatch_receive_time_)));
+
+    ConveyorBeltActionServer::GoalHandle goal;
+    at_work_robot_example_ros::ConveyorBeltResult result;
+    at_work_robot_example_ros::ConveyorBeltFeedback feedback;
+    bool succeeded;
+
+    {
+        std::lock_guard<std::mutex> lock(action_mutex_);
+
+        conveyor_belt_status_known_ = true;
+        conveyor_belt_state_ = state;
+        conveyor_belt_cycle_ = cycle;
+
+        if (!conveyor_belt_tracker_.active()) {
+            return;
+        }
+
+        //a start is only done by the refbox counting up the cycle
+        bool reached = state == static_cast<uint32_t>(conveyor_belt_command_)
+                       && (conveyor_belt_command_ == rockin_msgs::STOP || cycle >= conveyor_belt_next_cycle_);
+
+        goal = conveyor_belt_goal_;
+        succeeded = conveyor_belt_tracker_.status(reached, reached) == CommandTracker::SUCCEEDED;
+
+        if (succeeded) {
+            conveyor_belt_statistics_.latency.record(
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    conveyor_belt_tracker_.elapsed(now)).count());
+            ++conveyor_belt_statistics_.succeeded;
+            result = conveyorBeltResult(now);
+        } else {
+            feedback.state = state;
+            feedback.cycle = cycle;
+            feedback.attempts = conveyor_belt_tracker_.attempts();
+        }
+    }
+
+    //see trackDrillingMachine
+    if (succeeded) {
+        goal.setSucceeded(result);
+    } else {
+        goal.publishFeedback(feedback);
+    }
+}
+
+void RobotExampleROS::handleInventory(const Inventory &inventory)
+{
+    transaction_sequencer_->handleInventory(inventory);
+
+    at_work_robot_example_ros::InventoryDeltaPtr inventory_delta_msg(
+                        new at_work_robot_example_ros::InventoryDelta);
+
+    bool changed = inventory_cache_.update(inventory, *inventory_delta_msg);
+
+    if (changed) {
+        order_index_.update(*inventory_delta_msg);
+        inventory_delta_pub_.publish(inventory_delta_msg);
+    }
+
+    exportSnapshot(shared_snapshot::INVENTORY, inventory, changed);
+
+    if (snapshotDue(last_inventory_snapshot_)) {
+        at_work_robot_example_ros::InventoryPtr inventory_msg(
+                            new at_work_robot_example_ros::Inventory);
+
+        inventory_cache_.snapshot(*inventory_msg);
+
+        inventory_pub_.publish(inventory_msg);
+    }
+}
+
+void RobotExampleROS::handleOrderInfo(const OrderInfo &order_info)
+{
+    at_work_robot_example_ros::OrderInfoDeltaPtr order_info_delta_msg(
+                        new at_work_robot_example_ros::OrderInfoDelta);
+
+    bool changed = order_info_cache_.update(order_info, *order_info_delta_msg);
+
+    if (changed) {
+        order_index_.update(*order_info_delta_msg);
+        order_info_delta_pub_.publish(order_info_delta_msg);
+    }
+
+    exportSnapshot(shared_snapshot::ORDER_INFO, order_info, changed);
+
+    if (snapshotDue(last_order_info_snapshot_)) {
+        at_work_robot_example_ros::OrderInfoPtr order_info_msg(
+                            new at_work_robot_example_ros::OrderInfo);
+
+        order_info_cache_.snapshot(*order_info_msg);
+
+        order_info_pub_.publish(order_info_msg);
+    }
+}
+
+void RobotExampleROS::exportSnapshot(shared_snapshot::Kind kind, const google::protobuf::Message &msg, bool changed)
+{
+    //readers poll the version, unchanged broadcasts must not bump it
+    if (!shared_snapshot_ || (!changed && shared_snapshot_->version(kind) != 0)) {
+        return;
+    }
+
+    if (!shared_snapshot_->write(kind, realtimeAt(dispatch_receive_time_), msg)) {
+        ROS_WARN_THROTTLE(10.0, "Snapshot not exported: %s, raise shared_snapshot_size",
+                          shared_snapshot_->error().c_str());
+    }
+}
+
+bool RobotExampleROS::snapshotDue(ros::WallTime &last_snapshot)
+{
+    ros::WallTime now = ros::WallTime::now();
+
+    if (!last_snapshot.isZero() && (now - last_snapshot).toSec() < full_snapshot_period_) {
+        return false;
+    }
+
+    last_snapshot = now;
+
+    return true;
+}
\ No newline at end of file
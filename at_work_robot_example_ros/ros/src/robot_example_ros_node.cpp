@@ -5,19 +5,25 @@ int main(int argc, char **argv)
 {
   ros::init(argc, argv, "robot_example_ros_node");
   ros::NodeHandle nh("~");
-  ros::Rate loop_rate(10); // one Hz
 
-  RobotExampleROS robot_example_ros(nh);
+  int spinner_threads;
+  nh.param<int>("spinner_threads", spinner_threads, 1);
 
-  ROS_INFO("CFH Robot example is running!");
+  {
+    RobotExampleROS robot_example_ros(nh);
 
-  while (ros::ok()) {
-    robot_example_ros.sendBeacon();
+    // subscriber callbacks and the beacon timer run as soon as they are due
+    ros::AsyncSpinner spinner(spinner_threads);
+    spinner.start();
 
-    ros::spinOnce();
+    ROS_INFO("CFH Robot example is running!");
 
-    loop_rate.sleep();
+    ros::waitForShutdown();
   }
 
+  // Delete all global objects allocated by libprotobuf, only done by the
+  // node because a nodelet manager may host other protobuf users
+  google::protobuf::ShutdownProtobufLibrary();
+
   return 0;
 }
\ No newline at end of file
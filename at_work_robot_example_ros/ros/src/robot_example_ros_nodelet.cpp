@@ -0,0 +1,22 @@
+#include <at_work_robot_example_ros/robot_example_ros_nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+namespace at_work_robot_example_ros
+{
+
+RobotExampleNodelet::~RobotExampleNodelet()
+{
+    // Stop the peers and the dispatch thread before the node handle goes away
+    robot_example_ros_.reset();
+}
+
+void RobotExampleNodelet::onInit()
+{
+    robot_example_ros_.reset(new RobotExampleROS(getPrivateNodeHandle()));
+
+    NODELET_INFO("CFH Robot example is running!");
+}
+
+}
+
+PLUGINLIB_EXPORT_CLASS(at_work_robot_example_ros::RobotExampleNodelet, nodelet::Nodelet)
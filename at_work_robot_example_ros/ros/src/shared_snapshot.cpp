@@ -0,0 +1,394 @@
+#include <at_work_robot_example_ros/shared_snapshot.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <sstream>
+
+namespace shared_snapshot
+{
+    /**
+     * One of the two buffers of a slot, followed by capacity bytes of
+     * payload. sequence is odd while the buffer is written.
+     */
+    struct Buffer
+    {
+        std::atomic<uint64_t> sequence;
+
+        uint64_t version;
+
+        int64_t stamp;
+
+        uint32_t size;
+
+        uint32_t reserved;
+    };
+
+    /**
+     * latest is the version of the latest complete snapshot, which is in
+     * buffer latest % 2. Padded to a cache line of its own.
+     */
+    struct Slot
+    {
+        std::atomic<uint64_t> latest;
+
+        uint64_t reserved[7];
+    };
+
+    /**
+     * Start of the segment, followed by KIND_COUNT * 2 buffers.
+     */
+    struct Segment
+    {
+        char magic[8];
+
+        uint32_t layout;
+
+        uint32_t kinds;
+
+        uint64_t capacity;
+
+        uint64_t reserved[5];
+
+        Slot slots[KIND_COUNT];
+    };
+}
+
+using shared_snapshot::Buffer;
+using shared_snapshot::Segment;
+
+namespace
+{
+    const char MAGIC[8] = {'C', 'F', 'H', 'S', 'N', 'A', 'P', '1'};
+
+    /**
+     * Changes whenever the structures above change.
+     */
+    const uint32_t LAYOUT = 1;
+
+    /**
+     * Reads give up after this many snapshots overwrote the one being read.
+     */
+    const int READ_ATTEMPTS = 4;
+
+    static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+                  "the counters must be plain 64 bit words in the segment");
+
+    size_t bufferStride(size_t capacity)
+    {
+        //each buffer starts on a cache line of its own
+        return (sizeof(Buffer) + capacity + 63) / 64 * 64;
+    }
+
+    size_t segmentSize(size_t capacity)
+    {
+        return sizeof(Segment) + shared_snapshot::KIND_COUNT * 2 * bufferStride(capacity);
+    }
+
+    Buffer *bufferAt(Segment *segment, shared_snapshot::Kind kind, uint64_t version)
+    {
+        char *buffers = reinterpret_cast<char *>(segment) + sizeof(Segment);
+
+        return reinterpret_cast<Buffer *>(buffers + (kind * 2 + version % 2) * bufferStride(segment->capacity));
+    }
+
+    const Buffer *bufferAt(const Segment *segment, shared_snapshot::Kind kind, uint64_t version)
+    {
+        return bufferAt(const_cast<Segment *>(segment), kind, version);
+    }
+
+    const char *payloadOf(const Buffer *buffer)
+    {
+        return reinterpret_cast<const char *>(buffer + 1);
+    }
+
+    /**
+     * Hand the latest snapshot of kind to consume(data, size) and check
+     * that it was not overwritten meanwhile. Returns false without a
+     * snapshot or when it was overwritten READ_ATTEMPTS times.
+     */
+    template <class Consume>
+    bool readLatest(const Segment *segment, shared_snapshot::Kind kind,
+                    shared_snapshot::Info &info, bool &consumed, Consume consume)
+    {
+        for (int attempt = 0; attempt < READ_ATTEMPTS; attempt++) {
+            uint64_t version = segment->slots[kind].latest.load(std::memory_order_acquire);
+            if (version == 0) {
+                return false;
+            }
+
+            const Buffer *buffer = bufferAt(segment, kind, version);
+
+            uint64_t sequence = buffer->sequence.load(std::memory_order_acquire);
+            if (sequence % 2 != 0) {
+                continue;
+            }
+
+            info.version = buffer->version;
+            info.stamp = buffer->stamp;
+            info.size = std::min<uint64_t>(buffer->size, segment->capacity);
+
+            consumed = consume(payloadOf(buffer), info.size);
+
+            //the payload reads must be done before the counter is checked
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (buffer->sequence.load(std::memory_order_relaxed) == sequence) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+SnapshotExport::SnapshotExport():
+    segment_(NULL),
+    segment_size_(0),
+    written_(0),
+    oversized_(0)
+{
+}
+
+SnapshotExport::~SnapshotExport()
+{
+    if (segment_) {
+        munmap(segment_, segment_size_);
+        shm_unlink(name_.c_str());
+    }
+}
+
+bool SnapshotExport::open(const std::string &name, size_t capacity)
+{
+    name_ = name;
+
+    //a segment left behind by a crashed bridge would keep its old layout
+    shm_unlink(name.c_str());
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        error_ = "cannot create " + name + ": " + strerror(errno);
+        return false;
+    }
+
+    size_t size = segmentSize(capacity);
+
+    if (ftruncate(fd, size) != 0) {
+        error_ = "cannot size " + name + ": " + strerror(errno);
+        close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (memory == MAP_FAILED) {
+        error_ = "cannot map " + name + ": " + strerror(errno);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    //the new segment is zeroed, which leaves every slot without a snapshot
+    segment_ = static_cast<Segment *>(memory);
+    segment_size_ = size;
+
+    if (!segment_->slots[0].latest.is_lock_free()) {
+        error_ = "64 bit atomics are not lock-free on this platform";
+        munmap(segment_, segment_size_);
+        segment_ = NULL;
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    segment_->layout = LAYOUT;
+    segment_->kinds = shared_snapshot::KIND_COUNT;
+    segment_->capacity = capacity;
+
+    //readers check the magic first, it goes in last
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(segment_->magic, MAGIC, sizeof(MAGIC));
+
+    return true;
+}
+
+bool SnapshotExport::write(shared_snapshot::Kind kind, int64_t stamp, const google::protobuf::Message &msg)
+{
+    if (!segment_) {
+        return false;
+    }
+
+    //ByteSize is deprecated since protobuf 3.1, older releases lack ByteSizeLong
+#if GOOGLE_PROTOBUF_VERSION >= 3001000
+    size_t size = msg.ByteSizeLong();
+#else
+    size_t size = msg.ByteSize();
+#endif
+    if (size > segment_->capacity) {
+        ++oversized_;
+        std::ostringstream error;
+        error << "a snapshot of " << size << " bytes does not fit into "
+              << segment_->capacity << " bytes";
+        error_ = error.str();
+        return false;
+    }
+
+    shared_snapshot::Slot &slot = segment_->slots[kind];
+
+    //write into the buffer readers of the latest snapshot are not in
+    uint64_t version = slot.latest.load(std::memory_order_relaxed) + 1;
+    Buffer *buffer = bufferAt(segment_, kind, version);
+
+    uint64_t sequence = buffer->sequence.load(std::memory_order_relaxed);
+    buffer->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    buffer->version = version;
+    buffer->stamp = stamp;
+    buffer->size = size;
+    msg.SerializeWithCachedSizesToArray(reinterpret_cast<google::protobuf::uint8 *>(buffer + 1));
+
+    buffer->sequence.store(sequence + 2, std::memory_order_release);
+    slot.latest.store(version, std::memory_order_release);
+
+    ++written_;
+
+    return true;
+}
+
+uint64_t SnapshotExport::version(shared_snapshot::Kind kind) const
+{
+    return segment_ ? segment_->slots[kind].latest.load(std::memory_order_relaxed) : 0;
+}
+
+unsigned long SnapshotExport::written() const
+{
+    return written_;
+}
+
+unsigned long SnapshotExport::oversized() const
+{
+    return oversized_;
+}
+
+const std::string &SnapshotExport::name() const
+{
+    return name_;
+}
+
+const std::string &SnapshotExport::error() const
+{
+    return error_;
+}
+
+SnapshotReader::SnapshotReader():
+    segment_(NULL),
+    segment_size_(0)
+{
+}
+
+SnapshotReader::~SnapshotReader()
+{
+    if (segment_) {
+        munmap(const_cast<Segment *>(segment_), segment_size_);
+    }
+}
+
+bool SnapshotReader::open(const std::string &name)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        error_ = "cannot open " + name + ": " + strerror(errno);
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(Segment)) {
+        error_ = name + " is not a snapshot segment";
+        close(fd);
+        return false;
+    }
+
+    void *memory = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (memory == MAP_FAILED) {
+        error_ = "cannot map " + name + ": " + strerror(errno);
+        return false;
+    }
+
+    const Segment *segment = static_cast<const Segment *>(memory);
+
+    bool valid = memcmp(segment->magic, MAGIC, sizeof(MAGIC)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (!valid || segment->layout != LAYOUT || segment->kinds != shared_snapshot::KIND_COUNT
+        || segmentSize(segment->capacity) != static_cast<size_t>(status.st_size)) {
+        error_ = name + " is not a snapshot segment of this layout";
+        munmap(memory, status.st_size);
+        return false;
+    }
+
+    segment_ = segment;
+    segment_size_ = status.st_size;
+
+    return true;
+}
+
+uint64_t SnapshotReader::version(shared_snapshot::Kind kind) const
+{
+    return segment_ ? segment_->slots[kind].latest.load(std::memory_order_acquire) : 0;
+}
+
+bool SnapshotReader::read(shared_snapshot::Kind kind, google::protobuf::Message &msg,
+                          shared_snapshot::Info &info)
+{
+    if (!segment_) {
+        return false;
+    }
+
+    bool parsed = false;
+    if (!readLatest(segment_, kind, info, parsed, [&msg](const char *data, size_t size) {
+            return msg.ParseFromArray(data, size);
+        })) {
+        error_ = version(kind) == 0 ? "no snapshot yet" : "the snapshot was overwritten while reading";
+        return false;
+    }
+
+    //a parse error of a snapshot which was not overwritten is not a torn read
+    if (!parsed) {
+        error_ = "the snapshot is not a message of type " + msg.GetTypeName();
+        return false;
+    }
+
+    return true;
+}
+
+bool SnapshotReader::read(shared_snapshot::Kind kind, std::string &payload,
+                          shared_snapshot::Info &info)
+{
+    if (!segment_) {
+        return false;
+    }
+
+    bool copied = false;
+    if (!readLatest(segment_, kind, info, copied, [&payload](const char *data, size_t size) {
+            payload.assign(data, size);
+            return true;
+        })) {
+        error_ = version(kind) == 0 ? "no snapshot yet" : "the snapshot was overwritten while reading";
+        return false;
+    }
+
+    return true;
+}
+
+const std::string &SnapshotReader::error() const
+{
+    return error_;
+}
@@ -0,0 +1,310 @@
+#include <at_work_robot_example_ros/snapshot_cache.h>
+
+#include <algorithm>
+
+namespace
+{
+    /**
+     * Update cached from the identifier, returns true if it differed.
+     */
+    bool assign(StringPool &pool, snapshot_cache::Object &cached, const rockin_msgs::ObjectIdentifier &object)
+    {
+        bool changed = cached.type != object.type()
+                    || cached.type_id != object.type_id()
+                    || cached.instance_id != object.instance_id();
+
+        cached.type = object.type();
+        cached.type_id = object.type_id();
+        cached.instance_id = object.instance_id();
+
+        return pool.assign(cached.description, object.description()) || changed;
+    }
+
+    bool assign(StringPool &pool, snapshot_cache::Location &cached, const rockin_msgs::LocationIdentifier &location)
+    {
+        bool changed = cached.type != location.type()
+                    || cached.instance_id != location.instance_id();
+
+        cached.type = location.type();
+        cached.instance_id = location.instance_id();
+
+        return pool.assign(cached.description, location.description()) || changed;
+    }
+
+    void toRos(const snapshot_cache::Object &cached, at_work_robot_example_ros::ObjectIdentifier &object)
+    {
+        object.type.data = cached.type;
+        object.type_id.data = cached.type_id;
+        object.instance_id.data = cached.instance_id;
+        object.description.data = *cached.description;
+    }
+
+    void toRos(const snapshot_cache::Location &cached, at_work_robot_example_ros::LocationIdentifier &location)
+    {
+        location.type.data = cached.type;
+        location.instance_id.data = cached.instance_id;
+        location.description.data = *cached.description;
+    }
+}
+
+bool snapshot_cache::ItemKey::operator<(const ItemKey &other) const
+{
+    return std::lexicographical_compare(fields, fields + 10,
+                                        other.fields, other.fields + 10);
+}
+
+snapshot_cache::ItemKey snapshot_cache::ItemKey::of(const rockin_msgs::Item &item)
+{
+    ItemKey key;
+
+    key.fields[0] = item.object().type();
+    key.fields[1] = item.object().type_id();
+    key.fields[2] = item.has_location();
+    key.fields[3] = item.location().type();
+    key.fields[4] = item.location().instance_id();
+    key.fields[5] = item.has_container();
+    key.fields[6] = item.container().type();
+    key.fields[7] = item.container().type_id();
+    key.fields[8] = item.container().instance_id();
+    key.fields[9] = item.object().instance_id();
+
+    return key;
+}
+
+snapshot_cache::ItemKey snapshot_cache::ItemKey::of(const at_work_robot_example_ros::Item &item)
+{
+    ItemKey key;
+
+    key.fields[0] = item.object.type.data;
+    key.fields[1] = item.object.type_id.data;
+    key.fields[2] = item.location.type.data != 0;
+    key.fields[3] = item.location.type.data;
+    key.fields[4] = item.location.instance_id.data;
+    key.fields[5] = item.container.type.data != 0;
+    key.fields[6] = item.container.type.data;
+    key.fields[7] = item.container.type_id.data;
+    key.fields[8] = item.container.instance_id.data;
+    key.fields[9] = item.object.instance_id.data;
+
+    return key;
+}
+
+InventoryCache::InventoryCache():
+    pool_(new StringPool),
+    generation_(0)
+{
+}
+
+InventoryCache::InventoryCache(const std::shared_ptr<StringPool> &pool):
+    pool_(pool),
+    generation_(0)
+{
+}
+
+InventoryCache::~InventoryCache()
+{
+    for (ItemMap::iterator it = items_.begin(); it != items_.end(); ++it) {
+        release(it->second);
+    }
+}
+
+bool InventoryCache::update(const rockin_msgs::Inventory &inventory,
+                            at_work_robot_example_ros::InventoryDelta &delta)
+{
+    ++generation_;
+
+    delta.added.clear();
+    delta.changed.clear();
+    delta.removed.clear();
+    broadcast_order_.clear();
+
+    for (int i = 0; i < inventory.items_size(); i++) {
+        const rockin_msgs::Item &item = inventory.items(i);
+
+        std::pair<ItemMap::iterator, bool> inserted =
+                        items_.insert(std::make_pair(snapshot_cache::ItemKey::of(item), CachedItem()));
+        CachedItem &cached = inserted.first->second;
+
+        //a new entry has no strings yet, so it always differs
+        if (assign(cached, item)) {
+            std::vector<at_work_robot_example_ros::Item> &target = inserted.second ? delta.added
+                                                                                   : delta.changed;
+            target.resize(target.size() + 1);
+            toRos(cached, target.back());
+        }
+
+        //an item listed twice keeps its first position
+        if (cached.generation != generation_) {
+            broadcast_order_.push_back(inserted.first);
+        }
+
+        cached.generation = generation_;
+    }
+
+    for (ItemMap::iterator it = items_.begin(); it != items_.end();) {
+        if (it->second.generation != generation_) {
+            delta.removed.resize(delta.removed.size() + 1);
+            toRos(it->second, delta.removed.back());
+            release(it->second);
+            items_.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+
+    return !delta.added.empty() || !delta.changed.empty() || !delta.removed.empty();
+}
+
+void InventoryCache::snapshot(at_work_robot_example_ros::Inventory &inventory) const
+{
+    inventory.items.resize(broadcast_order_.size());
+
+    for (size_t i = 0; i < broadcast_order_.size(); i++) {
+        toRos(broadcast_order_[i]->second, inventory.items[i]);
+    }
+}
+
+bool InventoryCache::assign(CachedItem &cached, const rockin_msgs::Item &item)
+{
+    bool changed = cached.quantity != item.quantity();
+
+    cached.quantity = item.quantity();
+
+    //no short-circuit, every field has to be taken over
+    changed = ::assign(*pool_, cached.object, item.object()) || changed;
+    changed = ::assign(*pool_, cached.container, item.container()) || changed;
+    changed = ::assign(*pool_, cached.location, item.location()) || changed;
+
+    return changed;
+}
+
+void InventoryCache::toRos(const CachedItem &cached, at_work_robot_example_ros::Item &item)
+{
+    ::toRos(cached.object, item.object);
+    item.quantity.data = cached.quantity;
+    ::toRos(cached.container, item.container);
+    ::toRos(cached.location, item.location);
+}
+
+void InventoryCache::release(CachedItem &cached)
+{
+    pool_->release(cached.object.description);
+    pool_->release(cached.container.description);
+    pool_->release(cached.location.description);
+}
+
+OrderInfoCache::OrderInfoCache():
+    pool_(new StringPool),
+    generation_(0)
+{
+}
+
+OrderInfoCache::OrderInfoCache(const std::shared_ptr<StringPool> &pool):
+    pool_(pool),
+    generation_(0)
+{
+}
+
+OrderInfoCache::~OrderInfoCache()
+{
+    for (OrderMap::iterator it = orders_.begin(); it != orders_.end(); ++it) {
+        release(it->second);
+    }
+}
+
+bool OrderInfoCache::update(const rockin_msgs::OrderInfo &order_info,
+                            at_work_robot_example_ros::OrderInfoDelta &delta)
+{
+    ++generation_;
+
+    delta.added.clear();
+    delta.changed.clear();
+    delta.removed.clear();
+    broadcast_order_.clear();
+
+    for (int i = 0; i < order_info.orders_size(); i++) {
+        const rockin_msgs::Order &order = order_info.orders(i);
+
+        std::pair<OrderMap::iterator, bool> inserted =
+                        orders_.insert(std::make_pair(order.id(), CachedOrder()));
+        CachedOrder &cached = inserted.first->second;
+
+        if (assign(cached, order)) {
+            std::vector<at_work_robot_example_ros::Order> &target = inserted.second ? delta.added
+                                                                                    : delta.changed;
+            target.resize(target.size() + 1);
+            toRos(cached, target.back());
+        }
+
+        if (cached.generation != generation_) {
+            broadcast_order_.push_back(inserted.first);
+        }
+
+        cached.generation = generation_;
+    }
+
+    for (OrderMap::iterator it = orders_.begin(); it != orders_.end();) {
+        if (it->second.generation != generation_) {
+            delta.removed.resize(delta.removed.size() + 1);
+            toRos(it->second, delta.removed.back());
+            release(it->second);
+            orders_.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+
+    return !delta.added.empty() || !delta.changed.empty() || !delta.removed.empty();
+}
+
+void OrderInfoCache::snapshot(at_work_robot_example_ros::OrderInfo &order_info) const
+{
+    order_info.orders.resize(broadcast_order_.size());
+
+    for (size_t i = 0; i < broadcast_order_.size(); i++) {
+        toRos(broadcast_order_[i]->second, order_info.orders[i]);
+    }
+}
+
+bool OrderInfoCache::assign(CachedOrder &cached, const rockin_msgs::Order &order)
+{
+    bool changed = cached.status != static_cast<uint64_t>(order.status())
+                || cached.quantity_delivered != order.quantity_delivered()
+                || cached.quantity_requested != order.quantity_requested();
+
+    cached.id = order.id();
+    cached.status = order.status();
+    cached.quantity_delivered = order.quantity_delivered();
+    cached.quantity_requested = order.quantity_requested();
+
+    //no short-circuit, every field has to be taken over
+    changed = ::assign(*pool_, cached.object, order.object()) || changed;
+    changed = ::assign(*pool_, cached.container, order.container()) || changed;
+    changed = ::assign(*pool_, cached.destination, order.destination()) || changed;
+    changed = ::assign(*pool_, cached.source, order.source()) || changed;
+    changed = pool_->assign(cached.processing_team, order.processing_team()) || changed;
+
+    return changed;
+}
+
+void OrderInfoCache::toRos(const CachedOrder &cached, at_work_robot_example_ros::Order &order)
+{
+    order.id.data = cached.id;
+    order.status.data = cached.status;
+    ::toRos(cached.object, order.object);
+    ::toRos(cached.container, order.container);
+    order.quantity_delivered.data = cached.quantity_delivered;
+    order.quantity_requested.data = cached.quantity_requested;
+    ::toRos(cached.destination, order.destination);
+    ::toRos(cached.source, order.source);
+    order.processing_team.data = *cached.processing_team;
+}
+
+void OrderInfoCache::release(CachedOrder &cached)
+{
+    pool_->release(cached.object.description);
+    pool_->release(cached.container.description);
+    pool_->release(cached.destination.description);
+    pool_->release(cached.source.description);
+    pool_->release(cached.processing_team);
+}
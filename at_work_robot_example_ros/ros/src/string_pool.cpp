@@ -0,0 +1,58 @@
+#include <at_work_robot_example_ros/string_pool.h>
+
+StringPool::StringPool():
+    references_(0)
+{
+}
+
+StringPool::Handle StringPool::intern(const std::string &value)
+{
+    StringMap::iterator it = strings_.insert(std::make_pair(value, 0)).first;
+
+    ++it->second;
+    ++references_;
+
+    return &it->first;
+}
+
+void StringPool::release(Handle handle)
+{
+    if (!handle) {
+        return;
+    }
+
+    StringMap::iterator it = strings_.find(*handle);
+    if (it == strings_.end() || &it->first != handle) {
+        return;
+    }
+
+    --references_;
+
+    if (--it->second == 0) {
+        strings_.erase(it);
+    }
+}
+
+bool StringPool::assign(Handle &handle, const std::string &value)
+{
+    //the common case, an unchanged string, is a compare without a lookup
+    if (handle && *handle == value) {
+        return false;
+    }
+
+    Handle previous = handle;
+    handle = intern(value);
+    release(previous);
+
+    return true;
+}
+
+size_t StringPool::size() const
+{
+    return strings_.size();
+}
+
+unsigned long StringPool::references() const
+{
+    return references_;
+}
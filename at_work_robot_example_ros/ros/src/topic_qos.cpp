@@ -0,0 +1,37 @@
+#include <at_work_robot_example_ros/topic_qos.h>
+
+#include <algorithm>
+
+RateLimiter::RateLimiter():
+    rate_(0),
+    burst_(1),
+    tokens_(1)
+{
+}
+
+void RateLimiter::configure(double rate, double burst)
+{
+    rate_ = std::max(rate, 0.0);
+    burst_ = std::max(burst, 1.0);
+    tokens_ = burst_;
+    last_ = Clock::now();
+}
+
+bool RateLimiter::tryAcquire(Clock::time_point now)
+{
+    if (rate_ == 0) {
+        return true;
+    }
+
+    double elapsed = std::chrono::duration<double>(now - last_).count();
+    last_ = now;
+
+    tokens_ = std::min(burst_, tokens_ + elapsed * rate_);
+    if (tokens_ < 1) {
+        return false;
+    }
+
+    tokens_ -= 1;
+
+    return true;
+}
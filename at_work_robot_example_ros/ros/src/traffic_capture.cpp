@@ -0,0 +1,192 @@
+#include <at_work_robot_example_ros/traffic_capture.h>
+
+#include <errno.h>
+#include <time.h>
+
+#include <cstring>
+
+namespace
+{
+    const char MAGIC[8] = {'C', 'F', 'H', 'C', 'A', 'P', 'T', '1'};
+
+    struct FileHeader
+    {
+        char magic[8];
+
+        int64_t start_time;
+    };
+
+    struct RecordHeader
+    {
+        int64_t time;
+
+        uint32_t length;
+
+        uint16_t component_id;
+
+        uint16_t msg_type;
+
+        uint8_t peer;
+
+        uint8_t reserved[7];
+    };
+}
+
+TrafficCapture::TrafficCapture():
+    file_(NULL),
+    start_time_(0),
+    count_(0)
+{
+}
+
+TrafficCapture::~TrafficCapture()
+{
+    if (file_) {
+        fclose(file_);
+    }
+}
+
+bool TrafficCapture::open(const std::string &path, int64_t start_time)
+{
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) {
+        error_ = "cannot create " + path + ": " + strerror(errno);
+        return false;
+    }
+
+    //large writes keep the dispatch thread out of the kernel
+    setvbuf(file_, NULL, _IOFBF, 1 << 20);
+
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    FileHeader header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.start_time = static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+
+    if (fwrite(&header, sizeof(header), 1, file_) != 1) {
+        error_ = "cannot write " + path + ": " + strerror(errno);
+        return false;
+    }
+
+    start_time_ = start_time;
+
+    return true;
+}
+
+bool TrafficCapture::write(traffic_capture::Peer peer, uint16_t component_id, uint16_t msg_type,
+                           int64_t receive_time, const google::protobuf::Message &msg)
+{
+    if (!file_ || !msg.SerializeToString(&buffer_)) {
+        return false;
+    }
+
+    RecordHeader header;
+    memset(&header, 0, sizeof(header));
+    header.time = receive_time - start_time_;
+    header.length = buffer_.size();
+    header.component_id = component_id;
+    header.msg_type = msg_type;
+    header.peer = peer;
+
+    if (fwrite(&header, sizeof(header), 1, file_) != 1
+        || fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size()) {
+        error_ = strerror(errno);
+        return false;
+    }
+
+    ++count_;
+
+    return true;
+}
+
+bool TrafficCapture::flush()
+{
+    if (!file_) {
+        return false;
+    }
+
+    if (fflush(file_) != 0) {
+        error_ = strerror(errno);
+        return false;
+    }
+
+    return true;
+}
+
+unsigned long TrafficCapture::count() const
+{
+    return count_;
+}
+
+const std::string &TrafficCapture::error() const
+{
+    return error_;
+}
+
+TrafficReplay::TrafficReplay():
+    file_(NULL),
+    start_time_(0)
+{
+}
+
+TrafficReplay::~TrafficReplay()
+{
+    if (file_) {
+        fclose(file_);
+    }
+}
+
+bool TrafficReplay::open(const std::string &path)
+{
+    file_ = fopen(path.c_str(), "rb");
+    if (!file_) {
+        error_ = "cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+
+    setvbuf(file_, NULL, _IOFBF, 1 << 20);
+
+    FileHeader header;
+    if (fread(&header, sizeof(header), 1, file_) != 1
+        || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        error_ = path + " is not a capture file";
+        return false;
+    }
+
+    start_time_ = header.start_time;
+
+    return true;
+}
+
+bool TrafficReplay::next(traffic_capture::Record &record)
+{
+    RecordHeader header;
+
+    if (!file_ || fread(&header, sizeof(header), 1, file_) != 1) {
+        return false;
+    }
+
+    record.time = header.time;
+    record.component_id = header.component_id;
+    record.msg_type = header.msg_type;
+    record.peer = header.peer == traffic_capture::TEAM ? traffic_capture::TEAM : traffic_capture::PUBLIC;
+    record.payload.resize(header.length);
+
+    if (header.length > 0 && fread(&record.payload[0], 1, header.length, file_) != header.length) {
+        error_ = "truncated record";
+        return false;
+    }
+
+    return true;
+}
+
+int64_t TrafficReplay::startTime() const
+{
+    return start_time_;
+}
+
+const std::string &TrafficReplay::error() const
+{
+    return error_;
+}
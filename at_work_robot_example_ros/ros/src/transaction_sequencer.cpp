@@ -0,0 +1,421 @@
+#include <at_work_robot_example_ros/transaction_sequencer.h>
+
+#include <algorithm>
+
+namespace
+{
+    bool sameObject(const rockin_msgs::ObjectIdentifier &item_object,
+                    const rockin_msgs::ObjectIdentifier &object)
+    {
+        if (item_object.type() != object.type() || item_object.type_id() != object.type_id()) {
+            return false;
+        }
+
+        //an object class matches all of its instances
+        return object.instance_id() == 0 || item_object.instance_id() == object.instance_id();
+    }
+
+    bool sameLocation(const rockin_msgs::LocationIdentifier &a,
+                      const rockin_msgs::LocationIdentifier &b)
+    {
+        return a.type() == b.type() && a.instance_id() == b.instance_id();
+    }
+
+    /**
+     * True if the objects share an instance, e.g. a class and one of its
+     * instances.
+     */
+    bool overlapping(const rockin_msgs::ObjectIdentifier &a,
+                     const rockin_msgs::ObjectIdentifier &b)
+    {
+        return sameObject(a, b) || sameObject(b, a);
+    }
+
+    /**
+     * A location whose quantity a transaction changes, sign is +1 or -1.
+     */
+    struct Change
+    {
+        const rockin_msgs::LocationIdentifier *location;
+
+        int sign;
+    };
+
+    /**
+     * Locations whose quantity the transaction changes, returns their number.
+     */
+    int changesOf(const rockin_msgs::Transaction &transaction, Change changes[2])
+    {
+        int count = 0;
+
+        if (transaction.action() != rockin_msgs::Transaction::INSERT && transaction.has_source()) {
+            changes[count].location = &transaction.source();
+            changes[count].sign = -1;
+            ++count;
+        }
+        if (transaction.action() != rockin_msgs::Transaction::REMOVE && transaction.has_destination()) {
+            changes[count].location = &transaction.destination();
+            changes[count].sign = 1;
+            ++count;
+        }
+
+        return count;
+    }
+
+    /**
+     * Amount the transaction changes a quantity by, an object instance
+     * counts once like in the inventory.
+     */
+    int64_t amountOf(const rockin_msgs::Transaction &transaction)
+    {
+        if (transaction.object().instance_id() != 0 || !transaction.has_quantity()) {
+            return 1;
+        }
+
+        return std::max<int64_t>(transaction.quantity(), 1);
+    }
+
+    /**
+     * Signed change of the quantity of object at location by the transaction.
+     */
+    int64_t changeAt(const rockin_msgs::Transaction &transaction,
+                     const rockin_msgs::ObjectIdentifier &object,
+                     const rockin_msgs::LocationIdentifier &location)
+    {
+        if (!sameObject(transaction.object(), object)) {
+            return 0;
+        }
+
+        Change changes[2];
+        int count = changesOf(transaction, changes);
+
+        int64_t change = 0;
+        for (int i = 0; i < count; i++) {
+            if (sameLocation(*changes[i].location, location)) {
+                change += changes[i].sign * amountOf(transaction);
+            }
+        }
+
+        return change;
+    }
+
+    /**
+     * Location whose quantity shows the effect of the transaction, NULL if
+     * it has none.
+     */
+    const rockin_msgs::LocationIdentifier *checkedLocation(const rockin_msgs::Transaction &transaction)
+    {
+        switch (transaction.action()) {
+            case rockin_msgs::Transaction::INSERT:
+            case rockin_msgs::Transaction::MOVE:
+                return transaction.has_destination() ? &transaction.destination() : NULL;
+            case rockin_msgs::Transaction::REMOVE:
+                return transaction.has_source() ? &transaction.source() : NULL;
+        }
+
+        return NULL;
+    }
+}
+
+TransactionSequencer::Config::Config():
+    window(8),
+    retransmit_timeout(std::chrono::milliseconds(500)),
+    max_retransmit_timeout(std::chrono::seconds(4)),
+    max_attempts(10)
+{
+}
+
+TransactionSequencer::TransactionSequencer(const Config &config, const Sender &sender):
+    config_(config),
+    sender_(sender),
+    inventory_seen_(false),
+    next_id_(1)
+{
+    statistics_.submitted = 0;
+    statistics_.sent = 0;
+    statistics_.retransmitted = 0;
+    statistics_.confirmed = 0;
+    statistics_.given_up = 0;
+    statistics_.gaps = 0;
+    statistics_.queued = 0;
+    statistics_.in_flight = 0;
+
+    if (config_.window == 0) {
+        config_.window = 1;
+    }
+}
+
+void TransactionSequencer::onSubmit(const SubmitHandler &handler)
+{
+    submit_handler_ = handler;
+}
+
+void TransactionSequencer::onCompletion(const CompletionHandler &handler)
+{
+    completion_handler_ = handler;
+}
+
+uint64_t TransactionSequencer::submit(const rockin_msgs::Transaction &transaction)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (transaction.transaction_id() != 0 && transaction.transaction_id() != next_id_) {
+        ++statistics_.gaps;
+    }
+
+    Entry &entry = enqueue(transaction);
+    entry.transaction.set_transaction_id(next_id_++);
+    ++statistics_.submitted;
+
+    if (submit_handler_) {
+        submit_handler_(entry.transaction);
+    }
+
+    return entry.transaction.transaction_id();
+}
+
+void TransactionSequencer::restore(const rockin_msgs::Transaction &transaction)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    enqueue(transaction);
+    next_id_ = std::max<uint64_t>(next_id_, transaction.transaction_id() + 1);
+    ++statistics_.submitted;
+}
+
+void TransactionSequencer::handleInventory(const rockin_msgs::Inventory &inventory)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    //only the quantities are kept, the capacity is reused between broadcasts
+    quantities_.clear();
+    for (int i = 0; i < inventory.items_size(); i++) {
+        const rockin_msgs::Item &item = inventory.items(i);
+
+        if (!item.has_location()) {
+            continue;
+        }
+
+        Quantity quantity;
+        quantity.object_type = item.object().type();
+        quantity.type_id = item.object().type_id();
+        quantity.instance_id = item.object().instance_id();
+        quantity.location_type = item.location().type();
+        quantity.location_instance_id = item.location().instance_id();
+
+        //the quantity is ignored for object instances
+        if (item.object().instance_id() != 0 || !item.has_quantity()) {
+            quantity.quantity = 1;
+        } else {
+            quantity.quantity = item.quantity();
+        }
+
+        quantities_.push_back(quantity);
+    }
+
+    inventory_seen_ = true;
+
+    //the latest confirmed transaction confirms all earlier ones
+    size_t confirmed = 0;
+    for (size_t i = in_flight_.size(); i > 0; i--) {
+        if (isConfirmed(in_flight_[i - 1])) {
+            confirmed = i;
+            break;
+        }
+    }
+
+    if (completion_handler_) {
+        for (size_t i = 0; i < confirmed; i++) {
+            completion_handler_(in_flight_[i].transaction.transaction_id(), true);
+        }
+    }
+
+    in_flight_.erase(in_flight_.begin(), in_flight_.begin() + confirmed);
+    statistics_.confirmed += confirmed;
+}
+
+void TransactionSequencer::sendCycle(Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::deque<Entry>::iterator it = in_flight_.begin();
+    while (it != in_flight_.end()) {
+        if (it->next_send > now) {
+            ++it;
+        } else if (config_.max_attempts != 0 && it->attempts >= config_.max_attempts) {
+            ++statistics_.given_up;
+            if (completion_handler_) {
+                completion_handler_(it->transaction.transaction_id(), false);
+            }
+
+            it = in_flight_.erase(it);
+
+            //later transactions no longer expect its change
+            for (std::deque<Entry>::iterator later = it; later != in_flight_.end(); ++later) {
+                later->expected = expectedQuantity(later->transaction, later - in_flight_.begin());
+            }
+        } else {
+            send(*it, now);
+            ++statistics_.retransmitted;
+            ++it;
+        }
+    }
+
+    //without an inventory there is no baseline, restored transactions may
+    //already be applied
+    if (!inventory_seen_) {
+        return;
+    }
+
+    while (in_flight_.size() < config_.window && !queued_.empty()) {
+        //later transactions wait as well, they must not overtake it
+        if (conflictsInFlight(queued_.front().transaction)) {
+            break;
+        }
+
+        queued_.front().expected = expectedQuantity(queued_.front().transaction, in_flight_.size());
+
+        in_flight_.push_back(queued_.front());
+        queued_.pop_front();
+
+        Entry &entry = in_flight_.back();
+
+        send(entry, now);
+        ++statistics_.sent;
+    }
+}
+
+uint64_t TransactionSequencer::nextTransactionId() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return next_id_;
+}
+
+void TransactionSequencer::setNextTransactionId(uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    next_id_ = std::max<uint64_t>(id, 1);
+}
+
+TransactionSequencer::Statistics TransactionSequencer::statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Statistics statistics = statistics_;
+    statistics.queued = queued_.size();
+    statistics.in_flight = in_flight_.size();
+
+    return statistics;
+}
+
+int64_t TransactionSequencer::quantityAt(const rockin_msgs::ObjectIdentifier &object,
+                                         const rockin_msgs::LocationIdentifier &location) const
+{
+    int64_t quantity = 0;
+
+    for (size_t i = 0; i < quantities_.size(); i++) {
+        const Quantity &item = quantities_[i];
+
+        if (item.location_type != location.type() || item.location_instance_id != location.instance_id()
+            || item.object_type != object.type() || item.type_id != object.type_id()) {
+            continue;
+        }
+
+        //an object class matches all of its instances
+        if (object.instance_id() == 0 || item.instance_id == object.instance_id()) {
+            quantity += item.quantity;
+        }
+    }
+
+    return quantity;
+}
+
+int64_t TransactionSequencer::expectedQuantity(const rockin_msgs::Transaction &transaction,
+                                               size_t earlier) const
+{
+    const rockin_msgs::LocationIdentifier *location = checkedLocation(transaction);
+    if (!location) {
+        return 0;
+    }
+
+    //transactions in flight are not in the inventory yet, or they would be confirmed;
+    //a REMOVE from an empty location leaves it empty, so no quantity drops below zero
+    int64_t expected = quantityAt(transaction.object(), *location);
+
+    for (size_t i = 0; i < earlier; i++) {
+        expected = std::max<int64_t>(expected + changeAt(in_flight_[i].transaction,
+                                                         transaction.object(), *location), 0);
+    }
+
+    return std::max<int64_t>(expected + changeAt(transaction, transaction.object(), *location), 0);
+}
+
+bool TransactionSequencer::conflictsInFlight(const rockin_msgs::Transaction &transaction) const
+{
+    Change changes[2];
+    int count = changesOf(transaction, changes);
+
+    for (size_t i = 0; i < in_flight_.size(); i++) {
+        const rockin_msgs::Transaction &other = in_flight_[i].transaction;
+
+        if (!overlapping(transaction.object(), other.object())) {
+            continue;
+        }
+
+        Change other_changes[2];
+        int other_count = changesOf(other, other_changes);
+
+        for (int j = 0; j < count; j++) {
+            for (int k = 0; k < other_count; k++) {
+                if (changes[j].sign != other_changes[k].sign
+                    && sameLocation(*changes[j].location, *other_changes[k].location)) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+bool TransactionSequencer::isConfirmed(const Entry &entry) const
+{
+    const rockin_msgs::Transaction &transaction = entry.transaction;
+
+    const rockin_msgs::LocationIdentifier *location = checkedLocation(transaction);
+    if (!location) {
+        return false;
+    }
+
+    int64_t quantity = quantityAt(transaction.object(), *location);
+
+    if (transaction.action() == rockin_msgs::Transaction::REMOVE) {
+        return quantity <= entry.expected;
+    }
+
+    return quantity >= entry.expected;
+}
+
+TransactionSequencer::Entry &TransactionSequencer::enqueue(const rockin_msgs::Transaction &transaction)
+{
+    queued_.push_back(Entry());
+
+    Entry &entry = queued_.back();
+    entry.transaction.CopyFrom(transaction);
+    entry.expected = 0;
+    entry.attempts = 0;
+    entry.timeout = config_.retransmit_timeout;
+
+    return entry;
+}
+
+void TransactionSequencer::send(Entry &entry, Clock::time_point now)
+{
+    sender_(entry.transaction);
+
+    ++entry.attempts;
+    entry.next_send = now + entry.timeout;
+    entry.timeout = std::min(entry.timeout * 2, config_.max_retransmit_timeout);
+}